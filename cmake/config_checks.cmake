@@ -40,6 +40,12 @@ set( HAVE_GTS       ${GTS_FOUND}        )
 if(with_zlib)
   set(HAVE_LIBZ 1)
 endif()
+if(with_zstd)
+  set(HAVE_ZSTD 1)
+endif()
+if(CMAKE_USE_PTHREADS_INIT)
+  set(HAVE_PTHREAD 1)
+endif()
 set(HAVE_LASI       ${LASI_FOUND}      )
 set(HAVE_PANGOCAIRO ${PANGOCAIRO_FOUND})
 set(HAVE_POPPLER    ${POPPLER_FOUND}   )
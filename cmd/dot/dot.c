@@ -63,6 +63,9 @@ int main(int argc, char **argv)
 	    gvLayoutJobs(Gvc, G);  /* take layout engine from command line */
 	    gvRenderJobs(Gvc, G);
     }
+    else if ((r = gvPipelineJobs(Gvc)) >= 0) {
+	rc = r;
+    }
     else {
 	while ((G = gvNextInputGraph(Gvc))) {
 	    if (prev) {
@@ -0,0 +1,807 @@
+/**
+ * @file
+ * @brief implements @ref agwritebin, @ref agreadbin and @ref agmemreadbin
+ *
+ * A compact, versioned binary serialization of a graph, intended for caching
+ * graphs (typically laid out ones) that are loaded again many times. Loading
+ * it avoids lexing and canonicalizing DOT text: every distinct string is
+ * stored once and interned once, and objects refer to strings and to each
+ * other by integer index.
+ *
+ * All integers are unsigned LEB128 varints. Signed quantities are zigzag
+ * encoded. A string index (“sid”) of 0 means “no string”, otherwise it is
+ * 1 + the position of the string in the string table.
+ *
+ * @code
+ * magic       8 bytes, AGBIN_MAGIC
+ * version     AGBIN_VERSION
+ * size        number of payload bytes that follow
+ * payload:
+ *   flags     bit 0 directed, bit 1 strict, bit 2 no loops
+ *   strings   count, count × (length << 1 | is HTML, bytes, NUL)
+ *   name      sid of the root graph
+ *   symbols   for graph, node and edge kinds in turn:
+ *               count, count × (sid name, sid default, flags)
+ *               where flags is bit 0 print, bit 1 fixed
+ *   nodes     count, count × sid name
+ *   edges     count, count × (zigzag(tail - previous tail),
+ *                             zigzag(head - tail), sid key)
+ *   columns   for node and edge kinds in turn, for each of their symbols:
+ *               0 (all default)
+ *               | 1 (sparse), count, count × (index delta, sid value)
+ *               | 2 (dense), one sid value per object
+ *   graph     root graph record:
+ *               local symbols: count, count × (kind, symbol, sid default,
+ *                                              flags)
+ *               values: count, count × (symbol delta, sid value)
+ *               nodes: count, count × node index delta
+ *               edges: count, count × edge index delta
+ *               subgraphs: count, count × (sid name, graph record)
+ * @endcode
+ *
+ * Nodes and edges are stored in creation (sequence) order and recreated in
+ * that order, so a graph read back is written by @ref agwrite exactly as
+ * the original was.
+ *
+ * @ingroup cgraph_graph
+ */
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
+#include <assert.h>
+#include <cgraph/cghdr.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// the three attribute kinds, in the order they are stored
+static const int Kinds[] = {AGRAPH, AGNODE, AGEDGE};
+enum { KINDS = sizeof(Kinds) / sizeof(Kinds[0]) };
+
+enum { COLUMN_DEFAULT = 0, COLUMN_SPARSE = 1, COLUMN_DENSE = 2 };
+
+static Dict_t *dict_of(Agraph_t *g, int kind) {
+  Agdatadict_t *dd = agdatadict(g, false);
+  if (dd == NULL)
+    return NULL;
+  switch (kind) {
+  case AGRAPH:
+    return dd->dict.g;
+  case AGNODE:
+    return dd->dict.n;
+  default:
+    return dd->dict.e;
+  }
+}
+
+static int cmp_seq(const void *a, const void *b) {
+  const Agobj_t *const *x = a;
+  const Agobj_t *const *y = b;
+  if (AGSEQ(*x) < AGSEQ(*y))
+    return -1;
+  if (AGSEQ(*x) > AGSEQ(*y))
+    return 1;
+  return 0;
+}
+
+static int cmp_size(const void *a, const void *b) {
+  const size_t *x = a;
+  const size_t *y = b;
+  if (*x < *y)
+    return -1;
+  if (*x > *y)
+    return 1;
+  return 0;
+}
+
+/// position of an object within a sequence-ordered array
+static size_t seq_index(void **objs, size_t n, void *obj) {
+  size_t lo = 0;
+  size_t hi = n;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (AGSEQ(objs[mid]) < AGSEQ(obj)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  assert(lo < n && objs[lo] == obj);
+  return lo;
+}
+
+static void put_varint(agxbuf *xb, uint64_t v) {
+  char buf[10];
+  size_t len = 0;
+  do {
+    unsigned char byte = v & 0x7f;
+    v >>= 7;
+    if (v != 0)
+      byte |= 0x80;
+    buf[len++] = (char)byte;
+  } while (v != 0);
+  agxbput_n(xb, buf, len);
+}
+
+static uint64_t zigzag(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/*************************** writing ****************************************/
+
+/// string table under construction, keyed by refstr identity
+typedef struct {
+  const char **slots; ///< hash table of strings
+  size_t *ids;        ///< sid of each slot
+  size_t capacity;    ///< number of slots, a power of 2
+  const char **strs;  ///< strings in sid order
+  size_t size;
+} strtab_t;
+
+static size_t strtab_hash(const char *s, size_t capacity) {
+  return (size_t)(((uintptr_t)s >> 3) * 0x9e3779b97f4a7c15ull) &
+         (capacity - 1);
+}
+
+static void strtab_grow(strtab_t *st) {
+  const size_t capacity = st->capacity == 0 ? 1024 : st->capacity * 2;
+  const char **slots = gv_calloc(capacity, sizeof(slots[0]));
+  size_t *ids = gv_calloc(capacity, sizeof(ids[0]));
+  for (size_t i = 0; i < st->capacity; ++i) {
+    if (st->slots[i] == NULL)
+      continue;
+    size_t j = strtab_hash(st->slots[i], capacity);
+    while (slots[j] != NULL)
+      j = (j + 1) & (capacity - 1);
+    slots[j] = st->slots[i];
+    ids[j] = st->ids[i];
+  }
+  free(st->slots);
+  free(st->ids);
+  st->slots = slots;
+  st->ids = ids;
+  st->strs = gv_recalloc(st->strs, st->capacity / 2, capacity / 2,
+                         sizeof(st->strs[0]));
+  st->capacity = capacity;
+}
+
+/// sid of a refstr, adding it to the table if necessary
+static size_t strtab_id(strtab_t *st, const char *s) {
+  if (s == NULL)
+    return 0;
+  if (st->size >= st->capacity / 2)
+    strtab_grow(st);
+  size_t i = strtab_hash(s, st->capacity);
+  while (st->slots[i] != NULL) {
+    if (st->slots[i] == s)
+      return st->ids[i];
+    i = (i + 1) & (st->capacity - 1);
+  }
+  st->slots[i] = s;
+  st->strs[st->size] = s;
+  st->ids[i] = ++st->size;
+  return st->ids[i];
+}
+
+static void strtab_free(strtab_t *st) {
+  free(st->slots);
+  free(st->ids);
+  free(st->strs);
+}
+
+typedef struct {
+  Agraph_t *root;
+  strtab_t strs;
+  agxbuf body;
+  void **nodes; ///< nodes in sequence order
+  size_t n_nodes;
+  void **edges; ///< edges in sequence order
+  size_t n_edges;
+  Agsym_t **gsyms; ///< root graph symbols by id
+  size_t n_gsyms;
+} writer_t;
+
+/// sid of an object name, with internally generated names written as none
+static size_t name_id(writer_t *w, char *name) {
+  if (name == NULL || name[0] == LOCALNAMEPREFIX)
+    return 0;
+  // names may come from a static buffer rather than being refstrs
+  return strtab_id(&w->strs, agstrbind(w->root, name));
+}
+
+static void put_sid(writer_t *w, const char *s) {
+  put_varint(&w->body, strtab_id(&w->strs, s));
+}
+
+static unsigned sym_flags(const Agsym_t *sym) {
+  return (sym->print ? 1u : 0u) | (sym->fixed ? 2u : 0u);
+}
+
+static void write_column(writer_t *w, Agsym_t *sym, void **objs, size_t n) {
+  size_t changed = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (agattrrec(objs[i])->str[sym->id] != sym->defval)
+      ++changed;
+  }
+
+  if (changed == 0) {
+    put_varint(&w->body, COLUMN_DEFAULT);
+  } else if (changed * 2 < n) {
+    put_varint(&w->body, COLUMN_SPARSE);
+    put_varint(&w->body, changed);
+    size_t prev = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const char *value = agattrrec(objs[i])->str[sym->id];
+      if (value != sym->defval) {
+        put_varint(&w->body, i - prev);
+        put_sid(w, value);
+        prev = i;
+      }
+    }
+  } else {
+    put_varint(&w->body, COLUMN_DENSE);
+    for (size_t i = 0; i < n; ++i)
+      put_sid(w, agattrrec(objs[i])->str[sym->id]);
+  }
+}
+
+static void write_members(writer_t *w, size_t *indices, size_t n) {
+  qsort(indices, n, sizeof(indices[0]), cmp_size);
+  put_varint(&w->body, n);
+  size_t prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    put_varint(&w->body, indices[i] - prev);
+    prev = indices[i];
+  }
+}
+
+static void write_graph(writer_t *w, Agraph_t *g) {
+  // symbols defined locally in a subgraph; the root’s were written up front
+  agxbuf locals = {0};
+  size_t n_locals = 0;
+  if (g != w->root) {
+    for (size_t k = 0; k < KINDS; ++k) {
+      Dict_t *dict = dict_of(g, Kinds[k]);
+      Dict_t *view = dtview(dict, NULL);
+      for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym)) {
+        put_varint(&locals, k);
+        put_varint(&locals, (uint64_t)sym->id);
+        put_varint(&locals, strtab_id(&w->strs, sym->defval));
+        put_varint(&locals, sym_flags(sym));
+        ++n_locals;
+      }
+      dtview(dict, view);
+    }
+  }
+  put_varint(&w->body, n_locals);
+  agxbput_n(&w->body, agxbuse(&locals), agxblen(&locals));
+  agxbfree(&locals);
+
+  // graph attribute values differing from the root defaults
+  Agattr_t *data = agattrrec(g);
+  size_t n_values = 0;
+  for (size_t id = 0; id < w->n_gsyms; ++id) {
+    if (data->str[id] != w->gsyms[id]->defval)
+      ++n_values;
+  }
+  put_varint(&w->body, n_values);
+  for (size_t id = 0, prev = 0; id < w->n_gsyms; ++id) {
+    if (data->str[id] == w->gsyms[id]->defval)
+      continue;
+    put_varint(&w->body, id - prev);
+    put_sid(w, data->str[id]);
+    prev = id;
+  }
+
+  // members
+  if (g == w->root) {
+    put_varint(&w->body, 0);
+    put_varint(&w->body, 0);
+  } else {
+    size_t n = (size_t)agnnodes(g);
+    size_t *indices = gv_calloc(n, sizeof(indices[0]));
+    size_t i = 0;
+    for (Agnode_t *v = agfstnode(g); v; v = agnxtnode(g, v))
+      indices[i++] = seq_index(w->nodes, w->n_nodes, v);
+    write_members(w, indices, n);
+    free(indices);
+
+    n = (size_t)agnedges(g);
+    indices = gv_calloc(n, sizeof(indices[0]));
+    i = 0;
+    for (Agnode_t *v = agfstnode(g); v; v = agnxtnode(g, v)) {
+      for (Agedge_t *e = agfstout(g, v); e; e = agnxtout(g, e))
+        indices[i++] = seq_index(w->edges, w->n_edges, e);
+    }
+    write_members(w, indices, i);
+    free(indices);
+  }
+
+  put_varint(&w->body, (uint64_t)agnsubg(g));
+  for (Agraph_t *subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
+    put_varint(&w->body, name_id(w, agnameof(subg)));
+    write_graph(w, subg);
+  }
+}
+
+/// the root’s symbols of the given kind, indexed by id
+static Agsym_t **symbols(Agraph_t *root, int kind, size_t *n) {
+  Dict_t *dict = dict_of(root, kind);
+  *n = dict ? (size_t)dtsize(dict) : 0;
+  Agsym_t **syms = gv_calloc(*n, sizeof(syms[0]));
+  if (dict) {
+    for (Agsym_t *sym = dtfirst(dict); sym; sym = dtnext(dict, sym))
+      syms[sym->id] = sym;
+  }
+  return syms;
+}
+
+int agwritebin(Agraph_t *g, void *chan,
+               size_t (*write)(void *chan, const char *buf, size_t size)) {
+  writer_t w = {.root = g};
+
+  w.n_nodes = (size_t)agnnodes(g);
+  w.nodes = gv_calloc(w.n_nodes, sizeof(w.nodes[0]));
+  w.n_edges = (size_t)agnedges(g);
+  w.edges = gv_calloc(w.n_edges, sizeof(w.edges[0]));
+  {
+    size_t i = 0;
+    size_t j = 0;
+    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+      w.nodes[i++] = n;
+      for (Agedge_t *e = agfstout(g, n); e; e = agnxtout(g, e))
+        w.edges[j++] = e;
+    }
+    // nodes come out of the root in sequence order, edges only per node
+    qsort(w.edges, w.n_edges, sizeof(w.edges[0]), cmp_seq);
+  }
+
+  put_varint(&w.body, name_id(&w, agnameof(g)));
+
+  Agsym_t **syms[KINDS];
+  size_t n_syms[KINDS];
+  for (size_t k = 0; k < KINDS; ++k) {
+    syms[k] = symbols(g, Kinds[k], &n_syms[k]);
+    put_varint(&w.body, n_syms[k]);
+    for (size_t i = 0; i < n_syms[k]; ++i) {
+      put_sid(&w, syms[k][i]->name);
+      put_sid(&w, syms[k][i]->defval);
+      put_varint(&w.body, sym_flags(syms[k][i]));
+    }
+  }
+
+  put_varint(&w.body, w.n_nodes);
+  for (size_t i = 0; i < w.n_nodes; ++i)
+    put_varint(&w.body, name_id(&w, agnameof(w.nodes[i])));
+
+  put_varint(&w.body, w.n_edges);
+  size_t prev_tail = 0;
+  for (size_t i = 0; i < w.n_edges; ++i) {
+    Agedge_t *e = w.edges[i];
+    const size_t tail = seq_index(w.nodes, w.n_nodes, agtail(e));
+    const size_t head = seq_index(w.nodes, w.n_nodes, aghead(e));
+    put_varint(&w.body, zigzag((int64_t)tail - (int64_t)prev_tail));
+    put_varint(&w.body, zigzag((int64_t)head - (int64_t)tail));
+    put_varint(&w.body, name_id(&w, agnameof(e)));
+    prev_tail = tail;
+  }
+
+  w.gsyms = syms[0];
+  w.n_gsyms = n_syms[0];
+  for (size_t i = 0; i < n_syms[1]; ++i)
+    write_column(&w, syms[1][i], w.nodes, w.n_nodes);
+  for (size_t i = 0; i < n_syms[2]; ++i)
+    write_column(&w, syms[2][i], w.edges, w.n_edges);
+
+  write_graph(&w, g);
+
+  // now that all strings are known, assemble the payload prefix
+  agxbuf head = {0};
+  put_varint(&head, (agisdirected(g) ? 1u : 0u) | (agisstrict(g) ? 2u : 0u) |
+                        (g->desc.no_loop ? 4u : 0u));
+  put_varint(&head, w.strs.size);
+  for (size_t i = 0; i < w.strs.size; ++i) {
+    const char *s = w.strs.strs[i];
+    const size_t len = strlen(s);
+    put_varint(&head, (uint64_t)len << 1 | (aghtmlstr(s) ? 1u : 0u));
+    agxbput_n(&head, s, len + 1);
+  }
+
+  agxbuf hdr = {0};
+  agxbput_n(&hdr, AGBIN_MAGIC, sizeof(AGBIN_MAGIC) - 1);
+  put_varint(&hdr, AGBIN_VERSION);
+  put_varint(&hdr, agxblen(&head) + agxblen(&w.body));
+
+  int rc = 0;
+  agxbuf *parts[] = {&hdr, &head, &w.body};
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+    const size_t len = agxblen(parts[i]);
+    if (write(chan, agxbuse(parts[i]), len) != len) {
+      rc = EOF;
+      break;
+    }
+  }
+
+  agxbfree(&hdr);
+  agxbfree(&head);
+  agxbfree(&w.body);
+  for (size_t k = 0; k < KINDS; ++k)
+    free(syms[k]);
+  free(w.nodes);
+  free(w.edges);
+  strtab_free(&w.strs);
+  return rc;
+}
+
+/*************************** reading ****************************************/
+
+typedef struct {
+  const unsigned char *p;   ///< read cursor
+  const unsigned char *end; ///< end of payload
+  bool error;               ///< has malformed input been seen?
+  Agraph_t *root;
+  char **strs; ///< interned strings by sid - 1
+  size_t n_strs;
+  Agsym_t **syms[KINDS]; ///< symbols by stored index
+  size_t n_syms[KINDS];
+  Agnode_t **nodes;
+  size_t n_nodes;
+  Agedge_t **edges;
+  size_t n_edges;
+} reader_t;
+
+static uint64_t get_varint(reader_t *r) {
+  uint64_t v = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (r->p >= r->end)
+      break;
+    const unsigned char byte = *r->p++;
+    v |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return v;
+  }
+  r->error = true;
+  return 0;
+}
+
+/// read a count of items, each taking at least one byte
+static size_t get_count(reader_t *r) {
+  const uint64_t n = get_varint(r);
+  if (n > (uint64_t)(r->end - r->p)) {
+    r->error = true;
+    return 0;
+  }
+  return (size_t)n;
+}
+
+/// read an index that must be less than `limit`
+static size_t get_index(reader_t *r, size_t base, size_t limit) {
+  const uint64_t v = get_varint(r);
+  if (v >= limit || base >= limit - v) {
+    r->error = true;
+    return 0;
+  }
+  return base + (size_t)v;
+}
+
+static char *get_str(reader_t *r) {
+  const uint64_t sid = get_varint(r);
+  if (sid > r->n_strs) {
+    r->error = true;
+    return NULL;
+  }
+  return sid == 0 ? NULL : r->strs[sid - 1];
+}
+
+/// a string that must be present, e.g. an attribute value
+static char *get_value(reader_t *r) {
+  char *s = get_str(r);
+  if (s == NULL) {
+    r->error = true;
+    return "";
+  }
+  return s;
+}
+
+static void set_flags(Agsym_t *sym, uint64_t flags) {
+  sym->print = (flags & 1) != 0;
+  sym->fixed = (flags & 2) != 0;
+}
+
+static void read_column(reader_t *r, Agsym_t *sym, void **objs, size_t n) {
+  switch (get_varint(r)) {
+  case COLUMN_DEFAULT:
+    break;
+  case COLUMN_SPARSE: {
+    const size_t count = get_count(r);
+    for (size_t i = 0, index = 0; i < count && !r->error; ++i) {
+      index = get_index(r, index, n);
+      char *value = get_value(r);
+      if (!r->error)
+        agxset(objs[index], sym, value);
+    }
+    break;
+  }
+  case COLUMN_DENSE:
+    for (size_t i = 0; i < n && !r->error; ++i) {
+      char *value = get_value(r);
+      if (!r->error && value != agattrrec(objs[i])->str[sym->id])
+        agxset(objs[i], sym, value);
+    }
+    break;
+  default:
+    r->error = true;
+    break;
+  }
+}
+
+static void read_graph(reader_t *r, Agraph_t *g, int depth) {
+  if (depth > 10000) { // refuse pathological nesting
+    r->error = true;
+    return;
+  }
+
+  const size_t n_locals = get_count(r);
+  for (size_t i = 0; i < n_locals && !r->error; ++i) {
+    const size_t k = get_index(r, 0, KINDS);
+    if (r->error)
+      break;
+    const size_t id = get_index(r, 0, r->n_syms[k]);
+    char *def = get_value(r);
+    const uint64_t flags = get_varint(r);
+    if (r->error)
+      break;
+    Agsym_t *sym = agattr(g, Kinds[k], r->syms[k][id]->name, def);
+    set_flags(sym, flags);
+  }
+
+  const size_t n_values = get_count(r);
+  for (size_t i = 0, id = 0; i < n_values && !r->error; ++i) {
+    id = get_index(r, id, r->n_syms[0]);
+    char *value = get_value(r);
+    // values inherited from the parent must not become local definitions
+    if (!r->error && agxget(g, r->syms[0][id]) != value)
+      agxset(g, r->syms[0][id], value);
+  }
+
+  const size_t n_nodes = get_count(r);
+  for (size_t i = 0, index = 0; i < n_nodes && !r->error; ++i) {
+    index = get_index(r, index, r->n_nodes);
+    if (!r->error)
+      agsubnode(g, r->nodes[index], 1);
+  }
+
+  const size_t n_edges = get_count(r);
+  for (size_t i = 0, index = 0; i < n_edges && !r->error; ++i) {
+    index = get_index(r, index, r->n_edges);
+    if (!r->error)
+      agsubedge(g, r->edges[index], 1);
+  }
+
+  const size_t n_subgs = get_count(r);
+  for (size_t i = 0; i < n_subgs && !r->error; ++i) {
+    char *name = get_str(r);
+    if (r->error)
+      break;
+    Agraph_t *subg = agsubg(g, name, 1);
+    read_graph(r, subg, depth + 1);
+  }
+}
+
+static Agraph_t *read_payload(const char *data, size_t size, Agdisc_t *disc) {
+  reader_t r = {.p = (const unsigned char *)data,
+                .end = (const unsigned char *)data + size};
+
+  const uint64_t flags = get_varint(&r);
+  Agdesc_t desc = {.directed = (flags & 1) != 0,
+                   .strict = (flags & 2) != 0,
+                   .no_loop = (flags & 4) != 0,
+                   .maingraph = true};
+
+  // the string table is NUL terminated in place, so strings are interned
+  // straight out of the input
+  r.n_strs = get_count(&r);
+  const char **raw = gv_calloc(r.n_strs, sizeof(raw[0]));
+  bool *html = gv_calloc(r.n_strs, sizeof(html[0]));
+  for (size_t i = 0; i < r.n_strs && !r.error; ++i) {
+    const uint64_t v = get_varint(&r);
+    const uint64_t len = v >> 1;
+    if (len >= (uint64_t)(r.end - r.p) || r.p[len] != '\0') {
+      r.error = true;
+      break;
+    }
+    raw[i] = (const char *)r.p;
+    html[i] = (v & 1) != 0;
+    r.p += len + 1;
+  }
+
+  char *name = NULL;
+  if (!r.error) {
+    const uint64_t sid = get_varint(&r);
+    if (sid > r.n_strs)
+      r.error = true;
+    else if (sid != 0)
+      name = (char *)raw[sid - 1];
+  }
+  if (r.error) {
+    free(raw);
+    free(html);
+    agerrorf("malformed binary graph\n");
+    return NULL;
+  }
+
+  r.root = agopen(name, desc, disc);
+  r.strs = gv_calloc(r.n_strs, sizeof(r.strs[0]));
+  for (size_t i = 0; i < r.n_strs; ++i)
+    r.strs[i] = html[i] ? agstrdup_html(r.root, raw[i])
+                        : agstrdup(r.root, raw[i]);
+  free(raw);
+  free(html);
+
+  for (size_t k = 0; k < KINDS && !r.error; ++k) {
+    r.n_syms[k] = get_count(&r);
+    r.syms[k] = gv_calloc(r.n_syms[k], sizeof(r.syms[k][0]));
+    for (size_t i = 0; i < r.n_syms[k] && !r.error; ++i) {
+      char *sym_name = get_value(&r);
+      char *def = get_value(&r);
+      const uint64_t sym_flags = get_varint(&r);
+      if (r.error)
+        break;
+      r.syms[k][i] = agattr(r.root, Kinds[k], sym_name, def);
+      set_flags(r.syms[k][i], sym_flags);
+    }
+  }
+
+  if (!r.error) {
+    r.n_nodes = get_count(&r);
+    r.nodes = gv_calloc(r.n_nodes, sizeof(r.nodes[0]));
+    for (size_t i = 0; i < r.n_nodes && !r.error; ++i) {
+      char *node_name = get_str(&r);
+      if (!r.error)
+        r.nodes[i] = agnode(r.root, node_name, 1);
+    }
+  }
+
+  if (!r.error) {
+    r.n_edges = get_count(&r);
+    r.edges = gv_calloc(r.n_edges, sizeof(r.edges[0]));
+    int64_t tail = 0;
+    for (size_t i = 0; i < r.n_edges && !r.error; ++i) {
+      tail += unzigzag(get_varint(&r));
+      const int64_t head = tail + unzigzag(get_varint(&r));
+      char *key = get_str(&r);
+      if (tail < 0 || (uint64_t)tail >= r.n_nodes || head < 0 ||
+          (uint64_t)head >= r.n_nodes) {
+        r.error = true;
+        break;
+      }
+      if (!r.error)
+        r.edges[i] =
+            agedge(r.root, r.nodes[tail], r.nodes[head], key, 1);
+      if (r.edges[i] == NULL)
+        r.error = true;
+    }
+  }
+
+  for (size_t i = 0; i < r.n_syms[1] && !r.error; ++i)
+    read_column(&r, r.syms[1][i], (void **)r.nodes, r.n_nodes);
+  for (size_t i = 0; i < r.n_syms[2] && !r.error; ++i)
+    read_column(&r, r.syms[2][i], (void **)r.edges, r.n_edges);
+
+  if (!r.error)
+    read_graph(&r, r.root, 0);
+
+  for (size_t i = 0; i < r.n_strs; ++i)
+    agstrfree(r.root, r.strs[i]);
+  free(r.strs);
+  for (size_t k = 0; k < KINDS; ++k)
+    free(r.syms[k]);
+  free(r.nodes);
+  free(r.edges);
+
+  if (r.error) {
+    agerrorf("malformed binary graph\n");
+    agclose(r.root);
+    return NULL;
+  }
+  return r.root;
+}
+
+/// read the header, returning the payload size or -1 on failure
+static int64_t read_header(int (*next)(void *ctx), void *ctx) {
+  for (size_t i = 0; i < sizeof(AGBIN_MAGIC) - 1; ++i) {
+    if (next(ctx) != (unsigned char)AGBIN_MAGIC[i]) {
+      agerrorf("not a binary graph\n");
+      return -1;
+    }
+  }
+
+  uint64_t fields[2] = {0};
+  for (size_t f = 0; f < 2; ++f) {
+    int c;
+    unsigned shift = 0;
+    do {
+      if ((c = next(ctx)) == EOF || shift >= 64) {
+        agerrorf("malformed binary graph\n");
+        return -1;
+      }
+      fields[f] |= (uint64_t)(c & 0x7f) << shift;
+      shift += 7;
+    } while (c & 0x80);
+  }
+
+  if (fields[0] != AGBIN_VERSION) {
+    agerrorf("unsupported binary graph version %llu\n",
+             (unsigned long long)fields[0]);
+    return -1;
+  }
+  if (fields[1] > INT64_MAX || fields[1] > SIZE_MAX) {
+    agerrorf("malformed binary graph\n");
+    return -1;
+  }
+  return (int64_t)fields[1];
+}
+
+static int next_file(void *ctx) { return getc(ctx); }
+
+typedef struct {
+  const unsigned char *p;
+  const unsigned char *end;
+} memcur_t;
+
+static int next_mem(void *ctx) {
+  memcur_t *m = ctx;
+  return m->p < m->end ? *m->p++ : EOF;
+}
+
+Agraph_t *agreadbin(FILE *fp, Agdisc_t *disc) {
+  // at the end of input, quietly return no graph as agread does
+  const int c = getc(fp);
+  if (c == EOF)
+    return NULL;
+  ungetc(c, fp);
+
+  const int64_t size = read_header(next_file, fp);
+  if (size < 0)
+    return NULL;
+
+  char *data = gv_alloc((size_t)size + 1);
+  if (fread(data, 1, (size_t)size, fp) != (size_t)size) {
+    agerrorf("truncated binary graph\n");
+    free(data);
+    return NULL;
+  }
+  Agraph_t *g = read_payload(data, (size_t)size, disc);
+  free(data);
+  return g;
+}
+
+Agraph_t *agmemreadbin(const char *data, size_t size, Agdisc_t *disc) {
+  memcur_t m = {.p = (const unsigned char *)data,
+                .end = (const unsigned char *)data + size};
+  const int64_t payload = read_header(next_mem, &m);
+  if (payload < 0)
+    return NULL;
+  if ((uint64_t)payload > (uint64_t)(m.end - m.p)) {
+    agerrorf("truncated binary graph\n");
+    return NULL;
+  }
+  return read_payload((const char *)m.p, (size_t)payload, disc);
+}
@@ -74,6 +74,15 @@ int agstrclose(Agraph_t * g);
 	/* ref string management */
 void agmarkhtmlstr(char *s);
 
+/// what @ref agstrcanon is known to do with a reference counted string
+typedef enum {
+  AGSTR_CANON_UNKNOWN, ///< not yet determined
+  AGSTR_CANON_ID,      ///< printed as is, without quoting
+  AGSTR_CANON_QUOTED,  ///< needs quoting or escaping
+} agstrcanon_t;
+agstrcanon_t agstrcanonhint(const char *s);
+void agsetstrcanonhint(const char *s, agstrcanon_t hint);
+
 /// Mask of `Agtag_s.seq` width
 enum { SEQ_MASK = (1 << (sizeof(unsigned) * 8 - 4)) - 1 };
 
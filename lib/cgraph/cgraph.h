@@ -452,6 +452,31 @@ CGRAPH_API Agraph_t *agconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
  */
 
 CGRAPH_API int agwrite(Agraph_t * g, void *chan);
+
+/// leading bytes of the binary graph format written by @ref agwritebin
+#define AGBIN_MAGIC "\x89GVB\r\n\x1a\n"
+/// revision of the binary graph format
+#define AGBIN_VERSION 1
+
+CGRAPH_API int agwritebin(Agraph_t *g, void *chan,
+                          size_t (*write)(void *chan, const char *buf,
+                                          size_t size));
+/**< @brief writes a graph in the compact binary format
+ *
+ * The graph is written with all its attributes and subgraphs, such that
+ * @ref agreadbin reconstructs a graph that @ref agwrite prints identically.
+ *
+ * @param write - callback given the channel and each block of output,
+ *   returning the number of bytes it wrote
+ * @returns 0 on success or EOF if writing failed
+ */
+
+CGRAPH_API Agraph_t *agreadbin(FILE *fp, Agdisc_t *disc);
+///< reads the next graph written by @ref agwritebin, or NULL at end of input
+
+CGRAPH_API Agraph_t *agmemreadbin(const char *data, size_t size,
+                                  Agdisc_t *disc);
+///< reads a graph written by @ref agwritebin from memory
 CGRAPH_API int agisdirected(Agraph_t * g);
 CGRAPH_API int agisundirected(Agraph_t * g);
 CGRAPH_API int agisstrict(Agraph_t * g);
@@ -24,8 +24,9 @@
 
 typedef struct {
     Dtlink_t link;
-    uint64_t refcnt: sizeof(uint64_t) * 8 - 1;
+    uint64_t refcnt: sizeof(uint64_t) * 8 - 3;
     uint64_t is_html: 1;
+    uint64_t canon: 2; ///< an @ref agstrcanon_t
     char *s;
     char store[1];		/* this is actually a dynamic array */
 } refstr_t;
@@ -120,6 +121,7 @@ static char *agstrdup_internal(Agraph_t *g, const char *s, bool is_html) {
 	}
 	r->refcnt = 1;
 	r->is_html = is_html;
+	r->canon = AGSTR_CANON_UNKNOWN;
 	strcpy(r->store, s);
 	r->s = r->store;
 	dtinsert(strdict, r);
@@ -178,6 +180,32 @@ void agmarkhtmlstr(char *s)
 	return;
     key = (refstr_t *) (s - offsetof(refstr_t, store[0]));
     key->is_html = 1;
+    key->canon = AGSTR_CANON_UNKNOWN;
+}
+
+/* agstrcanonhint:
+ * Return what is known of how s is canonicalized for printing.
+ * We assume s points to the datafield store[0] of a refstr.
+ */
+agstrcanon_t agstrcanonhint(const char *s)
+{
+    const refstr_t *key = (const refstr_t *) (s - offsetof(refstr_t, store[0]));
+    return key->canon;
+}
+
+void agsetstrcanonhint(const char *s, agstrcanon_t hint)
+{
+// Suppress Clang/GCC -Wcast-qual warning. The hint is bookkeeping of the
+// refstr, not part of the string content the caller sees as const.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+    refstr_t *key = (refstr_t *) (s - offsetof(refstr_t, store[0]));
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+    key->canon = hint;
 }
 
 #ifdef DEBUG
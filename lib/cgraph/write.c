@@ -26,6 +26,8 @@
 #include <cgraph/gv_ctype.h>
 #include <cgraph/strcasecmp.h>
 #include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
 
 #define EMPTY(s)		(((s) == 0) || (s)[0] == '\0')
 #define MAX(a,b)     ((a)>(b)?(a):(b))
@@ -33,10 +35,34 @@
 
 typedef void iochan_t;
 
-static int ioput(Agraph_t * g, iochan_t * ofile, char *str)
+/* Output is gathered here and handed to the putstr discipline in large
+ * blocks, rather than one call per token.
+ */
+#define OUTPUT_BUFSIZE		65536
+static char Outbuf[OUTPUT_BUFSIZE + 1];
+static size_t Outlen;
+
+static int ioflush(Agraph_t * g, iochan_t * ofile)
 {
-    return AGDISC(g, io)->putstr(ofile, str);
+    if (Outlen == 0)
+	return 0;
+    Outbuf[Outlen] = '\0';
+    Outlen = 0;
+    return AGDISC(g, io)->putstr(ofile, Outbuf);
+}
 
+static int ioput(Agraph_t * g, iochan_t * ofile, const char *str)
+{
+    size_t len = strlen(str);
+
+    if (Outlen + len > OUTPUT_BUFSIZE) {
+	CHKRV(ioflush(g, ofile));
+	if (len > OUTPUT_BUFSIZE)
+	    return AGDISC(g, io)->putstr(ofile, str);
+    }
+    memcpy(Outbuf + Outlen, str, len);
+    Outlen += len;
+    return 0;
 }
 
 #define MAX_OUTPUTLINE		128
@@ -270,6 +296,26 @@ static int _write_canonstr(Agraph_t *g, iochan_t *ofile, char *str, bool chk) {
     return ioput(g, ofile, str);
 }
 
+/* Write a string known to be a refstr, e.g. an attribute name or value.
+ * Strings too short to be split across lines always canonicalize the same
+ * way, so whether they are plain identifiers is remembered in the refstr and
+ * those are then written without being scanned again.
+ */
+static int write_refstr(Agraph_t * g, iochan_t * ofile, char *str)
+{
+    agstrcanon_t hint = agstrcanonhint(str);
+    if (hint == AGSTR_CANON_ID)
+	return ioput(g, ofile, str);
+
+    char *buffer = getoutputbuffer(str);
+    if (buffer == NULL)
+	return EOF;
+    char *canon = agstrcanon(str, buffer);
+    if (hint == AGSTR_CANON_UNKNOWN && strlen(str) <= MIN_OUTPUTLINE)
+	agsetstrcanonhint(str, canon == str ? AGSTR_CANON_ID : AGSTR_CANON_QUOTED);
+    return ioput(g, ofile, canon);
+}
+
 static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
 {
     char *s;
@@ -277,6 +323,8 @@ static int write_canonstr(Agraph_t * g, iochan_t * ofile, char *str)
     /* str may not have been allocated by agstrdup, so we first need to turn it
      * into a valid refstr
      */
+    if ((s = agstrbind(g, str)))
+	return write_refstr(g, ofile, s);
     s = agstrdup(g, str);
 
     int r = _write_canonstr(g, ofile, s, true);
@@ -313,9 +361,9 @@ static int write_dict(Agraph_t * g, iochan_t * ofile, char *name,
 	    CHKRV(ioput(g, ofile, ",\n"));
 	    CHKRV(indent(g, ofile));
 	}
-	CHKRV(write_canonstr(g, ofile, sym->name));
+	CHKRV(write_refstr(g, ofile, sym->name));
 	CHKRV(ioput(g, ofile, "="));
-	CHKRV(write_canonstr(g, ofile, sym->defval));
+	CHKRV(write_refstr(g, ofile, sym->defval));
     }
     if (cnt > 0) {
 	Level--;
@@ -534,9 +582,9 @@ static int write_nondefault_attrs(void *obj, iochan_t * ofile,
 		    CHKRV(ioput(g, ofile, ",\n"));
 		    CHKRV(indent(g, ofile));
 		}
-		CHKRV(write_canonstr(g, ofile, sym->name));
+		CHKRV(write_refstr(g, ofile, sym->name));
 		CHKRV(ioput(g, ofile, "="));
-		CHKRV(write_canonstr(g, ofile, data->str[sym->id]));
+		CHKRV(write_refstr(g, ofile, data->str[sym->id]));
 	    }
 	}
     if (cnt > 0) {
@@ -552,8 +600,11 @@ static int write_nodename(Agnode_t * n, iochan_t * ofile)
     char *name;
     Agraph_t *g;
 
-    name = agnameof(n);
     g = agraphof(n);
+    /* with the default ID discipline, named nodes’ IDs are their refstr names */
+    if (AGDISC(g, id) == &AgIdDisc && AGID(n) % 2 == 0)
+	return write_refstr(g, ofile, (char *)(uintptr_t)AGID(n));
+    name = agnameof(n);
     if (name) {
 	CHKRV(write_canonstr(g, ofile, name));
     } else {
@@ -715,10 +766,12 @@ int agwrite(Agraph_t * g, void *ofile)
 	if ((len == 0 || len >= MIN_OUTPUTLINE) && len <= (unsigned long)INT_MAX)
 	    Max_outputline = (int)len;
     }
+    Outlen = 0;			/* drop anything left by a failed write */
     set_attrwf(g, true, false);
     CHKRV(write_hdr(g, ofile, true));
     CHKRV(write_body(g, ofile));
     CHKRV(write_trl(g, ofile));
     Max_outputline = MAX_OUTPUTLINE;
+    CHKRV(ioflush(g, ofile));
     return AGDISC(g, io)->flush(ofile);
 }
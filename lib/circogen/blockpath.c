@@ -12,8 +12,9 @@
 #include	<cgraph/agxbuf.h>
 #include	<cgraph/alloc.h>
 #include	<circogen/blockpath.h>
-#include	<circogen/edgelist.h>
 #include	<stddef.h>
+#include	<stdlib.h>
+#include	<string.h>
 #include	<stdbool.h>
 
 /* The code below lays out a single block on a circle.
@@ -419,117 +420,249 @@ static void block_graph(Agraph_t * g, block_t * sn)
     }
 }
 
-static int count_all_crossings(nodelist_t * list, Agraph_t * subg)
+/* The crossing reduction below works on the nodes of a block by index, in
+ * agfstnode order. While it runs, POSITION holds that index; layout_block
+ * overwrites it with the final position afterwards.
+ */
+typedef struct {
+    size_t n;		///< number of nodes
+    Agnode_t **node;	///< node of each index
+    size_t *first;	///< neighbors of i are adj[first[i]] … adj[first[i + 1] - 1]
+    size_t *adj;	///< neighbor indices, in agfstedge order
+    size_t *at;		///< index of the node at each list position
+    size_t *pos;	///< list position of each node
+    size_t *left;	///< scratch, n + 1 entries
+    size_t *right;	///< scratch, n + 1 entries
+} ordering_t;
+
+static ordering_t mk_ordering(nodelist_t *list, Agraph_t *subg)
 {
-    edgelist *openEdgeList = init_edgelist();
+    ordering_t o = {.n = nodelist_size(list)};
     Agnode_t *n;
     Agedge_t *e;
-    int crossings = 0;
-    int order = 1;
+    int i = 0;
+
+    for (n = agfstnode(subg); n; n = agnxtnode(subg, n))
+	POSITION(n) = i++;
 
+    o.node = gv_calloc(o.n, sizeof(Agnode_t*));
+    o.first = gv_calloc(o.n + 1, sizeof(size_t));
+    o.adj = gv_calloc(2 * (size_t)agnedges(subg), sizeof(size_t));
+    size_t k = 0;
     for (n = agfstnode(subg); n; n = agnxtnode(subg, n)) {
-	for (e = agfstout(subg, n); e; e = agnxtout(subg, e)) {
-	    EDGEORDER(e) = 0;
+	o.node[POSITION(n)] = n;
+	o.first[POSITION(n)] = k;
+	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
+	    Agnode_t *neighbor = agtail(e);
+	    if (neighbor == n)
+		neighbor = aghead(e);
+	    o.adj[k++] = (size_t)POSITION(neighbor);
 	}
     }
+    o.first[o.n] = k;
+
+    o.at = gv_calloc(o.n, sizeof(size_t));
+    o.pos = gv_calloc(o.n, sizeof(size_t));
+    for (size_t item = 0; item < o.n; ++item) {
+	const size_t v = (size_t)POSITION(nodelist_get(list, item));
+	o.at[item] = v;
+	o.pos[v] = item;
+    }
 
-    for (size_t item = 0; item < nodelist_size(list); ++item) {
-	n = nodelist_get(list, item);
+    o.left = gv_calloc(o.n + 1, sizeof(size_t));
+    o.right = gv_calloc(o.n + 1, sizeof(size_t));
+    return o;
+}
 
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) > 0) {
-		edgelistitem *eitem;
-		Agedge_t *ep;
-
-		for (eitem = dtfirst(openEdgeList); eitem;
-		     eitem = dtnext(openEdgeList, eitem)) {
-		    ep = eitem->edge;
-		    if (EDGEORDER(ep) > EDGEORDER(e)) {
-			if (aghead(ep) != n && agtail(ep) != n)
-			    crossings++;
-		    }
-		}
-		remove_edge(openEdgeList, e);
-	    }
+static void free_ordering(ordering_t *o)
+{
+    free(o->node);
+    free(o->first);
+    free(o->adj);
+    free(o->at);
+    free(o->pos);
+    free(o->left);
+    free(o->right);
+}
+
+/* count_all_crossings:
+ * With every edge (a, b) taken as a < b in list order, count the pairs of
+ * edges (a, b), (c, d) with a < c < b and d != b. Besides the crossings, this
+ * counts an edge inside the span of another one it shares no end with, which
+ * is what the reduction has always minimized; the layouts depend on it.
+ * With left[t] the number of edges starting before position t, this is
+ * the sum over edges of left[b] - left[a + 1], less the pairs of edges ending
+ * at the same node, in O(N + E).
+ */
+static long long count_all_crossings(ordering_t *o)
+{
+    size_t *left = o->left;
+    long long crossings = 0;
+
+    left[0] = 0;
+    for (size_t p = 0; p < o->n; ++p) {
+	const size_t v = o->at[p];
+	long long ending = 0;
+	left[p + 1] = left[p];
+	for (size_t k = o->first[v]; k < o->first[v + 1]; ++k) {
+	    if (o->pos[o->adj[k]] > p)
+		left[p + 1]++;
+	    else
+		ending++;
+	}
+	crossings -= ending * (ending - 1) / 2;
+    }
+    for (size_t p = 0; p < o->n; ++p) {
+	const size_t v = o->at[p];
+	for (size_t k = o->first[v]; k < o->first[v + 1]; ++k) {
+	    const size_t q = o->pos[o->adj[k]];
+	    if (q > p)
+		crossings += (long long)(left[q] - left[p + 1]);
 	}
+    }
+    return crossings;
+}
 
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) == 0) {
-		EDGEORDER(e) = order;
-		add_edge(openEdgeList, e);
-	    }
+/// position of `w` in the list with `v` removed
+static size_t rest_pos(const ordering_t *o, size_t v, size_t w)
+{
+    return o->pos[w] - (o->pos[w] > o->pos[v]);
+}
+
+/* prepare_move:
+ * Moving v leaves the other nodes in the same order, so only the pairs
+ * counted by count_all_crossings that involve an edge of v can change; two
+ * edges of v never form one. Tabulate, over the list without v, left[t], the
+ * number of other edges starting before position t, and right[t], the number
+ * ending before it, for node_crossings. This takes O(N + E).
+ */
+static void prepare_move(ordering_t *o, size_t v)
+{
+    const size_t m = o->n - 1;
+    size_t *left = o->left;
+    size_t *right = o->right;
+
+    memset(left, 0, (m + 1) * sizeof(left[0]));
+    memset(right, 0, (m + 1) * sizeof(right[0]));
+    for (size_t p = 0; p < o->n; ++p) {
+	const size_t a = o->at[p];
+	if (a == v)
+	    continue;
+	const size_t t = p - (p > o->pos[v]);
+	for (size_t k = o->first[a]; k < o->first[a + 1]; ++k) {
+	    const size_t b = o->adj[k];
+	    if (b == v)
+		continue;
+	    if (o->pos[b] > p)
+		left[t + 1]++;
+	    else
+		right[t + 1]++;
 	}
-	order++;
     }
+    for (size_t t = 1; t <= m; ++t) {
+	left[t] += left[t - 1];
+	right[t] += right[t - 1];
+    }
+}
 
-    free_edgelist(openEdgeList);
+/* node_crossings:
+ * Count the pairs involving edges of v, with v placed just before position
+ * s of the list without v, after prepare_move(o, v). For an edge (x, v), the
+ * other edges start between x and v, or span x. For an edge (v, x), they
+ * start between v and x, or span v, less those ending at x.
+ */
+static long long node_crossings(const ordering_t *o, size_t v, size_t s)
+{
+    const size_t *left = o->left;
+    const size_t *right = o->right;
+    long long crossings = 0;
+
+    for (size_t k = o->first[v]; k < o->first[v + 1]; ++k) {
+	const size_t x = rest_pos(o, v, o->adj[k]);
+	if (x < s)
+	    crossings += (long long)(left[s] - left[x + 1])
+		       + (long long)(left[x] - right[x + 1]);
+	else
+	    crossings += (long long)(left[x] - left[s])
+		       + (long long)(left[s] - right[s])
+		       - (long long)(right[x + 1] - right[x]);
+    }
     return crossings;
 }
 
+/* move_node:
+ * Remove v. Then, insert v before u if after is false and after u otherwise.
+ */
+static void move_node(ordering_t *o, size_t v, size_t u, bool after)
+{
+    const size_t from = o->pos[v];
+    const size_t to = rest_pos(o, v, u) + after;
+
+    if (to > from)
+	memmove(&o->at[from], &o->at[from + 1], (to - from) * sizeof(o->at[0]));
+    else if (to < from)
+	memmove(&o->at[to + 1], &o->at[to], (from - to) * sizeof(o->at[0]));
+    o->at[to] = v;
+
+    const size_t lo = from < to ? from : to;
+    const size_t hi = from < to ? to : from;
+    for (size_t p = lo; p <= hi; ++p)
+	o->pos[o->at[p]] = p;
+}
+
 #define CROSS_ITER 10
 
 /* reduce:
- * Attempt to reduce edge crossings by moving nodes.
+ * Attempt to reduce edge crossings by moving nodes next to their neighbors.
  * Original crossing count is in cnt; final count is returned there.
- * list is the original list; return the best list found.
+ * Only moves that strictly reduce the count are kept. Each candidate is
+ * scored from the pairs involving the moved node alone, without copying
+ * the list or recounting.
  */
-static nodelist_t *reduce(nodelist_t * list, Agraph_t * subg, int *cnt)
+static void reduce(ordering_t *o, long long *cnt)
 {
-    Agnode_t *curnode;
-    Agedge_t *e;
-    Agnode_t *neighbor;
-    nodelist_t *listCopy;
-    int crossings, j, newCrossings;
-
-    crossings = *cnt;
-    for (curnode = agfstnode(subg); curnode;
-	 curnode = agnxtnode(subg, curnode)) {
-	/*  move curnode next to its neighbors */
-	for (e = agfstedge(subg, curnode); e;
-	     e = agnxtedge(subg, e, curnode)) {
-	    neighbor = agtail(e);
-	    if (neighbor == curnode)
-		neighbor = aghead(e);
-
-	    for (j = 0; j < 2; j++) {
-		listCopy = cloneNodelist(list);
-		insertNodelist(list, curnode, neighbor, j);
-		newCrossings = count_all_crossings(list, subg);
+    long long crossings = *cnt;
+
+    for (size_t v = 0; v < o->n; ++v) {
+	prepare_move(o, v);
+	for (size_t k = o->first[v]; k < o->first[v + 1]; ++k) {
+	    const size_t u = o->adj[k];
+	    for (int j = 0; j < 2; j++) {
+		const size_t slot = rest_pos(o, v, u) + (size_t)j;
+		const long long newCrossings = crossings
+		    - node_crossings(o, v, o->pos[v])
+		    + node_crossings(o, v, slot);
 		if (newCrossings < crossings) {
 		    crossings = newCrossings;
-		    freeNodelist(listCopy);
+		    move_node(o, v, u, j != 0);
 		    if (crossings == 0) {
 			*cnt = 0;
-			return list;
+			return;
 		    }
-		} else {
-		    freeNodelist(list);
-		    list = listCopy;
 		}
 	    }
 	}
     }
     *cnt = crossings;
-    return list;
 }
 
-static nodelist_t *reduce_edge_crossings(nodelist_t * list,
-					 Agraph_t * subg)
+static void reduce_edge_crossings(nodelist_t * list, Agraph_t * subg)
 {
-    int i, crossings, origCrossings;
+    long long crossings, origCrossings;
+    ordering_t o = mk_ordering(list, subg);
 
-    crossings = count_all_crossings(list, subg);
-    if (crossings == 0)
-	return list;
-
-    for (i = 0; i < CROSS_ITER; i++) {
+    crossings = count_all_crossings(&o);
+    for (int i = 0; crossings != 0 && i < CROSS_ITER; i++) {
 	origCrossings = crossings;
-	list = reduce(list, subg, &crossings);
-	/* return if no crossings or no improvement */
-	if (origCrossings == crossings || crossings == 0)
-	    return list;
+	reduce(&o, &crossings);
+	/* stop if no improvement */
+	if (origCrossings == crossings)
+	    break;
     }
-    return list;
+
+    for (size_t item = 0; item < o.n; ++item)
+	nodelist_set(list, item, o.node[o.at[item]]);
+    free_ordering(&o);
 }
 
 /* largest_nodesize:
@@ -635,7 +768,7 @@ nodelist_t *layout_block(Agraph_t * g, block_t * sn, double min_dist)
     /* at this point, longest_path is a list of all nodes in the block */
 
     /* apply crossing reduction algorithms here */
-    longest_path = reduce_edge_crossings(longest_path, subg);
+    reduce_edge_crossings(longest_path, subg);
 
     size_t N = nodelist_size(longest_path);
     largest_node = largest_nodesize(longest_path);
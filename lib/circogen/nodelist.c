@@ -67,46 +67,6 @@ void realignNodelist(nodelist_t *list, size_t np) {
   }
 }
 
-/* cloneNodelist:
- * Create a copy of list.
- */
-nodelist_t *cloneNodelist(nodelist_t * list)
-{
-    nodelist_t *newlist = mkNodelist();
-    for (size_t i = 0; i < nodelist_size(list); ++i) {
-      nodelist_append(newlist, nodelist_get(list, i));
-    }
-    return newlist;
-}
-
-/* insertNodelist:
- * Remove cn. Then, insert cn before neighbor if pos == 0 and 
- * after neighbor otherwise.
- */
-void
-insertNodelist(nodelist_t * list, Agnode_t * cn, Agnode_t * neighbor,
-	       int pos)
-{
-  nodelist_remove(list, cn);
-
-  for (size_t i = 0; i < nodelist_size(list); ++i) {
-    Agnode_t *here = nodelist_get(list, i);
-    if (here == neighbor) {
-      if (pos == 0) {
-        nodelist_append(list, NULL);
-        size_t to_move = sizeof(node_t*) * (nodelist_size(list) - i - 1);
-        if (to_move > 0) {
-          memmove(nodelist_at(list, i + 1), nodelist_at(list, i), to_move);
-        }
-        nodelist_set(list, i, cn);
-      } else {
-        appendNodelist(list, i, cn);
-      }
-      break;
-    }
-  }
-}
-
 /* concatNodelist:
  * attach l2 to l1.
  */
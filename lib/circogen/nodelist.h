@@ -26,10 +26,8 @@ extern "C" {
     extern void appendNodelist(nodelist_t*, size_t, Agnode_t *n);
 
     extern void realignNodelist(nodelist_t *list, size_t np);
-    extern void insertNodelist(nodelist_t *, Agnode_t *, Agnode_t *, int);
 
     extern void reverseAppend(nodelist_t *, nodelist_t *);
-    extern nodelist_t *cloneNodelist(nodelist_t * list);
 
 #ifdef DEBUG
     extern void printNodelist(nodelist_t * list);
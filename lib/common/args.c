@@ -95,6 +95,19 @@ config_extra_args(GVC_t *gvc, int argc, char** argv)
       case 'c' :
           gvc->common.config = true;
 	  break;
+      case 'j' :
+	if (arg[2]) {
+	  const int v = atoi(&arg[2]);
+	  if (v <= 0) {
+	    agerr(AGERR, "Invalid parameter \"%s\" for -j flag\n", arg + 2);
+	    dotneato_usage(1);
+	    return -1;
+	  }
+	  gvc->common.workers = v;
+	} else {
+	  gvc->common.workers = -1; // one per online processor
+	}
+	break;
       default :
         cnt++;
         if (*p != arg) *p = arg;
@@ -38,6 +38,9 @@ extern "C" {
 /// @return Previous color scheme
 COLORPROCS_API char *setColorScheme(const char *s);
 
+/// current color scheme for resolving names, or NULL if none is set
+COLORPROCS_API const char *getColorScheme(void);
+
 COLORPROCS_API int colorxlate(char *str, gvcolor_t * color, color_type_t target_type);
 COLORPROCS_API char *canontoken(char *str);
 
@@ -457,3 +457,5 @@ char *setColorScheme(const char *s) {
   colorscheme = s == NULL ? NULL : gv_strdup(s);
   return previous;
 }
+
+const char *getColorScheme(void) { return colorscheme; }
@@ -209,6 +209,7 @@
 #define WEDGED		(1 << 9)
 #define UNDERLINE	(1 << 10)
 #define FIXEDSHAPE	(1 << 11)
+#define SHAREDVERTICES	(1 << 12) /* polygon_t vertices are shared, see unshare_vertices */
 
 #define SHAPE_MASK	(127 << 24)
 
@@ -0,0 +1,472 @@
+/**
+ * @file
+ * @brief retained drawing of node and edge bodies, shared between jobs
+ *
+ * See displaylist.h for what is recorded and when.
+ */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include <assert.h>
+#include <cgraph/alloc.h>
+#include <common/displaylist.h>
+#include <common/render.h>
+#include <gvc/gvcint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    OP_PENCOLOR,
+    OP_FILLCOLOR,
+    OP_GRADIENT_VALS,
+    OP_STYLE,
+    OP_PENWIDTH,
+    OP_ELLIPSE,
+    OP_POLYGON,
+    OP_BEZIERCURVE,
+    OP_POLYLINE,
+    OP_TEXTSPAN,
+    OP_USERSHAPE,
+    OP_BEGIN_LABEL,
+    OP_END_LABEL,
+    OP_COMMENT,
+} op_kind_t;
+
+/// one recorded gvrender_* call, with arguments in graph coordinates
+typedef struct {
+    op_kind_t kind;
+    emit_state_t emit_state; ///< obj->emit_state at the time of the call
+    union {
+	char *str; ///< pen or fill colour, comment
+	struct {
+	    char *stopcolor;
+	    int angle;
+	    float frac;
+	} gradient;
+	char **style;
+	double penwidth;
+	struct {
+	    pointf *points;
+	    size_t n;
+	    int filled;
+	} shape;
+	struct {
+	    pointf p;
+	    textspan_t *span;
+	} text;
+	struct {
+	    char *name;
+	    pointf *points;
+	    size_t n;
+	    bool filled;
+	    char *imagescale;
+	    char *imagepos;
+	} usershape;
+	label_type label;
+    } u;
+} op_t;
+
+/// the recorded body of one node or edge
+typedef struct {
+    void *obj;    ///< node or edge, or NULL for an empty slot
+    size_t first; ///< index of its first op
+    size_t count; ///< number of ops
+    bool live;    ///< not replayable, always draw directly
+} entry_t;
+
+/// the most strictly aligned of the types stored in the arena
+typedef union {
+    double d;
+    void *p;
+    size_t z;
+} align_t;
+
+/// block of the arena that recorded arguments are copied into
+typedef struct chunk_s {
+    struct chunk_s *next;
+    size_t used;
+    size_t size;
+    align_t data[];
+} chunk_t;
+
+#define CHUNK_SIZE (64 * 1024)
+
+struct displaylist_s {
+    entry_t *entries; ///< open addressed on object pointer
+    size_t capacity;
+    size_t size;
+
+    op_t *ops;
+    size_t nops;
+    size_t ops_capacity;
+
+    chunk_t *chunks;
+
+    void *current;        ///< object being recorded, or NULL
+    size_t current_first; ///< its first op
+    bool aborted;         ///< recording of current was abandoned
+};
+
+displaylist_t *displaylist_open(void) {
+    return gv_alloc(sizeof(displaylist_t));
+}
+
+void displaylist_close(displaylist_t *dl) {
+    if (!dl)
+	return;
+    for (chunk_t *c = dl->chunks, *next; c; c = next) {
+	next = c->next;
+	free(c);
+    }
+    free(dl->ops);
+    free(dl->entries);
+    free(dl);
+}
+
+static void *arena_alloc(displaylist_t *dl, size_t size) {
+    size = (size + sizeof(align_t) - 1) / sizeof(align_t) * sizeof(align_t);
+    chunk_t *c = dl->chunks;
+    if (!c || c->size - c->used < size) {
+	const size_t capacity = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+	c = gv_alloc(sizeof(chunk_t) + capacity);
+	c->size = capacity;
+	c->next = dl->chunks;
+	dl->chunks = c;
+    }
+    void *p = (char *)c->data + c->used;
+    c->used += size;
+    return p;
+}
+
+static char *arena_strdup(displaylist_t *dl, const char *s) {
+    if (!s)
+	return NULL;
+    const size_t len = strlen(s) + 1;
+    return memcpy(arena_alloc(dl, len), s, len);
+}
+
+static pointf *arena_points(displaylist_t *dl, const pointf *pts, size_t n) {
+    return memcpy(arena_alloc(dl, n * sizeof(pointf)), pts, n * sizeof(pointf));
+}
+
+/// copy a style list as produced by parse_style
+///
+/// Each entry is followed by its arguments, each NUL terminated, and the
+/// arguments end with an empty string.
+static char **arena_style(displaylist_t *dl, char **s) {
+    if (!s)
+	return NULL;
+    size_t n = 0, bytes = 0;
+    for (; s[n]; ++n) {
+	const char *p = s[n];
+	do {
+	    p += strlen(p) + 1;
+	} while (*p != '\0');
+	bytes += (size_t)(p - s[n]) + 1;
+    }
+    char **copy = arena_alloc(dl, (n + 1) * sizeof(char *));
+    char *buf = arena_alloc(dl, bytes);
+    for (size_t i = 0; i < n; ++i) {
+	const char *p = s[i];
+	do {
+	    p += strlen(p) + 1;
+	} while (*p != '\0');
+	const size_t len = (size_t)(p - s[i]) + 1;
+	copy[i] = memcpy(buf, s[i], len);
+	buf += len;
+    }
+    copy[n] = NULL;
+    return copy;
+}
+
+static size_t hash_obj(const void *obj) {
+    uintptr_t h = (uintptr_t)obj;
+    h ^= h >> 17;
+    h *= (uintptr_t)0x9e3779b97f4a7c15ull;
+    return (size_t)(h ^ (h >> 29));
+}
+
+static entry_t *find(const displaylist_t *dl, const void *obj) {
+    if (dl->capacity == 0)
+	return NULL;
+    for (size_t i = hash_obj(obj) & (dl->capacity - 1);;
+         i = (i + 1) & (dl->capacity - 1)) {
+	if (dl->entries[i].obj == obj)
+	    return &dl->entries[i];
+	if (dl->entries[i].obj == NULL)
+	    return NULL;
+    }
+}
+
+static void insert(displaylist_t *dl, entry_t entry) {
+    if (2 * (dl->size + 1) > dl->capacity) {
+	const size_t capacity = dl->capacity == 0 ? 1024 : 2 * dl->capacity;
+	entry_t *entries = gv_calloc(capacity, sizeof(entry_t));
+	for (size_t i = 0; i < dl->capacity; ++i) {
+	    if (!dl->entries[i].obj)
+		continue;
+	    size_t j = hash_obj(dl->entries[i].obj) & (capacity - 1);
+	    while (entries[j].obj)
+		j = (j + 1) & (capacity - 1);
+	    entries[j] = dl->entries[i];
+	}
+	free(dl->entries);
+	dl->entries = entries;
+	dl->capacity = capacity;
+    }
+    size_t j = hash_obj(entry.obj) & (dl->capacity - 1);
+    while (dl->entries[j].obj)
+	j = (j + 1) & (dl->capacity - 1);
+    dl->entries[j] = entry;
+    ++dl->size;
+}
+
+/// start a new op if an object is being recorded
+static op_t *record(displaylist_t *dl, GVJ_t *job, op_kind_t kind) {
+    if (!dl->current || dl->aborted)
+	return NULL;
+    if (dl->nops == dl->ops_capacity) {
+	const size_t capacity = dl->ops_capacity == 0 ? 4096 : 2 * dl->ops_capacity;
+	dl->ops = gv_recalloc(dl->ops, dl->ops_capacity, capacity, sizeof(op_t));
+	dl->ops_capacity = capacity;
+    }
+    op_t *op = &dl->ops[dl->nops++];
+    op->kind = kind;
+    op->emit_state = job->obj->emit_state;
+    return op;
+}
+
+static void replay(GVJ_t *job, const displaylist_t *dl, const entry_t *e) {
+    obj_state_t *obj = job->obj;
+    const emit_state_t old_emit_state = obj->emit_state;
+
+    for (size_t i = e->first; i < e->first + e->count; ++i) {
+	const op_t *op = &dl->ops[i];
+	obj->emit_state = op->emit_state;
+	switch (op->kind) {
+	case OP_PENCOLOR:
+	    gvrender_set_pencolor(job, op->u.str);
+	    break;
+	case OP_FILLCOLOR:
+	    gvrender_set_fillcolor(job, op->u.str);
+	    break;
+	case OP_GRADIENT_VALS:
+	    gvrender_set_gradient_vals(job, op->u.gradient.stopcolor,
+	                               op->u.gradient.angle, op->u.gradient.frac);
+	    break;
+	case OP_STYLE:
+	    gvrender_set_style(job, op->u.style);
+	    break;
+	case OP_PENWIDTH:
+	    gvrender_set_penwidth(job, op->u.penwidth);
+	    break;
+	case OP_ELLIPSE:
+	    gvrender_ellipse(job, op->u.shape.points, op->u.shape.filled);
+	    break;
+	case OP_POLYGON:
+	    gvrender_polygon(job, op->u.shape.points, op->u.shape.n,
+	                     op->u.shape.filled);
+	    break;
+	case OP_BEZIERCURVE:
+	    gvrender_beziercurve(job, op->u.shape.points, op->u.shape.n,
+	                         op->u.shape.filled);
+	    break;
+	case OP_POLYLINE:
+	    gvrender_polyline(job, op->u.shape.points, op->u.shape.n);
+	    break;
+	case OP_TEXTSPAN: {
+	    // renderers may annotate the span, so give them a scratch copy
+	    textspan_t span = *op->u.text.span;
+	    gvrender_textspan(job, op->u.text.p, &span);
+	    break;
+	}
+	case OP_USERSHAPE:
+	    gvrender_usershape(job, op->u.usershape.name, op->u.usershape.points,
+	                       op->u.usershape.n, op->u.usershape.filled,
+	                       op->u.usershape.imagescale,
+	                       op->u.usershape.imagepos);
+	    break;
+	case OP_BEGIN_LABEL:
+	    gvrender_begin_label(job, op->u.label);
+	    break;
+	case OP_END_LABEL:
+	    gvrender_end_label(job);
+	    break;
+	case OP_COMMENT:
+	    gvrender_comment(job, op->u.str);
+	    break;
+	}
+    }
+
+    obj->emit_state = old_emit_state;
+}
+
+bool displaylist_begin(GVJ_t *job, void *obj) {
+    displaylist_t *dl = job->gvc->displaylist;
+    if (!dl)
+	return false;
+    assert(!dl->current && "nested display list recording");
+
+    // whether a body emits anchors depends on whether this job produces maps
+    // or tooltips, so such bodies cannot be shared
+    if (job->obj->url || job->obj->explicit_tooltip)
+	return false;
+
+    const entry_t *e = find(dl, obj);
+    if (e) {
+	if (e->live)
+	    return false;
+	replay(job, dl, e);
+	return true;
+    }
+
+    dl->current = obj;
+    dl->current_first = dl->nops;
+    dl->aborted = false;
+    return false;
+}
+
+void displaylist_end(GVJ_t *job) {
+    displaylist_t *dl = job->gvc->displaylist;
+    if (!dl || !dl->current)
+	return;
+
+    entry_t e = {.obj = dl->current, .first = dl->current_first,
+                 .count = dl->nops - dl->current_first, .live = dl->aborted};
+    if (dl->aborted) {
+	dl->nops = dl->current_first;
+	e.count = 0;
+    }
+    insert(dl, e);
+    dl->current = NULL;
+}
+
+void displaylist_abort(GVJ_t *job) {
+    displaylist_t *dl = job->gvc ? job->gvc->displaylist : NULL;
+    if (dl && dl->current)
+	dl->aborted = true;
+}
+
+void displaylist_pencolor(displaylist_t *dl, GVJ_t *job, const char *name) {
+    op_t *op = record(dl, job, OP_PENCOLOR);
+    if (op)
+	op->u.str = arena_strdup(dl, name);
+}
+
+void displaylist_fillcolor(displaylist_t *dl, GVJ_t *job, const char *name) {
+    op_t *op = record(dl, job, OP_FILLCOLOR);
+    if (op)
+	op->u.str = arena_strdup(dl, name);
+}
+
+void displaylist_gradient_vals(displaylist_t *dl, GVJ_t *job,
+                               const char *stopcolor, int angle, float frac) {
+    op_t *op = record(dl, job, OP_GRADIENT_VALS);
+    if (op) {
+	op->u.gradient.stopcolor = arena_strdup(dl, stopcolor);
+	op->u.gradient.angle = angle;
+	op->u.gradient.frac = frac;
+    }
+}
+
+void displaylist_style(displaylist_t *dl, GVJ_t *job, char **s) {
+    op_t *op = record(dl, job, OP_STYLE);
+    if (op)
+	op->u.style = arena_style(dl, s);
+}
+
+void displaylist_penwidth(displaylist_t *dl, GVJ_t *job, double penwidth) {
+    op_t *op = record(dl, job, OP_PENWIDTH);
+    if (op)
+	op->u.penwidth = penwidth;
+}
+
+static void record_shape(displaylist_t *dl, GVJ_t *job, op_kind_t kind,
+                         const pointf *pts, size_t n, int filled) {
+    op_t *op = record(dl, job, kind);
+    if (op) {
+	op->u.shape.points = arena_points(dl, pts, n);
+	op->u.shape.n = n;
+	op->u.shape.filled = filled;
+    }
+}
+
+void displaylist_ellipse(displaylist_t *dl, GVJ_t *job, const pointf *pf,
+                         int filled) {
+    record_shape(dl, job, OP_ELLIPSE, pf, 2, filled);
+}
+
+void displaylist_polygon(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                         size_t n, int filled) {
+    record_shape(dl, job, OP_POLYGON, af, n, filled);
+}
+
+void displaylist_beziercurve(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                             size_t n, int filled) {
+    record_shape(dl, job, OP_BEZIERCURVE, af, n, filled);
+}
+
+void displaylist_polyline(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                          size_t n) {
+    record_shape(dl, job, OP_POLYLINE, af, n, 0);
+}
+
+void displaylist_textspan(displaylist_t *dl, GVJ_t *job, pointf p,
+                          const textspan_t *span) {
+    op_t *op = record(dl, job, OP_TEXTSPAN);
+    if (!op)
+	return;
+    // the span and its font may be temporaries of the caller
+    textspan_t *copy = arena_alloc(dl, sizeof(textspan_t));
+    *copy = *span;
+    copy->str = arena_strdup(dl, span->str);
+    copy->free_layout = NULL;
+    if (span->font) {
+	textfont_t *font = arena_alloc(dl, sizeof(textfont_t));
+	*font = *span->font;
+	copy->font = font;
+    }
+    op->u.text.p = p;
+    op->u.text.span = copy;
+}
+
+void displaylist_usershape(displaylist_t *dl, GVJ_t *job, const char *name,
+                           const pointf *a, size_t n, bool filled,
+                           const char *imagescale, const char *imagepos) {
+    op_t *op = record(dl, job, OP_USERSHAPE);
+    if (op) {
+	op->u.usershape.name = arena_strdup(dl, name);
+	op->u.usershape.points = arena_points(dl, a, n);
+	op->u.usershape.n = n;
+	op->u.usershape.filled = filled;
+	op->u.usershape.imagescale = arena_strdup(dl, imagescale);
+	op->u.usershape.imagepos = arena_strdup(dl, imagepos);
+    }
+}
+
+void displaylist_begin_label(displaylist_t *dl, GVJ_t *job, label_type type) {
+    op_t *op = record(dl, job, OP_BEGIN_LABEL);
+    if (op)
+	op->u.label = type;
+}
+
+void displaylist_end_label(displaylist_t *dl, GVJ_t *job) {
+    (void)record(dl, job, OP_END_LABEL);
+}
+
+void displaylist_comment(displaylist_t *dl, GVJ_t *job, const char *str) {
+    op_t *op = record(dl, job, OP_COMMENT);
+    if (op)
+	op->u.str = arena_strdup(dl, str);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief retained drawing of node and edge bodies, shared between jobs
+ *
+ * When a graph is rendered by several jobs (`-Tsvg -Tpng -Tcmapx`), each job
+ * walks the graph through @ref emit_graph. The page, layer and object framing
+ * differs between jobs, but the drawing of a node's shape or an edge's splines
+ * and arrowheads does not: it is the same sequence of `gvrender_*` calls in
+ * graph coordinates. A display list records that sequence the first time an
+ * object is drawn and replays it into later jobs, skipping style parsing,
+ * attribute lookup and geometry generation.
+ *
+ * Bodies whose drawing depends on the job are not recorded and are always
+ * drawn directly. These are the ones emitting anchors (only jobs producing
+ * maps or tooltips get them), HTML labels (which push their own object state)
+ * and EPSF shapes (which write straight to the output).
+ */
+
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#pragma once
+
+#include <common/types.h>
+#include <gvc/gvcjob.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct displaylist_s displaylist_t;
+
+displaylist_t *displaylist_open(void);
+void displaylist_close(displaylist_t *dl);
+
+/// start drawing the body of a node or edge
+///
+/// @return true if the body was replayed from the display list, in which case
+///   the caller must not draw it and must not call @ref displaylist_end
+bool displaylist_begin(GVJ_t *job, void *obj);
+
+/// finish drawing the body started by @ref displaylist_begin
+void displaylist_end(GVJ_t *job);
+
+/// the body being recorded cannot be replayed; draw it directly every time
+void displaylist_abort(GVJ_t *job);
+
+/* recording hooks, called from the gvrender_* functions */
+void displaylist_pencolor(displaylist_t *dl, GVJ_t *job, const char *name);
+void displaylist_fillcolor(displaylist_t *dl, GVJ_t *job, const char *name);
+void displaylist_gradient_vals(displaylist_t *dl, GVJ_t *job,
+                               const char *stopcolor, int angle, float frac);
+void displaylist_style(displaylist_t *dl, GVJ_t *job, char **s);
+void displaylist_penwidth(displaylist_t *dl, GVJ_t *job, double penwidth);
+void displaylist_ellipse(displaylist_t *dl, GVJ_t *job, const pointf *pf,
+                         int filled);
+void displaylist_polygon(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                         size_t n, int filled);
+void displaylist_beziercurve(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                             size_t n, int filled);
+void displaylist_polyline(displaylist_t *dl, GVJ_t *job, const pointf *af,
+                          size_t n);
+void displaylist_textspan(displaylist_t *dl, GVJ_t *job, pointf p,
+                          const textspan_t *span);
+void displaylist_usershape(displaylist_t *dl, GVJ_t *job, const char *name,
+                           const pointf *a, size_t n, bool filled,
+                           const char *imagescale, const char *imagepos);
+void displaylist_begin_label(displaylist_t *dl, GVJ_t *job, label_type type);
+void displaylist_end_label(displaylist_t *dl, GVJ_t *job);
+void displaylist_comment(displaylist_t *dl, GVJ_t *job, const char *str);
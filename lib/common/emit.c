@@ -28,9 +28,12 @@
 #include <cgraph/list.h>
 #include <cgraph/streq.h>
 #include <cgraph/unreachable.h>
+#include <common/displaylist.h>
 #include <common/htmltable.h>
 #include <gvc/gvc.h>
+#include <gvc/gvcint.h>
 #include <cdt/cdt.h>
+#include <label/index.h>
 #include <pathplan/pathgeom.h>
 #include <xdot/xdot.h>
 
@@ -90,6 +93,9 @@ static char *defaultlinestyle[3] = { "solid\0", "setlinewidth\0001\0", 0 };
 /* push empty graphic state for current object */
 obj_state_t* push_obj_state(GVJ_t *job)
 {
+    /* nested object state is not captured by a display list */
+    displaylist_abort(job);
+
     obj_state_t *obj = gv_alloc(sizeof(obj_state_t));
 
     obj_state_t *parent = obj->parent = job->obj;
@@ -1900,9 +1906,12 @@ static void emit_node(GVJ_t * job, node_t * n)
 	}
 
 	emit_begin_node(job, n);
-	ND_shape(n)->fns->codefn(job, n);
-	if (ND_xlabel(n) && ND_xlabel(n)->set)
-	    emit_label(job, EMIT_NLABEL, ND_xlabel(n));
+	if (!displaylist_begin(job, n)) {
+	    ND_shape(n)->fns->codefn(job, n);
+	    if (ND_xlabel(n) && ND_xlabel(n)->set)
+		emit_label(job, EMIT_NLABEL, ND_xlabel(n));
+	    displaylist_end(job);
+	}
 	emit_end_node(job);
     }
 }
@@ -2792,7 +2801,10 @@ static void emit_edge(GVJ_t * job, edge_t * e)
 	}
 
 	emit_begin_edge(job, e, styles);
-	emit_edge_graphics (job, e, styles);
+	if (!displaylist_begin(job, e)) {
+	    emit_edge_graphics (job, e, styles);
+	    displaylist_end(job);
+	}
 	emit_end_edge(job);
     }
 }
@@ -3233,6 +3245,266 @@ static void emit_colors(GVJ_t * job, graph_t * g)
     }
 }
 
+/* Spatial index over the nodes and edges of a laid out graph. It lets a page
+ * or viewport that shows only part of a large layout find the objects it
+ * overlaps without testing each of them. Building the index costs more than
+ * one pass over the graph, so it is only built for the second partial view of
+ * a layout and then kept until the graph is laid out again, so that a
+ * sequence of pages or tiles shares it.
+ */
+struct emit_index_s {
+    graph_t *g;     ///< root graph whose layout is indexed
+    Rect_t cover;   ///< union of the extents of all nodes and edges
+    bool empty;     ///< the graph has nothing to draw
+    int partial_views; ///< views so far that showed only part of the graph
+    RTree_t *rtree; ///< the index, or NULL if not yet built
+};
+
+/// round a coordinate down (`dir` < 0) or up (`dir` > 0) to an int
+static int rect_coord(double v, int dir)
+{
+    v = dir < 0 ? floor(v) : ceil(v);
+    if (!(v > INT_MIN))
+	return INT_MIN;
+    if (!(v < INT_MAX))
+	return INT_MAX;
+    return (int)v;
+}
+
+/// smallest integer rectangle containing `b`
+///
+/// Inverted boxes are normalised, so the result overlaps every box that
+/// `boxf_overlap` considers overlapping `b`.
+static Rect_t box2rect(boxf b)
+{
+    Rect_t r;
+    r.boundary[0] = rect_coord(fmin(b.LL.x, b.UR.x), -1);
+    r.boundary[1] = rect_coord(fmin(b.LL.y, b.UR.y), -1);
+    r.boundary[2] = rect_coord(fmax(b.LL.x, b.UR.x), 1);
+    r.boundary[3] = rect_coord(fmax(b.LL.y, b.UR.y), 1);
+    return r;
+}
+
+static boxf label_box(const textlabel_t *lp)
+{
+    const pointf s = {lp->dimen.x / 2., lp->dimen.y / 2.};
+    return (boxf){.LL = sub_pointf(lp->pos, s), .UR = add_pointf(lp->pos, s)};
+}
+
+/// extent tested by `edge_in_box`
+static bool edge_box(edge_t *e, boxf *bb)
+{
+    bool found = false;
+    boxf b = {{0}};
+    const splines *spl = ED_spl(e);
+    if (spl) {
+	b = spl->bb;
+	found = true;
+    }
+    textlabel_t *labels[] = {ED_label(e), ED_xlabel(e)};
+    for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); ++i) {
+	const textlabel_t *lp = labels[i];
+	if (!lp || (lp == ED_xlabel(e) && !lp->set))
+	    continue;
+	const boxf lb = label_box(lp);
+	if (found) {
+	    b.LL.x = fmin(b.LL.x, lb.LL.x);
+	    b.LL.y = fmin(b.LL.y, lb.LL.y);
+	    b.UR.x = fmax(b.UR.x, lb.UR.x);
+	    b.UR.y = fmax(b.UR.y, lb.UR.y);
+	} else {
+	    b = lb;
+	}
+	found = true;
+    }
+    *bb = b;
+    return found;
+}
+
+static void emit_index_add(struct emit_index_s *idx, void *obj, boxf b)
+{
+    Rect_t r = box2rect(b);
+    if (idx->rtree) {
+	RTreeInsert(idx->rtree, &r, obj, &idx->rtree->root, 0);
+    } else {
+	idx->cover = idx->empty ? r : CombineRect(&idx->cover, &r);
+	idx->empty = false;
+    }
+}
+
+/// add every node and edge of the indexed graph
+static void emit_index_fill(struct emit_index_s *idx)
+{
+    graph_t *g = idx->g;
+    for (node_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	emit_index_add(idx, n, ND_bb(n));
+	for (edge_t *e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    boxf bb;
+	    if (edge_box(e, &bb))
+		emit_index_add(idx, e, bb);
+	}
+    }
+}
+
+/// the index of `g`, which only has its cover computed until it is built
+static struct emit_index_s *emit_index(GVC_t *gvc, graph_t *g)
+{
+    if (gvc->emit_index && gvc->emit_index->g == g)
+	return gvc->emit_index;
+    emit_index_free(gvc);
+
+    struct emit_index_s *idx = gv_alloc(sizeof(*idx));
+    idx->g = g;
+    idx->empty = true;
+    emit_index_fill(idx);
+    gvc->emit_index = idx;
+    return idx;
+}
+
+void emit_index_free(GVC_t *gvc)
+{
+    struct emit_index_s *idx = gvc ? gvc->emit_index : NULL;
+    if (!idx)
+	return;
+    if (idx->rtree)
+	RTreeClose(idx->rtree);
+    free(idx);
+    gvc->emit_index = NULL;
+}
+
+/// where the walk of a whole graph in `emit_view` reaches an object
+///
+/// Out edges are walked in the order of `agfstout`, by head and then by edge.
+typedef struct {
+    uint64_t node; ///< sequence number of the node being walked
+    uint64_t head; ///< sequence number of the head of its out edge
+    uint64_t edge; ///< 0 for that node itself, else 1 + its out edge's sequence
+    bool is_edge;  ///< an edge, rather than a node, is drawn here
+    void *obj;
+} walk_pos_t;
+
+static walk_pos_t out_edge_pos(edge_t *e, bool is_edge, void *obj)
+{
+    return (walk_pos_t){.node = AGSEQ(agtail(e)), .head = AGSEQ(aghead(e)),
+                        .edge = AGSEQ(e) + 1, .is_edge = is_edge, .obj = obj};
+}
+
+DEFINE_LIST(walk_list, walk_pos_t)
+
+static int walk_pos_cmp(const walk_pos_t *a, const walk_pos_t *b)
+{
+    if (a->node != b->node)
+	return a->node < b->node ? -1 : 1;
+    if (a->head != b->head)
+	return a->head < b->head ? -1 : 1;
+    if (a->edge != b->edge)
+	return a->edge < b->edge ? -1 : 1;
+    return (int)a->is_edge - (int)b->is_edge;
+}
+
+/// objects overlapping a view, with the positions at which they are drawn
+typedef struct {
+    walk_list_t nodes;
+    walk_list_t edges;
+    bool breadth_first; ///< position nodes where the breadth first walk draws them
+} visible_t;
+
+static void collect_visible(void *obj, void *arg)
+{
+    visible_t *v = arg;
+    if (AGTYPE(obj) == AGNODE) {
+	node_t *n = obj;
+	walk_pos_t pos = {.node = AGSEQ(n), .obj = n};
+	if (v->breadth_first) {
+	    /* The breadth first walk also draws the head of each out edge it
+	     * passes, so a node can be drawn before its own turn comes. */
+	    graph_t *g = agroot(n);
+	    for (edge_t *e = agfstin(g, n); e; e = agnxtin(g, e)) {
+		const walk_pos_t in = out_edge_pos(e, false, n);
+		if (walk_pos_cmp(&in, &pos) < 0)
+		    pos = in;
+	    }
+	}
+	walk_list_append(&v->nodes, pos);
+    } else {
+	edge_t *e = obj;
+	walk_list_append(&v->edges, out_edge_pos(e, true, e));
+    }
+}
+
+/// Emit the nodes and edges of a view using the spatial index, in the same
+/// order as the walks in `emit_view`.
+///
+/// @return false if nothing was emitted because walking every object is
+///   cheaper, as it is when the view covers the whole graph or is the first
+///   partial view of this layout
+static bool emit_view_indexed(GVJ_t *job, graph_t *g, int flags)
+{
+    struct emit_index_s *idx = emit_index(job->gvc, g);
+    const Rect_t clip = box2rect(job->clip);
+    if (idx->empty || (clip.boundary[0] <= idx->cover.boundary[0]
+                       && clip.boundary[1] <= idx->cover.boundary[1]
+                       && clip.boundary[2] >= idx->cover.boundary[2]
+                       && clip.boundary[3] >= idx->cover.boundary[3]))
+	return false;
+    if (!idx->rtree) {
+	if (idx->partial_views++ == 0)
+	    return false;
+	idx->rtree = RTreeOpen();
+	emit_index_fill(idx);
+    }
+
+    const bool breadth_first =
+        !(flags & (EMIT_SORTED | EMIT_EDGE_SORTED | EMIT_PREORDER));
+    visible_t v = {.breadth_first = breadth_first};
+    RTreeVisit(idx->rtree->root, &clip, collect_visible, &v);
+    walk_list_sort(&v.nodes, walk_pos_cmp);
+    walk_list_sort(&v.edges, walk_pos_cmp);
+
+    if (breadth_first) {
+	/* merge the two lists, drawing a node before an edge at the same
+	 * position as the walk does */
+	const size_t nnodes = walk_list_size(&v.nodes);
+	const size_t nedges = walk_list_size(&v.edges);
+	for (size_t i = 0, j = 0; i < nnodes || j < nedges;) {
+	    const walk_pos_t *n = i < nnodes ? walk_list_at(&v.nodes, i) : NULL;
+	    const walk_pos_t *e = j < nedges ? walk_list_at(&v.edges, j) : NULL;
+	    if (n && (!e || walk_pos_cmp(n, e) < 0)) {
+		emit_node(job, n->obj);
+		++i;
+	    } else {
+		emit_edge(job, e->obj);
+		++j;
+	    }
+	}
+    } else {
+	const bool edges_first = flags & EMIT_EDGE_SORTED;
+	for (int pass = 0; pass < 2; ++pass) {
+	    if ((pass == 0) == edges_first) {
+		gvrender_begin_edges(job);
+		for (size_t i = 0; i < walk_list_size(&v.edges); ++i) {
+		    edge_t *e = walk_list_get(&v.edges, i).obj;
+		    if (!(flags & EMIT_PREORDER) || write_edge_test(g, e))
+			emit_edge(job, e);
+		}
+		gvrender_end_edges(job);
+	    } else {
+		gvrender_begin_nodes(job);
+		for (size_t i = 0; i < walk_list_size(&v.nodes); ++i) {
+		    node_t *n = walk_list_get(&v.nodes, i).obj;
+		    if (!(flags & EMIT_PREORDER) || write_node_test(g, n))
+			emit_node(job, n);
+		}
+		gvrender_end_nodes(job);
+	    }
+	}
+    }
+
+    walk_list_free(&v.nodes);
+    walk_list_free(&v.edges);
+    return true;
+}
+
 static void emit_view(GVJ_t * job, graph_t * g, int flags)
 {
     GVC_t * gvc = job->gvc;
@@ -3243,7 +3515,9 @@ static void emit_view(GVJ_t * job, graph_t * g, int flags)
     /* when drawing, lay clusters down before nodes and edges */
     if (!(flags & EMIT_CLUSTERS_LAST))
 	emit_clusters(job, g, flags);
-    if (flags & EMIT_SORTED) {
+    if (emit_view_indexed(job, g, flags)) {
+	/* only the objects overlapping the view were visited */
+    } else if (flags & EMIT_SORTED) {
 	/* output all nodes, then all edges */
 	gvrender_begin_nodes(job);
 	for (n = agfstnode(g); n; n = agnxtnode(g, n))
@@ -3425,6 +3699,9 @@ void emit_graph(GVJ_t * job, graph_t * g)
     gvrender_comment(job, s);
 
     job->layerNum = 0;
+    /* object IDs in the graph prologue must not depend on where pagination of
+     * a previous graph rendered by this job left off */
+    job->pagesArrayElem = (point){0};
     emit_begin_graph(job, g);
 
     if (flags & EMIT_COLORS)
@@ -3941,6 +4218,11 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
     init_gvc(gvc, g);
     init_layering(gvc, g);
 
+    /* with several jobs, draw each node and edge once and replay it into the
+     * others */
+    if (gvc->jobs && gvc->jobs->next)
+	gvc->displaylist = displaylist_open();
+
     gv_fixLocale (1);
     for (job = gvjobs_first(gvc); job; job = gvjobs_next(gvc)) {
 	if (gvc->gvg) {
@@ -3958,6 +4240,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	if (!GD_drawing(g)) {
 	    agerr (AGERR, "layout was not done\n");
 	    gv_fixLocale (0);
+	    displaylist_close(gvc->displaylist);
+	    gvc->displaylist = NULL;
 	    FINISH();
 	    return -1;
 	}
@@ -3966,6 +4250,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
         if (job->output_lang == NO_SUPPORT) {
             agerr (AGERR, "renderer for %s is unavailable\n", job->output_langname);
 	    gv_fixLocale (0);
+	    displaylist_close(gvc->displaylist);
+	    gvc->displaylist = NULL;
 	    FINISH();
             return -1;
         }
@@ -4034,6 +4320,8 @@ int gvRenderJobs (GVC_t * gvc, graph_t * g)
 	prevjob = job;
     }
     gv_fixLocale (0);
+    displaylist_close(gvc->displaylist);
+    gvc->displaylist = NULL;
     FINISH();
     return 0;
 }
@@ -26,7 +26,7 @@
 #include <string.h>
 
 static char *usageFmt =
-    "Usage: %s [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] <dot files>\n";
+    "Usage: %s [-Vv?] [-(GNE)name=val] [-(KTlso)<val>] [-j[n]] <dot files>\n";
 
 static char *genericItems = "\n\
  -V          - Print version and exit\n\
@@ -42,7 +42,8 @@ static char *genericItems = "\n\
  -P          - Internally generate a graph of the current plugins. \n\
  -q[l]       - Set level of message suppression (=1)\n\
  -s[v]       - Scale input by 'v' (=72)\n\
- -y          - Invert y coordinate in output\n";
+ -y          - Invert y coordinate in output\n\
+ -j[n]       - Lay out and render up to n input graphs in parallel (=#CPUs)\n";
 
 static char *neatoFlags =
     "(additional options for neato)    [-x] [-n<v>]\n";
@@ -183,7 +184,12 @@ static void global_def(char *dcl, int kind) {
     agxbfree(&xb);
 }
 
-static int gvg_init(GVC_t *gvc, graph_t *g, char *fn, int gidx)
+/* Record g as the gidx-th graph read from input file fn (NULL for stdin).
+ * Graphs not obtained through gvNextInputGraph, e.g. those parsed by a
+ * pipelined worker, are registered through here so that -O output names
+ * are derived the same way.
+ */
+int gvg_init(GVC_t *gvc, graph_t *g, char *fn, int gidx)
 {
     GVG_t *gvg = gv_alloc(sizeof(GVG_t));
     if (!gvc->gvgs) 
@@ -501,6 +507,7 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
     static FILE *fp;
     static FILE *oldfp;
     static int gidx;
+    static bool binary; // is fp in the -Tgvb binary format?
 
     while (!g) {
 	if (!fp) {
@@ -520,8 +527,12 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	if (oldfp != fp) {
 	    agsetfile(fn ? fn : "<stdin>");
 	    oldfp = fp;
+	    const int c = getc(fp);
+	    binary = c == (unsigned char)AGBIN_MAGIC[0];
+	    if (c != EOF)
+		ungetc(c, fp);
 	}
-	g = agread(fp,NULL);
+	g = binary ? agreadbin(fp, NULL) : agread(fp, NULL);
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
@@ -10,6 +10,7 @@
 
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
+#include <common/displaylist.h>
 #include <common/render.h>
 #include <common/htmltable.h>
 #include <limits.h>
@@ -217,6 +218,8 @@ void emit_label(GVJ_t * job, emit_state_t emit_state, textlabel_t * lp)
     obj->emit_state = emit_state;
 
     if (lp->html) {
+	/* HTML labels carry their own anchors and object state */
+	displaylist_abort(job);
 	emit_html_label(job, lp->u.html, lp);
 	obj->emit_state = old_emit_state;
 	return;
@@ -84,6 +84,7 @@ extern "C" {
     RENDER_API void graph_cleanup(graph_t * g);
     RENDER_API int dotneato_args_initialize(GVC_t * gvc, int, char **);
     RENDER_API int dotneato_usage(int);
+    RENDER_API int gvg_init(GVC_t *gvc, graph_t *g, char *fn, int gidx);
     RENDER_API void dotneato_postprocess(Agraph_t *);
     RENDER_API void gv_postprocess(Agraph_t *, int);
     RENDER_API Ppolyline_t* ellipticWedge (pointf ctr, double major, double minor, double angle0, double angle1);
@@ -93,6 +94,7 @@ extern "C" {
     RENDER_API void emit_label(GVJ_t * job, emit_state_t emit_state, textlabel_t *);
     RENDER_API bool emit_once(char *message);
     RENDER_API void emit_once_reset(void);
+    RENDER_API void emit_index_free(GVC_t *gvc);
     RENDER_API void emit_map_rect(GVJ_t *job, boxf b);
     RENDER_API void endpath(path *, Agedge_t *, int, pathend_t *, bool);
     RENDER_API void epsf_init(node_t * n);
@@ -112,6 +114,8 @@ extern "C" {
     RENDER_API void makeSelfEdge(edge_t * edges[], int ind, int cnt,
 	double sizex, double sizey, splineInfo * sinfo);
     RENDER_API textlabel_t *make_label(void *obj, char *str, int kind, double fontsize, char *fontname, char *fontcolor);
+    /// give a node's polygon its own vertices, so they can be modified
+    RENDER_API pointf *unshare_vertices(polygon_t *poly);
     RENDER_API bezier *new_spline(edge_t *e, size_t sz);
     RENDER_API char **parse_style(char *s);
     RENDER_API void place_graph_label(Agraph_t *);
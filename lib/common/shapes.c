@@ -12,12 +12,15 @@
 #include <cgraph/alloc.h>
 #include <cgraph/streq.h>
 #include <cgraph/unreachable.h>
+#include <common/displaylist.h>
 #include <common/render.h>
 #include <common/htmltable.h>
 #include <limits.h>
 #include <math.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #define RBCONST 12
 #define RBCURVE .5
@@ -1842,6 +1845,406 @@ bool isPolygon(node_t * n)
     return ND_shape(n) && ND_shape(n)->fns->initfn == poly_init;
 }
 
+/* Polygon geometry depends only on a handful of parameters, and graphs
+ * typically have few distinct combinations of these over many nodes. So the
+ * computed vertices are cached and shared between nodes' polygon_t, which
+ * then carry the SHAREDVERTICES option. Vertices must not be modified in
+ * place unless unshare_vertices() has been called first.
+ */
+
+/// everything the vertices of a polygonal shape are computed from
+typedef struct {
+    const void *generator;	///< poly_desc_t of a generated shape, or NULL
+    size_t sides;
+    size_t peripheries;
+    double orientation;
+    double distortion;
+    double skew;
+    double width;		///< requested width, in points
+    double height;		///< requested height, in points
+    pointf bb;			///< minimum size to hold the label, in points
+    double penwidth;
+    bool isBox;
+} poly_geom_key_t;
+
+/// cached vertices of a polygonal shape
+typedef struct poly_geom_s {
+    poly_geom_key_t key;
+    struct poly_geom_s *next;	///< next entry in the same hash bucket
+    size_t refcount;		///< number of polygon_t using the vertices
+    size_t sides;		///< sides, as adjusted for ellipses
+    pointf bb;			///< bounding box of the outermost periphery
+    pointf outline_bb;		///< bounding box including the pen width
+    size_t nvertices;
+    pointf vertices[];
+} poly_geom_t;
+
+static struct {
+    poly_geom_t **buckets;
+    size_t capacity;		///< number of buckets, a power of 2
+    size_t size;		///< number of entries
+} PolyGeoms;
+
+static poly_geom_t *poly_geom_alloc(size_t nvertices)
+{
+    poly_geom_t *geom = gv_alloc(sizeof(poly_geom_t) + nvertices * sizeof(pointf));
+    geom->nvertices = nvertices;
+    return geom;
+}
+
+static poly_geom_t *poly_geom_of(pointf *vertices)
+{
+    return (poly_geom_t *)((char *)vertices - offsetof(poly_geom_t, vertices));
+}
+
+static uint64_t hash_mix(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static uint64_t hash_double(uint64_t h, double d)
+{
+    uint64_t bits;
+    d += 0.0;			/* equate -0 with 0 */
+    memcpy(&bits, &d, sizeof(bits));
+    return hash_mix(h, bits);
+}
+
+static size_t poly_geom_hash(const poly_geom_key_t *key)
+{
+    uint64_t h = hash_mix(0, (uint64_t)(uintptr_t)key->generator);
+    h = hash_mix(h, key->sides);
+    h = hash_mix(h, key->peripheries);
+    h = hash_double(h, key->orientation);
+    h = hash_double(h, key->distortion);
+    h = hash_double(h, key->skew);
+    h = hash_double(h, key->width);
+    h = hash_double(h, key->height);
+    h = hash_double(h, key->bb.x);
+    h = hash_double(h, key->bb.y);
+    h = hash_double(h, key->penwidth);
+    h = hash_mix(h, key->isBox);
+    return (size_t)h;
+}
+
+static bool poly_geom_eq(const poly_geom_key_t *a, const poly_geom_key_t *b)
+{
+    return a->generator == b->generator && a->sides == b->sides
+	&& a->peripheries == b->peripheries
+	&& a->orientation == b->orientation
+	&& a->distortion == b->distortion && a->skew == b->skew
+	&& a->width == b->width && a->height == b->height
+	&& a->bb.x == b->bb.x && a->bb.y == b->bb.y
+	&& a->penwidth == b->penwidth && a->isBox == b->isBox;
+}
+
+static void poly_geom_grow(void)
+{
+    const size_t capacity = PolyGeoms.capacity == 0 ? 64 : PolyGeoms.capacity * 2;
+    poly_geom_t **buckets = gv_calloc(capacity, sizeof(poly_geom_t *));
+    for (size_t i = 0; i < PolyGeoms.capacity; i++) {
+	for (poly_geom_t *g = PolyGeoms.buckets[i], *next; g; g = next) {
+	    next = g->next;
+	    const size_t b = poly_geom_hash(&g->key) & (capacity - 1);
+	    g->next = buckets[b];
+	    buckets[b] = g;
+	}
+    }
+    free(PolyGeoms.buckets);
+    PolyGeoms.buckets = buckets;
+    PolyGeoms.capacity = capacity;
+}
+
+static poly_geom_t *poly_geom_make(const poly_geom_key_t *key);
+
+/* poly_geom_acquire:
+ * Return the geometry for the given parameters, computing it if it is not
+ * already cached, and take a reference to it.
+ */
+static poly_geom_t *poly_geom_acquire(const poly_geom_key_t *key)
+{
+    if (PolyGeoms.size >= PolyGeoms.capacity)
+	poly_geom_grow();
+    const size_t b = poly_geom_hash(key) & (PolyGeoms.capacity - 1);
+    for (poly_geom_t *g = PolyGeoms.buckets[b]; g; g = g->next) {
+	if (poly_geom_eq(&g->key, key)) {
+	    g->refcount++;
+	    return g;
+	}
+    }
+    poly_geom_t *geom = poly_geom_make(key);
+    geom->refcount = 1;
+    geom->next = PolyGeoms.buckets[b];
+    PolyGeoms.buckets[b] = geom;
+    PolyGeoms.size++;
+    return geom;
+}
+
+static void poly_geom_release(pointf *vertices)
+{
+    poly_geom_t *geom = poly_geom_of(vertices);
+    if (--geom->refcount > 0)
+	return;
+    const size_t b = poly_geom_hash(&geom->key) & (PolyGeoms.capacity - 1);
+    for (poly_geom_t **g = &PolyGeoms.buckets[b]; *g; g = &(*g)->next) {
+	if (*g == geom) {
+	    *g = geom->next;
+	    break;
+	}
+    }
+    free(geom);
+    if (--PolyGeoms.size == 0) {
+	free(PolyGeoms.buckets);
+	PolyGeoms.buckets = NULL;
+	PolyGeoms.capacity = 0;
+    }
+}
+
+pointf *unshare_vertices(polygon_t *poly)
+{
+    if (poly->option & SHAREDVERTICES) {
+	const poly_geom_t *geom = poly_geom_of(poly->vertices);
+	pointf *vertices = gv_calloc(geom->nvertices, sizeof(pointf));
+	memcpy(vertices, geom->vertices, geom->nvertices * sizeof(pointf));
+	poly_geom_release(poly->vertices);
+	poly->vertices = vertices;
+	poly->option &= ~SHAREDVERTICES;
+    }
+    return poly->vertices;
+}
+/* poly_geom_make:
+ * Compute the vertices of all peripheries, and the outline, of a polygonal
+ * shape, along with its resulting bounding boxes.
+ */
+static poly_geom_t *poly_geom_make(const poly_geom_key_t *key)
+{
+    poly_geom_t *geom;
+    pointf *vertices;
+    pointf bb = key->bb, outline_bb;
+    double temp, alpha, beta, gamma;
+    double sectorangle, sidelength, skewdist, gdistortion, gskew;
+    double angle, sinx = 0, cosx = 0, xmax, ymax, scalex, scaley;
+    const size_t peripheries = key->peripheries;
+    size_t sides = key->sides;
+    const double orientation = key->orientation;
+    const double distortion = key->distortion;
+    const double skew = key->skew;
+    const double width = key->width;
+    const double height = key->height;
+    const double penwidth = key->penwidth;
+    const bool isBox = key->isBox;
+
+    size_t outp = peripheries;
+    if (peripheries < 1)
+	outp = 1;
+
+    if (peripheries >= 1 && penwidth > 0) {
+        // allocate extra vertices representing the outline, i.e., the outermost
+        // periphery with penwidth taken into account
+        ++outp;
+    }
+
+    if (sides < 3) {		/* ellipses */
+	sides = 2;
+	geom = poly_geom_alloc(outp * sides);
+	vertices = geom->vertices;
+	pointf P = {.x = bb.x / 2., .y = bb.y / 2.};
+	vertices[0] = (pointf){.x = -P.x, .y = -P.y};
+	vertices[1] = P;
+	if (peripheries > 1) {
+	    for (size_t j = 1, i = 2; j < peripheries; j++) {
+		P.x += GAP;
+		P.y += GAP;
+		vertices[i] = (pointf){.x = -P.x, .y = -P.y};
+		i++;
+		vertices[i] = P;
+		i++;
+	    }
+	    bb.x = 2. * P.x;
+	    bb.y = 2. * P.y;
+	}
+	outline_bb = bb;
+	if (outp > peripheries) {
+	  // add an outline at half the penwidth outside the outermost periphery
+	  P.x += penwidth / 2;
+	  P.y += penwidth / 2;
+	  size_t i = sides * peripheries;
+	  vertices[i] = (pointf){.x = -P.x, .y = -P.y};
+	  i++;
+	  vertices[i] = P;
+	  i++;
+	  outline_bb.x = 2. * P.x;
+	  outline_bb.y = 2. * P.y;
+	}
+    } else {
+
+/*
+ * FIXME - this code is wrong - it doesn't work for concave boundaries.
+ *          (e.g. "folder"  or "promoter")
+ *   I don't think it even needs sectorangle, or knowledge of skewed shapes.
+ *   (Concepts that only work for convex regular (modulo skew/distort) polygons.)
+ *
+ *   I think it only needs to know inside v. outside (by always drawing
+ *   boundaries clockwise, say),  and the two adjacent segments.
+ *
+ *   It needs to find the point where the two lines, parallel to
+ *   the current segments, and outside by GAP distance, intersect.   
+ */
+
+	geom = poly_geom_alloc(outp * sides);
+	vertices = geom->vertices;
+	if (key->generator) {
+	    const poly_desc_t* pd = key->generator;
+	    pd->vertex_gen (vertices, &bb);
+	    xmax = bb.x/2;
+	    ymax = bb.y/2;
+	} else {
+	    sectorangle = 2. * M_PI / (double)sides;
+	    sidelength = sin(sectorangle / 2.);
+	    skewdist = hypot(fabs(distortion) + fabs(skew), 1.);
+	    gdistortion = distortion * SQRT2 / cos(sectorangle / 2.);
+	    gskew = skew / 2.;
+	    angle = (sectorangle - M_PI) / 2.;
+	    sincos(angle, &sinx, &cosx);
+	    pointf R = {.x = .5 * cosx, .y = .5 * sinx};
+	    xmax = ymax = 0.;
+	    angle += (M_PI - sectorangle) / 2.;
+	    for (size_t i = 0; i < sides; i++) {
+
+	    /*next regular vertex */
+		angle += sectorangle;
+		sincos(angle, &sinx, &cosx);
+		R.x += sidelength * cosx;
+		R.y += sidelength * sinx;
+
+	    /*distort and skew */
+		pointf P = {
+		  .x = R.x * (skewdist + R.y * gdistortion) + R.y * gskew,
+		  .y = R.y};
+
+	    /*orient P.x,P.y */
+		alpha = RADIANS(orientation) + atan2(P.y, P.x);
+		sincos(alpha, &sinx, &cosx);
+		P.x = P.y = hypot(P.x, P.y);
+		P.x *= cosx;
+		P.y *= sinx;
+
+	    /*scale for label */
+		P.x *= bb.x;
+		P.y *= bb.y;
+
+	    /*find max for bounding box */
+		xmax = MAX(fabs(P.x), xmax);
+		ymax = MAX(fabs(P.y), ymax);
+
+	    /* store result in array of points */
+		vertices[i] = P;
+		if (isBox) { /* enforce exact symmetry of box */
+		    vertices[1] = (pointf){.x = -P.x, .y = P.y};
+		    vertices[2] = (pointf){.x = -P.x, .y = -P.y};
+		    vertices[3] = (pointf){.x = P.x, .y = -P.y};
+		    break;
+		}
+	    }
+	}
+
+	/* apply minimum dimensions */
+	xmax *= 2.;
+	ymax *= 2.;
+	bb = (pointf){.x = MAX(width, xmax), .y = MAX(height, ymax)};
+	outline_bb = bb;
+
+	scalex = bb.x / xmax;
+	scaley = bb.y / ymax;
+
+	size_t i;
+	for (i = 0; i < sides; i++) {
+	    pointf P = vertices[i];
+	    P.x *= scalex;
+	    P.y *= scaley;
+	    vertices[i] = P;
+	}
+
+	if (outp > 1) {
+	    pointf R = vertices[0];
+	    pointf Q;
+	    for (size_t j = 1; j < sides; j++) {
+		Q = vertices[(i - j) % sides];
+		if (Q.x != R.x || Q.y != R.y) {
+		    break;
+		}
+	    }
+	    assert(R.x != Q.x || R.y != Q.y);
+	    beta = atan2(R.y - Q.y, R.x - Q.x);
+	    pointf Qprev = Q;
+	    for (i = 0; i < sides; i++) {
+
+		/*for each vertex find the bisector */
+		Q = vertices[i];
+		if (Q.x == Qprev.x && Q.y == Qprev.y) {
+		    // The vertex points for the side ending at Q are equal,
+		    // i.e. this side is actually a point and its angle is
+		    // undefined. Therefore we keep the same offset for the end
+		    // point as already calculated for the start point. This may
+		    // occur for shapes which are represented as polygons during
+		    // layout, but are drawn using bezier curves during
+		    // rendering, e.g. for the `cylinder` shape.
+		} else {
+		    for (size_t j = 1; j < sides; j++) {
+			R = vertices[(i + j) % sides];
+			if (R.x != Q.x || R.y != Q.y) {
+			    break;
+			}
+		    }
+		    assert(R.x != Q.x || R.y != Q.y);
+		    alpha = beta;
+		    beta = atan2(R.y - Q.y, R.x - Q.x);
+		    gamma = (alpha + M_PI - beta) / 2.;
+
+		    /*find distance along bisector to */
+		    /*intersection of next periphery */
+		    temp = GAP / sin(gamma);
+
+		    /*convert this distance to x and y */
+		    sincos(alpha - gamma, &sinx, &cosx);
+		    sinx *= temp;
+		    cosx *= temp;
+		}
+		assert(cosx != 0 || sinx != 0);
+		Qprev = Q;
+
+		/*save the vertices of all the */
+		/*peripheries at this base vertex */
+		for (size_t j = 1; j < peripheries; j++) {
+		    Q.x += cosx;
+		    Q.y += sinx;
+		    vertices[i + j * sides] = Q;
+		}
+		if (outp > peripheries) {
+		    // add an outline at half the penwidth outside the outermost periphery
+		    Q.x += cosx * penwidth / 2 / GAP;
+		    Q.y += sinx * penwidth / 2 / GAP;
+		    vertices[i + peripheries * sides] = Q;
+		}
+	    }
+	    for (i = 0; i < sides; i++) {
+		pointf P = vertices[i + (peripheries - 1) * sides];
+		bb = (pointf){.x = MAX(2. * fabs(P.x), bb.x),
+		              .y = MAX(2. * fabs(P.y), bb.y)};
+		Q = vertices[i + (outp - 1) * sides];
+		outline_bb = (pointf){.x = MAX(2. * fabs(Q.x), outline_bb.x),
+		                      .y = MAX(2. * fabs(Q.y), outline_bb.y)};
+	    }
+	}
+    }
+    geom->key = *key;
+    geom->sides = sides;
+    geom->bb = bb;
+    geom->outline_bb = outline_bb;
+    return geom;
+}
+
 static void poly_init(node_t * n)
 {
     pointf dimen, min_bb;
@@ -1849,10 +2252,8 @@ static void poly_init(node_t * n)
     point imagesize;
     pointf *vertices;
     char *p, *sfile, *fxd;
-    double temp, alpha, beta, gamma;
+    double temp;
     double orientation, distortion, skew;
-    double sectorangle, sidelength, skewdist, gdistortion, gskew;
-    double angle, sinx = 0, cosx = 0, xmax, ymax, scalex, scaley;
     double width, height, marginx, marginy, spacex;
     polygon_t *poly = gv_alloc(sizeof(polygon_t));
     bool isPlain = IS_PLAIN(n);
@@ -2064,207 +2465,23 @@ static void poly_init(node_t * n)
 
     const double penwidth = late_int(n, N_penwidth, DEFAULT_NODEPENWIDTH, MIN_NODEPENWIDTH);
 
-    size_t outp = peripheries;
-    if (peripheries < 1)
-	outp = 1;
-
-    if (peripheries >= 1 && penwidth > 0) {
-        // allocate extra vertices representing the outline, i.e., the outermost
-        // periphery with penwidth taken into account
-        ++outp;
-    }
-
-    if (sides < 3) {		/* ellipses */
-	sides = 2;
-	vertices = gv_calloc(outp * sides, sizeof(pointf));
-	pointf P = {.x = bb.x / 2., .y = bb.y / 2.};
-	vertices[0] = (pointf){.x = -P.x, .y = -P.y};
-	vertices[1] = P;
-	if (peripheries > 1) {
-	    for (size_t j = 1, i = 2; j < peripheries; j++) {
-		P.x += GAP;
-		P.y += GAP;
-		vertices[i] = (pointf){.x = -P.x, .y = -P.y};
-		i++;
-		vertices[i] = P;
-		i++;
-	    }
-	    bb.x = 2. * P.x;
-	    bb.y = 2. * P.y;
-	}
-	outline_bb = bb;
-	if (outp > peripheries) {
-	  // add an outline at half the penwidth outside the outermost periphery
-	  P.x += penwidth / 2;
-	  P.y += penwidth / 2;
-	  size_t i = sides * peripheries;
-	  vertices[i] = (pointf){.x = -P.x, .y = -P.y};
-	  i++;
-	  vertices[i] = P;
-	  i++;
-	  outline_bb.x = 2. * P.x;
-	  outline_bb.y = 2. * P.y;
-	}
-    } else {
-
-/*
- * FIXME - this code is wrong - it doesn't work for concave boundaries.
- *          (e.g. "folder"  or "promoter")
- *   I don't think it even needs sectorangle, or knowledge of skewed shapes.
- *   (Concepts that only work for convex regular (modulo skew/distort) polygons.)
- *
- *   I think it only needs to know inside v. outside (by always drawing
- *   boundaries clockwise, say),  and the two adjacent segments.
- *
- *   It needs to find the point where the two lines, parallel to
- *   the current segments, and outside by GAP distance, intersect.   
- */
-
-	vertices = gv_calloc(outp * sides, sizeof(pointf));
-	if (ND_shape(n)->polygon->vertices) {
-	    poly_desc_t* pd = (poly_desc_t*)ND_shape(n)->polygon->vertices;
-	    pd->vertex_gen (vertices, &bb);
-	    xmax = bb.x/2;
-	    ymax = bb.y/2;
-	} else {
-	    sectorangle = 2. * M_PI / (double)sides;
-	    sidelength = sin(sectorangle / 2.);
-	    skewdist = hypot(fabs(distortion) + fabs(skew), 1.);
-	    gdistortion = distortion * SQRT2 / cos(sectorangle / 2.);
-	    gskew = skew / 2.;
-	    angle = (sectorangle - M_PI) / 2.;
-	    sincos(angle, &sinx, &cosx);
-	    pointf R = {.x = .5 * cosx, .y = .5 * sinx};
-	    xmax = ymax = 0.;
-	    angle += (M_PI - sectorangle) / 2.;
-	    for (size_t i = 0; i < sides; i++) {
-
-	    /*next regular vertex */
-		angle += sectorangle;
-		sincos(angle, &sinx, &cosx);
-		R.x += sidelength * cosx;
-		R.y += sidelength * sinx;
-
-	    /*distort and skew */
-		pointf P = {
-		  .x = R.x * (skewdist + R.y * gdistortion) + R.y * gskew,
-		  .y = R.y};
-
-	    /*orient P.x,P.y */
-		alpha = RADIANS(orientation) + atan2(P.y, P.x);
-		sincos(alpha, &sinx, &cosx);
-		P.x = P.y = hypot(P.x, P.y);
-		P.x *= cosx;
-		P.y *= sinx;
-
-	    /*scale for label */
-		P.x *= bb.x;
-		P.y *= bb.y;
-
-	    /*find max for bounding box */
-		xmax = MAX(fabs(P.x), xmax);
-		ymax = MAX(fabs(P.y), ymax);
-
-	    /* store result in array of points */
-		vertices[i] = P;
-		if (isBox) { /* enforce exact symmetry of box */
-		    vertices[1] = (pointf){.x = -P.x, .y = P.y};
-		    vertices[2] = (pointf){.x = -P.x, .y = -P.y};
-		    vertices[3] = (pointf){.x = P.x, .y = -P.y};
-		    break;
-		}
-	    }
-	}
-
-	/* apply minimum dimensions */
-	xmax *= 2.;
-	ymax *= 2.;
-	bb = (pointf){.x = MAX(width, xmax), .y = MAX(height, ymax)};
-	outline_bb = bb;
-
-	scalex = bb.x / xmax;
-	scaley = bb.y / ymax;
-
-	size_t i;
-	for (i = 0; i < sides; i++) {
-	    pointf P = vertices[i];
-	    P.x *= scalex;
-	    P.y *= scaley;
-	    vertices[i] = P;
-	}
-
-	if (outp > 1) {
-	    pointf R = vertices[0];
-	    pointf Q;
-	    for (size_t j = 1; j < sides; j++) {
-		Q = vertices[(i - j) % sides];
-		if (Q.x != R.x || Q.y != R.y) {
-		    break;
-		}
-	    }
-	    assert(R.x != Q.x || R.y != Q.y);
-	    beta = atan2(R.y - Q.y, R.x - Q.x);
-	    pointf Qprev = Q;
-	    for (i = 0; i < sides; i++) {
-
-		/*for each vertex find the bisector */
-		Q = vertices[i];
-		if (Q.x == Qprev.x && Q.y == Qprev.y) {
-		    // The vertex points for the side ending at Q are equal,
-		    // i.e. this side is actually a point and its angle is
-		    // undefined. Therefore we keep the same offset for the end
-		    // point as already calculated for the start point. This may
-		    // occur for shapes which are represented as polygons during
-		    // layout, but are drawn using bezier curves during
-		    // rendering, e.g. for the `cylinder` shape.
-		} else {
-		    for (size_t j = 1; j < sides; j++) {
-			R = vertices[(i + j) % sides];
-			if (R.x != Q.x || R.y != Q.y) {
-			    break;
-			}
-		    }
-		    assert(R.x != Q.x || R.y != Q.y);
-		    alpha = beta;
-		    beta = atan2(R.y - Q.y, R.x - Q.x);
-		    gamma = (alpha + M_PI - beta) / 2.;
-
-		    /*find distance along bisector to */
-		    /*intersection of next periphery */
-		    temp = GAP / sin(gamma);
-
-		    /*convert this distance to x and y */
-		    sincos(alpha - gamma, &sinx, &cosx);
-		    sinx *= temp;
-		    cosx *= temp;
-		}
-		assert(cosx != 0 || sinx != 0);
-		Qprev = Q;
-
-		/*save the vertices of all the */
-		/*peripheries at this base vertex */
-		for (size_t j = 1; j < peripheries; j++) {
-		    Q.x += cosx;
-		    Q.y += sinx;
-		    vertices[i + j * sides] = Q;
-		}
-		if (outp > peripheries) {
-		    // add an outline at half the penwidth outside the outermost periphery
-		    Q.x += cosx * penwidth / 2 / GAP;
-		    Q.y += sinx * penwidth / 2 / GAP;
-		    vertices[i + peripheries * sides] = Q;
-		}
-	    }
-	    for (i = 0; i < sides; i++) {
-		pointf P = vertices[i + (peripheries - 1) * sides];
-		bb = (pointf){.x = MAX(2. * fabs(P.x), bb.x),
-		              .y = MAX(2. * fabs(P.y), bb.y)};
-		Q = vertices[i + (outp - 1) * sides];
-		outline_bb = (pointf){.x = MAX(2. * fabs(Q.x), outline_bb.x),
-		                      .y = MAX(2. * fabs(Q.y), outline_bb.y)};
-	    }
-	}
-    }
+    poly_geom_key_t key = {.generator = ND_shape(n)->polygon->vertices,
+                           .sides = sides,
+                           .peripheries = peripheries,
+                           .orientation = orientation,
+                           .distortion = distortion,
+                           .skew = skew,
+                           .width = width,
+                           .height = height,
+                           .bb = bb,
+                           .penwidth = penwidth,
+                           .isBox = isBox};
+    poly_geom_t *geom = poly_geom_acquire(&key);
+    sides = geom->sides;
+    bb = geom->bb;
+    outline_bb = geom->outline_bb;
+    vertices = geom->vertices;
+    poly->option |= SHAREDVERTICES;
     poly->regular = regular;
     poly->peripheries = peripheries;
     poly->sides = sides;
@@ -2293,7 +2510,10 @@ static void poly_free(node_t * n)
     polygon_t *p = ND_shape_info(n);
 
     if (p) {
-	free(p->vertices);
+	if (p->option & SHAREDVERTICES)
+	    poly_geom_release(p->vertices);
+	else
+	    free(p->vertices);
 	free(p);
     }
 }
@@ -3956,6 +4176,8 @@ static void epsf_gencode(GVJ_t * job, node_t * n)
 	gvrender_begin_anchor(job,
 			      obj->url, obj->tooltip, obj->target,
 			      obj->id);
+    /* the shape is written straight to the output, not through gvrender */
+    displaylist_abort(job);
     if (desc)
 	fprintf(job->output_file,
 		"%.5g %.5g translate newpath user_shape_%d\n",
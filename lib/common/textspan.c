@@ -13,14 +13,24 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <cdt/cdt.h>
 #include <common/render.h>
 #include <common/textspan_lut.h>
+#include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
 #include <cgraph/strcasecmp.h>
+#include <gvc/gvcint.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 /* estimate_textspan_size:
  * Estimate size of textspan, for given face and size, in points.
@@ -75,6 +85,250 @@ static PostscriptAlias* translate_postscript_fontname(char* fontname)
     return result;
 }
 
+/* Memoised span metrics.
+ *
+ * Measuring a span through the textlayout plugin is by far the most expensive
+ * part of sizing a label, and the same few strings tend to recur in a font
+ * throughout a graph. So textspan_size remembers the metrics of every
+ * (font name, size, flags, text) it measures and answers repeats from the
+ * table. Only the metrics are kept: a span answered from the table carries no
+ * plugin layout, and renderers that draw through one build it on demand.
+ *
+ * If the GV_TEXT_CACHE environment variable names a file, the table is read
+ * from it on first use and written back when the context is freed, so later
+ * runs need not measure text they have seen before. The file is tagged with
+ * the Graphviz version and the textlayout plugin, and is ignored if either
+ * differs from the running one.
+ */
+
+typedef struct textspan_metrics_s textspan_metrics_t;
+struct textspan_metrics_s {
+    textspan_metrics_t *next;
+    size_t hash;
+    double fontsize;
+    unsigned flags;
+    pointf size;
+    double yoffset_layout, yoffset_centerline;
+    size_t fontname_len, str_len;
+    char key[]; ///< font name, then text, each NUL terminated
+};
+
+struct textspan_cache_s {
+    textspan_metrics_t **buckets;
+    size_t capacity;
+    size_t size;
+    char *path; ///< persistent copy of the table, or NULL
+    char *tag;  ///< identifies the producer of the persistent copy
+    bool dirty; ///< entries were added since loading
+};
+
+#define TEXT_CACHE_MAGIC "GVTXTC1\n"
+#define TEXT_CACHE_BOM 0x01020304u
+
+static size_t text_cache_hash(const char *fontname, double fontsize,
+                              unsigned flags, const char *str)
+{
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (const char *p = fontname; *p; ++p)
+	h = (h ^ (unsigned char)*p) * 1099511628211ull;
+    h = (h ^ 0xff) * 1099511628211ull;
+    for (const char *p = str; *p; ++p)
+	h = (h ^ (unsigned char)*p) * 1099511628211ull;
+    uint64_t bits;
+    memcpy(&bits, &fontsize, sizeof(bits));
+    h = (h ^ bits) * 1099511628211ull;
+    h = (h ^ flags) * 1099511628211ull;
+    return (size_t)(h ^ (h >> 32));
+}
+
+static void text_cache_grow(struct textspan_cache_s *c)
+{
+    size_t capacity = c->capacity == 0 ? 256 : c->capacity * 2;
+    textspan_metrics_t **buckets = gv_calloc(capacity, sizeof(buckets[0]));
+    for (size_t i = 0; i < c->capacity; ++i) {
+	for (textspan_metrics_t *m = c->buckets[i], *next; m; m = next) {
+	    next = m->next;
+	    m->next = buckets[m->hash & (capacity - 1)];
+	    buckets[m->hash & (capacity - 1)] = m;
+	}
+    }
+    free(c->buckets);
+    c->buckets = buckets;
+    c->capacity = capacity;
+}
+
+static textspan_metrics_t *text_cache_find(const struct textspan_cache_s *c,
+                                           size_t hash, const char *fontname,
+                                           double fontsize, unsigned flags,
+                                           const char *str)
+{
+    if (c->capacity == 0)
+	return NULL;
+    for (textspan_metrics_t *m = c->buckets[hash & (c->capacity - 1)]; m;
+         m = m->next) {
+	if (m->hash == hash && m->fontsize == fontsize && m->flags == flags &&
+	    strcmp(m->key, fontname) == 0 &&
+	    strcmp(m->key + m->fontname_len + 1, str) == 0)
+	    return m;
+    }
+    return NULL;
+}
+
+static textspan_metrics_t *text_cache_add(struct textspan_cache_s *c,
+                                          const char *fontname,
+                                          size_t fontname_len, double fontsize,
+                                          unsigned flags, const char *str,
+                                          size_t str_len)
+{
+    if (c->size >= c->capacity / 2)
+	text_cache_grow(c);
+    textspan_metrics_t *m =
+	gv_alloc(sizeof(*m) + fontname_len + 1 + str_len + 1);
+    memcpy(m->key, fontname, fontname_len);
+    m->key[fontname_len] = '\0';
+    memcpy(m->key + fontname_len + 1, str, str_len);
+    m->key[fontname_len + 1 + str_len] = '\0';
+    m->fontname_len = fontname_len;
+    m->str_len = str_len;
+    m->fontsize = fontsize;
+    m->flags = flags;
+    m->hash = text_cache_hash(m->key, fontsize, flags, m->key + fontname_len + 1);
+    m->next = c->buckets[m->hash & (c->capacity - 1)];
+    c->buckets[m->hash & (c->capacity - 1)] = m;
+    ++c->size;
+    return m;
+}
+
+/// read a persistent copy of the table, ignoring it if it is not ours
+static void text_cache_load(struct textspan_cache_s *c)
+{
+    FILE *f = fopen(c->path, "rb");
+    if (f == NULL)
+	return;
+    agxbuf buf = {0};
+    char chunk[BUFSIZ];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+	agxbput_n(&buf, chunk, n);
+    fclose(f);
+    const size_t len = agxblen(&buf);
+    const char *data = agxbuse(&buf);
+    const char *const end = data + len;
+
+#define TAKE(dst, n) \
+    do { \
+	if ((size_t)(end - data) < (n)) \
+	    goto done; \
+	memcpy((dst), data, (n)); \
+	data += (n); \
+    } while (0)
+
+    char magic[sizeof(TEXT_CACHE_MAGIC) - 1];
+    uint32_t bom, tag_len;
+    TAKE(magic, sizeof(magic));
+    TAKE(&bom, sizeof(bom));
+    TAKE(&tag_len, sizeof(tag_len));
+    if (memcmp(magic, TEXT_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        bom != TEXT_CACHE_BOM || tag_len != strlen(c->tag) ||
+        (size_t)(end - data) < tag_len || memcmp(data, c->tag, tag_len) != 0)
+	goto done;
+    data += tag_len;
+
+    while (data < end) {
+	uint32_t lens[3];
+	double values[5];
+	TAKE(lens, sizeof(lens));
+	TAKE(values, sizeof(values));
+	if ((size_t)(end - data) < (size_t)lens[0] + lens[1])
+	    goto done;
+	const char *fontname = data;
+	const char *str = data + lens[0];
+	data += (size_t)lens[0] + lens[1];
+	// entries are NUL terminated, so their strings cannot contain NUL
+	if (memchr(fontname, '\0', (size_t)lens[0] + lens[1]))
+	    goto done;
+	textspan_metrics_t *m =
+	    text_cache_add(c, fontname, lens[0], values[0], lens[2], str, lens[1]);
+	m->size.x = values[1];
+	m->size.y = values[2];
+	m->yoffset_layout = values[3];
+	m->yoffset_centerline = values[4];
+    }
+#undef TAKE
+
+done:
+    agxbfree(&buf);
+}
+
+/// write the table out, replacing any previous copy
+static void text_cache_save(const struct textspan_cache_s *c)
+{
+    agxbuf tmp = {0};
+    agxbprint(&tmp, "%s.%d.tmp", c->path, (int)getpid());
+    const char *tmpname = agxbuse(&tmp);
+    FILE *f = fopen(tmpname, "wb");
+    if (f == NULL) {
+	agwarningf("could not write text cache %s: %s\n", c->path,
+	           strerror(errno));
+	agxbfree(&tmp);
+	return;
+    }
+
+    const uint32_t bom = TEXT_CACHE_BOM;
+    const uint32_t tag_len = (uint32_t)strlen(c->tag);
+    fwrite(TEXT_CACHE_MAGIC, 1, sizeof(TEXT_CACHE_MAGIC) - 1, f);
+    fwrite(&bom, sizeof(bom), 1, f);
+    fwrite(&tag_len, sizeof(tag_len), 1, f);
+    fwrite(c->tag, 1, tag_len, f);
+    for (size_t i = 0; i < c->capacity; ++i) {
+	for (const textspan_metrics_t *m = c->buckets[i]; m; m = m->next) {
+	    if (m->fontname_len > UINT32_MAX || m->str_len > UINT32_MAX)
+		continue;
+	    const uint32_t lens[] = {(uint32_t)m->fontname_len,
+	                             (uint32_t)m->str_len, m->flags};
+	    const double values[] = {m->fontsize, m->size.x, m->size.y,
+	                             m->yoffset_layout, m->yoffset_centerline};
+	    fwrite(lens, sizeof(lens), 1, f);
+	    fwrite(values, sizeof(values), 1, f);
+	    fwrite(m->key, 1, m->fontname_len, f);
+	    fwrite(m->key + m->fontname_len + 1, 1, m->str_len, f);
+	}
+    }
+
+    if (ferror(f) | fclose(f)) {
+	agwarningf("could not write text cache %s\n", c->path);
+	remove(tmpname);
+    } else if (rename(tmpname, c->path) != 0) {
+	// Windows does not let rename replace an existing file
+	remove(c->path);
+	if (rename(tmpname, c->path) != 0) {
+	    agwarningf("could not write text cache %s: %s\n", c->path,
+	               strerror(errno));
+	    remove(tmpname);
+	}
+    }
+    agxbfree(&tmp);
+}
+
+static struct textspan_cache_s *text_cache(GVC_t *gvc)
+{
+    if (gvc->textspan_cache)
+	return gvc->textspan_cache;
+
+    struct textspan_cache_s *c = gv_alloc(sizeof(*c));
+    const char *filename = getenv("GV_TEXT_CACHE");
+    if (filename && *filename) {
+	agxbuf tag = {0};
+	agxbprint(&tag, "%s %s %s", gvc->common.info[1], gvc->common.info[2],
+	          gvc->textlayout.type ? gvc->textlayout.type : "estimate");
+	c->tag = agxbdisown(&tag);
+	c->path = gv_strdup(filename);
+	text_cache_load(c);
+    }
+    gvc->textspan_cache = c;
+    return c;
+}
+
 pointf textspan_size(GVC_t *gvc, textspan_t * span)
 /// Estimates size of a textspan, in points.
 {
@@ -93,6 +347,23 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
     if (Verbose && emit_once(font->name))
 	fpp = &fontpath;
 
+    struct textspan_cache_s *cache = text_cache(gvc);
+    const char *str = span->str ? span->str : "";
+    const size_t hash = text_cache_hash(font->name, font->size, font->flags, str);
+    textspan_metrics_t *m = NULL;
+
+    /* when asked to report the font path, go to the plugin regardless */
+    if (!fpp)
+	m = text_cache_find(cache, hash, font->name, font->size, font->flags, str);
+    if (m) {
+	span->size = m->size;
+	span->yoffset_layout = m->yoffset_layout;
+	span->yoffset_centerline = m->yoffset_centerline;
+	span->layout = NULL;
+	span->free_layout = NULL;
+	return span->size;
+    }
+
     if (! gvtextlayout(gvc, span, fpp))
 	estimate_textspan_size(span, fpp);
 
@@ -104,6 +375,15 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
 	    fprintf(stderr, "fontname: unable to resolve \"%s\"\n", font->name);
     }
 
+    if (!text_cache_find(cache, hash, font->name, font->size, font->flags, str)) {
+	m = text_cache_add(cache, font->name, strlen(font->name), font->size,
+	                   font->flags, str, strlen(str));
+	m->size = span->size;
+	m->yoffset_layout = span->yoffset_layout;
+	m->yoffset_centerline = span->yoffset_centerline;
+	cache->dirty = true;
+    }
+
     return span->size;
 }
 
@@ -170,4 +450,21 @@ void textfont_dict_open(GVC_t *gvc) {
 void textfont_dict_close(GVC_t *gvc)
 {
     dtclose(gvc->textfont_dt);
+
+    struct textspan_cache_s *c = gvc->textspan_cache;
+    if (c) {
+	if (c->path && c->dirty)
+	    text_cache_save(c);
+	for (size_t i = 0; i < c->capacity; ++i) {
+	    for (textspan_metrics_t *m = c->buckets[i], *next; m; m = next) {
+		next = m->next;
+		free(m);
+	    }
+	}
+	free(c->buckets);
+	free(c->path);
+	free(c->tag);
+	free(c);
+	gvc->textspan_cache = NULL;
+    }
 }
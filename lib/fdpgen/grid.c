@@ -16,256 +16,179 @@
  * Support for grid to speed up layout. On each pass, nodes are
  * put into grid cells. Given a node, repulsion is only computed 
  * for nodes in one of that nodes 9 adjacent grids.
+ *
+ * The grid is rebuilt from scratch on each pass. Nodes are sorted by cell
+ * with a radix sort, so each cell is a run of a single array, and occupied
+ * cells are found through an open-addressing hash table.
  */
 
-/* uses PRIVATE interface for NOTUSED */
-#define FDP_PRIVATE 1
-
 #include <cgraph/alloc.h>
-#include <fdpgen/fdp.h>
 #include <fdpgen/grid.h>
-#include <common/macros.h>
+#include <math.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-  /* structure for maintaining a free list of cells */
-typedef struct _block {
-    cell *mem;			/* block of cells */
-    cell *cur;			/* next available cell */
-    cell *endp;			/* after last cell */
-    struct _block *next;	/* next memory block */
-} block_t;
-
-/* newBlock:
- * Create new block of size cells
- */
-static block_t *newBlock(int size)
-{
-    block_t *newb = gv_alloc(sizeof(block_t));
-    newb->next = 0;
-    newb->mem = gv_calloc(size, sizeof(cell));
-    newb->endp = newb->mem + size;
-    newb->cur = newb->mem;
-
-    return newb;
-}
-
-/* freeBlock:
- * Free malloc'ed memory and block.
- * Recurse to next block
- */
-static void freeBlock(block_t * b)
-{
-    if (b) {
-	block_t *next = b->next;
-	free(b->mem);
-	free(b);
-	freeBlock(next);
-    }
-}
-
 struct _grid {
-    Dt_t *data;			/* cells indexed by (i,j) */
-    block_t *cellMem;		/* list of memory blocks for cells */
-    block_t *cellCur;		/* current block */
-    int listSize;		/* memory of nodes */
-    node_list *listMem;		/* list of memory for node items */
-    node_list *listCur;		/* next node item */
+    size_t size;		/* capacity, in nodes */
+    uint64_t *keys;		/* cell key of each node */
+    size_t *nodes;		/* nodes, sorted by cell */
+    size_t *tmp;		/* scratch for sorting */
+    cell *cells;		/* occupied cells, in (i,j) order */
+    size_t ncells;
+    size_t *table;		/* hash table of cells, 1 + index into cells */
+    int bits;			/* table has 2^bits slots */
 };
 
-/* getCell:
- * Create a new cell using memory blocks.
- */
-static cell *getCell(Grid * g)
+/// cell key, ordering as (i,j) does
+static uint64_t cellKey(int i, int j)
 {
-    cell *cp;
-    block_t *bp = g->cellCur;	/* current block */
-
-    if (bp->cur == bp->endp) {	/* current block is full */
-	if (bp->next == 0) {
-	    bp->next = newBlock(2 * (bp->endp - bp->mem));
-	}
-	bp = g->cellCur = bp->next;
-	bp->cur = bp->mem;
-    }
-    cp = bp->cur++;
-    return cp;
+    return (uint64_t)((uint32_t)i ^ 0x80000000u) << 32
+	 | ((uint32_t)j ^ 0x80000000u);
 }
 
-static int ijcmpf(Dt_t * d, gridpt * p1, gridpt * p2, Dtdisc_t * disc)
+static size_t hashKey(const Grid * g, uint64_t key)
 {
-    (void)d;
-    (void)disc;
-
-    if (p1->i < p2->i) {
-        return -1;
-    }
-    if (p1->i > p2->i) {
-        return 1;
-    }
-    if (p1->j < p2->j) {
-        return -1;
-    }
-    if (p1->j > p2->j) {
-        return 1;
-    }
-    return 0;
+    return (size_t)((key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - g->bits));
 }
 
-static Grid _grid; // hack because can't attach info. to Dt_t
-
-/* newCell:
- * Allocate a new cell from free store and initialize its indices
- * This is used by the grid discipline to create cells.
- */
-static void *newCell(void *obj, Dtdisc_t *disc) {
-    cell *cellp = obj;
-    cell *newp;
-
-    (void)disc;
-    newp = getCell(&_grid);
-    newp->p.i = cellp->p.i;
-    newp->p.j = cellp->p.j;
-    newp->nodes = 0;
-
-    return newp;
-}
-
-/* newNode:
- * Allocate a new node item from free store. 
- * Set node value and hook into list.
- * A grid assumes the memory allocated in adjustGrid
- * will be enough more all nodes added.
- */
-static node_list *newNode(Grid * g, Agnode_t * n, node_list * nxt)
-{
-    node_list *newp;
-
-    newp = g->listCur++;
-    newp->node = n;
-    newp->next = nxt;
-
-    return newp;
-}
-
-static Dtdisc_t gridDisc = {
-    offsetof(cell, p),
-    sizeof(gridpt),
-    offsetof(cell, link),
-    (Dtmake_f) newCell,
-    NULL,
-    (Dtcompar_f) ijcmpf,
-};
-
 /* mkGrid:
- * Create grid data structure.
- * cellHint provides rough idea of how many cells
- * may be needed.
+ * Create grid data structure for up to nnodes nodes.
  */
-Grid *mkGrid(int cellHint)
+Grid *mkGrid(size_t nnodes)
 {
-    Grid *g = &_grid;
-    memset(g, 0, sizeof(*g)); // see comment above
-    g->data = dtopen(&gridDisc, Dtoset);
-    g->cellMem = newBlock(cellHint);
+    Grid *g = gv_alloc(sizeof(Grid));
+    g->size = nnodes;
+    g->keys = gv_calloc(nnodes, sizeof(uint64_t));
+    g->nodes = gv_calloc(nnodes, sizeof(size_t));
+    g->tmp = gv_calloc(nnodes, sizeof(size_t));
+    g->cells = gv_calloc(nnodes, sizeof(cell));
+    g->bits = 1;
+    while (((size_t)1 << g->bits) < 2 * nnodes)
+	g->bits++;
+    g->table = gv_calloc((size_t)1 << g->bits, sizeof(size_t));
     return g;
 }
 
-/* adjustGrid:
- * Set up node list for grid. Make sure the list
- * can handle nnodes nodes.
- * It is assumed no more than nnodes will be added
- * to the grid.
- */
-void adjustGrid(Grid * g, int nnodes)
-{
-    int nsize;
-
-    if (nnodes > g->listSize) {
-	nsize = MAX(nnodes, 2 * g->listSize);
-	if (g->listMem)
-	    free(g->listMem);
-	g->listMem = gv_calloc(nsize, sizeof(node_list));
-	g->listSize = nsize;
-    }
-}
-
-/* clearGrid:
- * Reset grid. This clears the dictionary,
- * and reuses available memory.
- */
-void clearGrid(Grid * g)
-{
-    dtclear(g->data);
-    g->listCur = g->listMem;
-    g->cellCur = g->cellMem;
-    g->cellCur->cur = g->cellCur->mem;
-}
-
 /* delGrid:
- * Close and free all grid resources.
+ * Free all grid resources.
  */
 void delGrid(Grid * g)
 {
-    dtclose(g->data);
-    freeBlock(g->cellMem);
-    free(g->listMem);
+    if (!g)
+	return;
+    free(g->keys);
+    free(g->nodes);
+    free(g->tmp);
+    free(g->cells);
+    free(g->table);
+    free(g);
 }
 
-/* addGrid:
- * Add node n to cell (i,j) in grid g.
+/* buildGrid:
+ * Put nodes 0 … n-1, node k at (pos[2k], pos[2k+1]), into cells of the
+ * given size. Within a cell, nodes are in decreasing order.
  */
-void addGrid(Grid * g, int i, int j, Agnode_t * n)
+void buildGrid(Grid * g, size_t n, const double *pos, double cellSize)
 {
-    cell *cellp;
-    cell key;
+    size_t count[8][256] = {{0}};
+
+    for (size_t k = 0; k < n; k++) {
+	const int i = (int)floor(pos[2 * k] / cellSize);
+	const int j = (int)floor(pos[2 * k + 1] / cellSize);
+	const uint64_t key = cellKey(i, j);
+	g->keys[k] = key;
+	for (int b = 0; b < 8; b++)
+	    count[b][(key >> (8 * b)) & 0xff]++;
+    }
 
-    key.p.i = i;
-    key.p.j = j;
-    cellp = dtinsert(g->data, &key);
-    cellp->nodes = newNode(g, n, cellp->nodes);
-    if (Verbose >= 3) {
-	fprintf(stderr, "grid(%d,%d): %s\n", i, j, agnameof(n));
+    /* LSD radix sort, skipping bytes where all keys agree */
+    size_t *src = g->nodes;
+    size_t *dst = g->tmp;
+    for (size_t k = 0; k < n; k++)
+	src[k] = n - 1 - k;
+    for (int b = 0; b < 8; b++) {
+	size_t *cnt = count[b];
+	if (n > 0 && cnt[(g->keys[0] >> (8 * b)) & 0xff] == n)
+	    continue;
+	size_t sum = 0;
+	for (int d = 0; d < 256; d++) {
+	    const size_t c = cnt[d];
+	    cnt[d] = sum;
+	    sum += c;
+	}
+	for (size_t k = 0; k < n; k++) {
+	    const size_t v = src[k];
+	    dst[cnt[(g->keys[v] >> (8 * b)) & 0xff]++] = v;
+	}
+	size_t *t = src;
+	src = dst;
+	dst = t;
+    }
+    if (src != g->nodes)
+	memcpy(g->nodes, src, n * sizeof(size_t));
+
+    memset(g->table, 0, ((size_t)1 << g->bits) * sizeof(size_t));
+    g->ncells = 0;
+    for (size_t k = 0; k < n; k++) {
+	const uint64_t key = g->keys[g->nodes[k]];
+	if (k > 0 && key == g->keys[g->nodes[k - 1]]) {
+	    g->cells[g->ncells - 1].last = k + 1;
+	    continue;
+	}
+	cell *cp = &g->cells[g->ncells++];
+	cp->p.i = (int)((uint32_t)(key >> 32) ^ 0x80000000u);
+	cp->p.j = (int)((uint32_t)key ^ 0x80000000u);
+	cp->first = k;
+	cp->last = k + 1;
+	const size_t mask = ((size_t)1 << g->bits) - 1;
+	size_t h = hashKey(g, key);
+	while (g->table[h])
+	    h = (h + 1) & mask;
+	g->table[h] = g->ncells;
     }
 }
 
-typedef int (*walkfn_t)(void*, void*);
+/* gridCells:
+ * Return the occupied cells in (i,j) order, and their number in ncells.
+ */
+const cell *gridCells(const Grid * g, size_t *ncells)
+{
+    *ncells = g->ncells;
+    return g->cells;
+}
 
-/* walkGrid:
- * Apply function walkf to each cell in the grid.
- * The second argument to walkf is the cell; the
- * third argument is the grid. (The first argument
- * is the dictionary.) walkf must return 0.
+/* gridNodes:
+ * Return the nodes sorted by cell. The nodes in cell c are
+ * gridNodes(g)[c->first] … gridNodes(g)[c->last - 1].
  */
-void walkGrid(Grid *g, int (*walkf)(cell*, Grid*))
+const size_t *gridNodes(const Grid * g)
 {
-    dtwalk(g->data, (walkfn_t) walkf, g);
+    return g->nodes;
 }
 
 /* findGrid;
  * Return the cell, if any, corresponding to
  * indices i,j
  */
-cell *findGrid(Grid * g, int i, int j)
+const cell *findGrid(const Grid * g, int i, int j)
 {
-    cell key;
+    const uint64_t key = cellKey(i, j);
+    const size_t mask = ((size_t)1 << g->bits) - 1;
 
-    key.p.i = i;
-    key.p.j = j;
-    return dtsearch(g->data, &key);
+    for (size_t h = hashKey(g, key); g->table[h]; h = (h + 1) & mask) {
+	const cell *cp = &g->cells[g->table[h] - 1];
+	if (cp->p.i == i && cp->p.j == j)
+	    return cp;
+    }
+    return NULL;
 }
 
 /* gLength:
  * Return the number of nodes in a cell.
  */
-int gLength(cell * p)
+int gLength(const cell * p)
 {
-    int len = 0;
-    node_list *nodes = p->nodes;
-
-    while (nodes) {
-	len++;
-	nodes = nodes->next;
-    }
-    return len;
+    return (int)(p->last - p->first);
 }
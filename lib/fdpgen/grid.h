@@ -16,34 +16,27 @@ extern "C" {
 
 #include "config.h"
 
-#include <common/render.h>
-#include <cdt/cdt.h>
+#include <stddef.h>
 
     typedef struct _grid Grid;
 
-    typedef struct _node_list {
-	Agnode_t *node;
-	struct _node_list *next;
-    } node_list;
-
     typedef struct {
 	int i, j;
     } gridpt;
 
     typedef struct {
 	gridpt p;		/* index of cell */
-	node_list *nodes;	/* nodes in cell */
-	Dtlink_t link;		/* cdt data */
+	size_t first;		/* range of gridNodes in cell */
+	size_t last;
     } cell;
 
-    extern Grid *mkGrid(int);
-    extern void adjustGrid(Grid * g, int nnodes);
-    extern void clearGrid(Grid *);
-    extern void addGrid(Grid *, int, int, Agnode_t *);
-    extern void walkGrid(Grid*, int (*)(cell*, Grid*));
-    extern cell *findGrid(Grid *, int, int);
+    extern Grid *mkGrid(size_t);
+    extern void buildGrid(Grid *, size_t, const double *, double);
+    extern const cell *gridCells(const Grid *, size_t *);
+    extern const size_t *gridNodes(const Grid *);
+    extern const cell *findGrid(const Grid *, int, int);
     extern void delGrid(Grid *);
-    extern int gLength(cell * p);
+    extern int gLength(const cell * p);
 
 #ifdef __cplusplus
 }
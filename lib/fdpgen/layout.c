@@ -760,7 +760,7 @@ setClustNodes(graph_t* root)
 	ND_lw(n) = ND_rw(n) = w2;
 	ND_ht(n) = h_pts;
 
-	vertices = ((polygon_t *) ND_shape_info(n))->vertices;
+	vertices = unshare_vertices(ND_shape_info(n));
 	vertices[0].x = ND_rw(n);
 	vertices[0].y = h2;
 	vertices[1].x = -ND_lw(n);
@@ -30,8 +30,13 @@
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
+#include <cgraph/alloc.h>
 #include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #ifndef _WIN32
 #include <unistd.h>
@@ -40,6 +45,9 @@
 #include <fdpgen/dbg.h>
 #include <fdpgen/grid.h>
 #include <neatogen/neato.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #ifndef HAVE_SRAND48
 #define srand48 srand
@@ -204,15 +212,209 @@ void fdp_initParams(graph_t * g)
 #endif
 }
 
+/* Large graphs are split into stripes, each with its own share of the
+ * nodes and grid cells, its own displacement buffer and its own jitter RNG.
+ * The number of stripes depends only on the number of nodes, and the
+ * buffers are summed in stripe order, so the layout does not depend on
+ * how many threads process the stripes.
+ */
+#define NODES_PER_STRIPE 1024
+#define MAX_STRIPES 16
+#define MAX_THREADS 64
+
+typedef struct {
+    double *disp;		/* x, y displacement of each node */
+    uint64_t rng;		/* state for jittering coincident nodes */
+    size_t nfirst, nlast;	/* nodes whose edges this stripe handles */
+    const cell *cfirst, *clast;	/* grid cells this stripe handles */
+} stripe_t;
+
+/* Node and edge data of the graph being laid out, in agfstnode order.
+ * The iterations work on these arrays and only write the positions back
+ * to the nodes at the end.
+ */
+typedef struct {
+    size_t nnodes;
+    Agnode_t **nodes;
+    double *pos;		/* x, y of each node */
+    double *disp;		/* x, y displacement of each node */
+    bool *port;			/* is each node a port? */
+    bool *fixed;		/* is each node pinned with P_FIX? */
+    size_t *efirst;		/* edges out of node k are efirst[k] … efirst[k+1]-1 */
+    size_t *head;		/* head of each edge */
+    double *factor;		/* ED_factor of each edge */
+    double *dist;		/* ED_dist of each edge */
+    const Grid *grid;		/* grid of the current iteration */
+    double temp;		/* temperature of the current iteration */
+    bport_t *pp;
+    size_t nstripes;
+    stripe_t *stripes;
+    size_t threads;		/* number of threads to run stripes on */
+} tlayout_t;
+
+/* fdpThreads:
+ * Number of threads to run the iterations on, from GV_FDP_THREADS if set
+ * and otherwise the number of processors.
+ */
+static size_t fdpThreads(void)
+{
+#ifdef HAVE_PTHREAD
+    long n = -1;
+    const char *s = getenv("GV_FDP_THREADS");
+    if (s != NULL && *s != '\0') {
+	char *end;
+	n = strtol(s, &end, 10);
+	if (*end != '\0' || n < 1) {
+	    agerr(AGWARN, "ignoring invalid GV_FDP_THREADS \"%s\"\n", s);
+	    n = -1;
+	}
+    }
+    if (n < 1)
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+	return 1;
+    return n > MAX_THREADS ? MAX_THREADS : (size_t)n;
+#else
+    return 1;
+#endif
+}
+
+/* jitter:
+ * Random offset in [-4,5] for separating coincident nodes.
+ */
+static double jitter(uint64_t *state)
+{
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return 5 - (int)((*state >> 33) % 10);
+}
+
+static int cmpnode(const void *x, const void *y)
+{
+    const Agnode_t *const *a = x;
+    const Agnode_t *const *b = y;
+    if ((uintptr_t)*a < (uintptr_t)*b)
+	return -1;
+    if ((uintptr_t)*a > (uintptr_t)*b)
+	return 1;
+    return 0;
+}
+
+/* mkLayout:
+ * Gather the positions and edges of g into arrays.
+ */
+static tlayout_t mkLayout(graph_t * g)
+{
+    tlayout_t L = {.nnodes = (size_t)agnnodes(g)};
+    Agnode_t *n;
+    Agedge_t *e;
+    size_t k = 0;
+    size_t nedges = 0;
+
+    L.nodes = gv_calloc(L.nnodes, sizeof(Agnode_t *));
+    L.pos = gv_calloc(2 * L.nnodes, sizeof(double));
+    L.disp = gv_calloc(2 * L.nnodes, sizeof(double));
+    L.port = gv_calloc(L.nnodes, sizeof(bool));
+    L.fixed = gv_calloc(L.nnodes, sizeof(bool));
+    L.efirst = gv_calloc(L.nnodes + 1, sizeof(size_t));
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	L.nodes[k] = n;
+	L.pos[2 * k] = ND_pos(n)[0];
+	L.pos[2 * k + 1] = ND_pos(n)[1];
+	L.port[k] = IS_PORT(n);
+	L.fixed[k] = ND_pinned(n) & P_FIX;
+	k++;
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    if (n != aghead(e))
+		nedges++;
+    }
+
+    /* look up heads by address */
+    Agnode_t **sorted = gv_calloc(L.nnodes, sizeof(Agnode_t *));
+    memcpy(sorted, L.nodes, L.nnodes * sizeof(Agnode_t *));
+    qsort(sorted, L.nnodes, sizeof(Agnode_t *), cmpnode);
+    size_t *index = gv_calloc(L.nnodes, sizeof(size_t));
+    for (k = 0; k < L.nnodes; k++) {
+	Agnode_t **found = bsearch(&L.nodes[k], sorted, L.nnodes,
+	                           sizeof(Agnode_t *), cmpnode);
+	index[found - sorted] = k;
+    }
+
+    L.head = gv_calloc(nedges, sizeof(size_t));
+    L.factor = gv_calloc(nedges, sizeof(double));
+    L.dist = gv_calloc(nedges, sizeof(double));
+    nedges = 0;
+    for (k = 0; k < L.nnodes; k++) {
+	n = L.nodes[k];
+	L.efirst[k] = nedges;
+	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
+	    Agnode_t *h = aghead(e);
+	    if (n == h)
+		continue;
+	    Agnode_t **found = bsearch(&h, sorted, L.nnodes,
+	                               sizeof(Agnode_t *), cmpnode);
+	    L.head[nedges] = index[found - sorted];
+	    L.factor[nedges] = ED_factor(e);
+	    L.dist[nedges] = ED_dist(e);
+	    nedges++;
+	}
+    }
+    L.efirst[L.nnodes] = nedges;
+
+    free(index);
+    free(sorted);
+
+    L.nstripes = L.nnodes / NODES_PER_STRIPE;
+    if (L.nstripes < 1)
+	L.nstripes = 1;
+    if (L.nstripes > MAX_STRIPES)
+	L.nstripes = MAX_STRIPES;
+    L.stripes = gv_calloc(L.nstripes, sizeof(stripe_t));
+    for (k = 0; k < L.nstripes; k++) {
+	stripe_t *sp = &L.stripes[k];
+	sp->disp = k == 0 ? L.disp : gv_calloc(2 * L.nnodes, sizeof(double));
+	sp->rng = (uint64_t)T_seed * 0x9e3779b97f4a7c15ull + k;
+	sp->nfirst = k * L.nnodes / L.nstripes;
+	sp->nlast = (k + 1) * L.nnodes / L.nstripes;
+    }
+    L.threads = fdpThreads();
+    if (L.threads > L.nstripes)
+	L.threads = L.nstripes;
+    return L;
+}
+
+/* freeLayout:
+ * Write the final positions back to the nodes and free the arrays.
+ */
+static void freeLayout(tlayout_t * L)
+{
+    for (size_t k = 0; k < L->nnodes; k++) {
+	ND_pos(L->nodes[k])[0] = L->pos[2 * k];
+	ND_pos(L->nodes[k])[1] = L->pos[2 * k + 1];
+    }
+    free(L->nodes);
+    free(L->pos);
+    free(L->disp);
+    free(L->port);
+    free(L->fixed);
+    free(L->efirst);
+    free(L->head);
+    free(L->factor);
+    free(L->dist);
+    for (size_t k = 1; k < L->nstripes; k++)
+	free(L->stripes[k].disp);
+    free(L->stripes);
+}
+
 static void
-doRep(node_t * p, node_t * q, double xdelta, double ydelta, double dist2)
+doRep(tlayout_t * L, stripe_t * sp, size_t p, size_t q, double xdelta,
+      double ydelta, double dist2)
 {
     double force;
     double dist;
 
     while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
+	xdelta = jitter(&sp->rng);
+	ydelta = jitter(&sp->rng);
 	dist2 = xdelta * xdelta + ydelta * ydelta;
     }
     if (T_useNew) {
@@ -220,33 +422,32 @@ doRep(node_t * p, node_t * q, double xdelta, double ydelta, double dist2)
 	force = T_K * T_K / (dist * dist2);
     } else
 	force = T_K * T_K / dist2;
-    if (IS_PORT(p) && IS_PORT(q))
+    if (L->port[p] && L->port[q])
 	force *= 10.0;
-    DISP(q)[0] += xdelta * force;
-    DISP(q)[1] += ydelta * force;
-    DISP(p)[0] -= xdelta * force;
-    DISP(p)[1] -= ydelta * force;
+    sp->disp[2 * q] += xdelta * force;
+    sp->disp[2 * q + 1] += ydelta * force;
+    sp->disp[2 * p] -= xdelta * force;
+    sp->disp[2 * p + 1] -= ydelta * force;
 }
 
 /* applyRep:
  * Repulsive force = (K*K)/d
  *  or K*K/d*d
  */
-static void applyRep(Agnode_t * p, Agnode_t * q)
+static void applyRep(tlayout_t * L, stripe_t * sp, size_t p, size_t q)
 {
     double xdelta, ydelta;
 
-    xdelta = ND_pos(q)[0] - ND_pos(p)[0];
-    ydelta = ND_pos(q)[1] - ND_pos(p)[1];
-    doRep(p, q, xdelta, ydelta, xdelta * xdelta + ydelta * ydelta);
+    xdelta = L->pos[2 * q] - L->pos[2 * p];
+    ydelta = L->pos[2 * q + 1] - L->pos[2 * p + 1];
+    doRep(L, sp, p, q, xdelta, ydelta, xdelta * xdelta + ydelta * ydelta);
 }
 
-static void doNeighbor(Grid * grid, int i, int j, node_list * nodes)
+static void doNeighbor(tlayout_t * L, stripe_t * sp, int i, int j,
+                       const cell * nodes)
 {
-    cell *cellp = findGrid(grid, i, j);
-    node_list *qs;
-    Agnode_t *p;
-    Agnode_t *q;
+    const cell *cellp = findGrid(L->grid, i, j);
+    const size_t *gnodes = gridNodes(L->grid);
     double xdelta, ydelta;
     double dist2;
 
@@ -258,26 +459,25 @@ static void doNeighbor(Grid * grid, int i, int j, node_list * nodes)
 		    gLength(cellp));
 	}
 #endif
-	for (; nodes != 0; nodes = nodes->next) {
-	    p = nodes->node;
-	    for (qs = cellp->nodes; qs != 0; qs = qs->next) {
-		q = qs->node;
-		xdelta = (ND_pos(q))[0] - (ND_pos(p))[0];
-		ydelta = (ND_pos(q))[1] - (ND_pos(p))[1];
+	for (size_t a = nodes->first; a < nodes->last; a++) {
+	    const size_t p = gnodes[a];
+	    for (size_t b = cellp->first; b < cellp->last; b++) {
+		const size_t q = gnodes[b];
+		xdelta = L->pos[2 * q] - L->pos[2 * p];
+		ydelta = L->pos[2 * q + 1] - L->pos[2 * p + 1];
 		dist2 = xdelta * xdelta + ydelta * ydelta;
 		if (dist2 < T_Cell * T_Cell)
-		    doRep(p, q, xdelta, ydelta, dist2);
+		    doRep(L, sp, p, q, xdelta, ydelta, dist2);
 	    }
 	}
     }
 }
 
-static int gridRepulse(cell *cellp, Grid *grid) {
-    node_list *nodes = cellp->nodes;
+static void gridRepulse(tlayout_t * L, stripe_t * sp, const cell * cellp)
+{
+    const size_t *gnodes = gridNodes(L->grid);
     int i = cellp->p.i;
     int j = cellp->p.j;
-    node_list *p;
-    node_list *q;
 
 #ifdef DEBUG
     if (Verbose >= 3) {
@@ -286,157 +486,237 @@ static int gridRepulse(cell *cellp, Grid *grid) {
 		gLength(cellp));
     }
 #endif
-    for (p = nodes; p != 0; p = p->next) {
-	for (q = nodes; q != 0; q = q->next)
+    for (size_t p = cellp->first; p < cellp->last; p++) {
+	for (size_t q = cellp->first; q < cellp->last; q++)
 	    if (p != q)
-		applyRep(p->node, q->node);
+		applyRep(L, sp, gnodes[p], gnodes[q]);
     }
 
-    doNeighbor(grid, i - 1, j - 1, nodes);
-    doNeighbor(grid, i - 1, j, nodes);
-    doNeighbor(grid, i - 1, j + 1, nodes);
-    doNeighbor(grid, i, j - 1, nodes);
-    doNeighbor(grid, i, j + 1, nodes);
-    doNeighbor(grid, i + 1, j - 1, nodes);
-    doNeighbor(grid, i + 1, j, nodes);
-    doNeighbor(grid, i + 1, j + 1, nodes);
-
-    return 0;
+    doNeighbor(L, sp, i - 1, j - 1, cellp);
+    doNeighbor(L, sp, i - 1, j, cellp);
+    doNeighbor(L, sp, i - 1, j + 1, cellp);
+    doNeighbor(L, sp, i, j - 1, cellp);
+    doNeighbor(L, sp, i, j + 1, cellp);
+    doNeighbor(L, sp, i + 1, j - 1, cellp);
+    doNeighbor(L, sp, i + 1, j, cellp);
+    doNeighbor(L, sp, i + 1, j + 1, cellp);
 }
 
 /* applyAttr:
  * Attractive force = weight*(d*d)/K
  *  or        force = (d - L(e))*weight(e)
  */
-static void applyAttr(Agnode_t * p, Agnode_t * q, Agedge_t * e)
+static void applyAttr(tlayout_t * L, stripe_t * sp, size_t p, size_t e)
 {
+    const size_t q = L->head[e];
     double xdelta, ydelta;
     double force;
     double dist;
     double dist2;
 
-    xdelta = ND_pos(q)[0] - ND_pos(p)[0];
-    ydelta = ND_pos(q)[1] - ND_pos(p)[1];
+    xdelta = L->pos[2 * q] - L->pos[2 * p];
+    ydelta = L->pos[2 * q + 1] - L->pos[2 * p + 1];
     dist2 = xdelta * xdelta + ydelta * ydelta;
     while (dist2 == 0.0) {
-	xdelta = 5 - rand() % 10;
-	ydelta = 5 - rand() % 10;
+	xdelta = jitter(&sp->rng);
+	ydelta = jitter(&sp->rng);
 	dist2 = xdelta * xdelta + ydelta * ydelta;
     }
     dist = sqrt(dist2);
     if (T_useNew)
-	force = ED_factor(e) * (dist - ED_dist(e)) / dist;
+	force = L->factor[e] * (dist - L->dist[e]) / dist;
     else
-	force = ED_factor(e) * dist / ED_dist(e);
-    DISP(q)[0] -= xdelta * force;
-    DISP(q)[1] -= ydelta * force;
-    DISP(p)[0] += xdelta * force;
-    DISP(p)[1] += ydelta * force;
+	force = L->factor[e] * dist / L->dist[e];
+    sp->disp[2 * q] -= xdelta * force;
+    sp->disp[2 * q + 1] -= ydelta * force;
+    sp->disp[2 * p] += xdelta * force;
+    sp->disp[2 * p + 1] += ydelta * force;
 }
 
-static void updatePos(Agraph_t * g, double temp, bport_t * pp)
+/* updatePos:
+ * Move the nodes of a stripe by their displacements, limited by the
+ * temperature.
+ */
+static void updatePos(tlayout_t * L, stripe_t * sp)
 {
-    Agnode_t *n;
+    const double temp = L->temp;
     double temp2;
     double len2;
     double x, y, d;
     double dx, dy;
 
     temp2 = temp * temp;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (ND_pinned(n) & P_FIX)
+    for (size_t n = sp->nfirst; n < sp->nlast; n++) {
+	double *pos = &L->pos[2 * n];
+	if (L->fixed[n])
 	    continue;
-	dx = DISP(n)[0];
-	dy = DISP(n)[1];
+	dx = L->disp[2 * n];
+	dy = L->disp[2 * n + 1];
 	len2 = dx * dx + dy * dy;
 
 	/* limit by temperature */
 	if (len2 < temp2) {
-	    x = ND_pos(n)[0] + dx;
-	    y = ND_pos(n)[1] + dy;
+	    x = pos[0] + dx;
+	    y = pos[1] + dy;
 	} else {
 	    double fact = temp / sqrt(len2);
-	    x = ND_pos(n)[0] + dx * fact;
-	    y = ND_pos(n)[1] + dy * fact;
+	    x = pos[0] + dx * fact;
+	    y = pos[1] + dy * fact;
 	}
 
 	/* if ports, limit by boundary */
-	if (pp) {
+	if (L->pp) {
 	    d = sqrt(x * x / (T_Wd * T_Wd) + y * y / (T_Ht * T_Ht));
-	    if (IS_PORT(n)) {
-		ND_pos(n)[0] = x / d;
-		ND_pos(n)[1] = y / d;
+	    if (L->port[n]) {
+		pos[0] = x / d;
+		pos[1] = y / d;
 	    } else if (d >= 1.0) {
-		ND_pos(n)[0] = 0.95 * x / d;
-		ND_pos(n)[1] = 0.95 * y / d;
+		pos[0] = 0.95 * x / d;
+		pos[1] = 0.95 * y / d;
 	    } else {
-		ND_pos(n)[0] = x;
-		ND_pos(n)[1] = y;
+		pos[0] = x;
+		pos[1] = y;
 	    }
 	} else {
-	    ND_pos(n)[0] = x;
-	    ND_pos(n)[1] = y;
+	    pos[0] = x;
+	    pos[1] = y;
 	}
     }
 }
 
-#define FLOOR(d) ((int)floor(d))
+/* stripeForces:
+ * Accumulate the attractive forces along the edges out of the nodes of
+ * a stripe and the repulsive forces of its grid cells.
+ */
+static void stripeForces(tlayout_t * L, stripe_t * sp)
+{
+    memset(sp->disp, 0, 2 * L->nnodes * sizeof(double));
 
-/* gAdjust:
+    for (size_t n = sp->nfirst; n < sp->nlast; n++) {
+	for (size_t e = L->efirst[n]; e < L->efirst[n + 1]; e++)
+	    applyAttr(L, sp, n, e);
+    }
+
+    for (const cell *cellp = sp->cfirst; cellp < sp->clast; cellp++)
+	gridRepulse(L, sp, cellp);
+}
+
+/* stripeUpdate:
+ * Sum the displacements of the nodes of a stripe over all the stripes'
+ * buffers and move the nodes.
  */
-static void gAdjust(Agraph_t * g, double temp, bport_t * pp, Grid * grid)
+static void stripeUpdate(tlayout_t * L, stripe_t * sp)
 {
-    Agnode_t *n;
-    Agedge_t *e;
+    for (size_t k = 1; k < L->nstripes; k++) {
+	const double *disp = L->stripes[k].disp;
+	for (size_t n = 2 * sp->nfirst; n < 2 * sp->nlast; n++)
+	    L->disp[n] += disp[n];
+    }
+    updatePos(L, sp);
+}
 
-    if (temp <= 0.0)
-	return;
+typedef void (*stripefn_t)(tlayout_t *, stripe_t *);
 
-    clearGrid(grid);
+typedef struct {
+    tlayout_t *L;
+    stripefn_t fn;
+    size_t first;		/* first stripe to run */
+} worker_t;
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	DISP(n)[0] = DISP(n)[1] = 0;
-	addGrid(grid, FLOOR((ND_pos(n))[0] / T_Cell), FLOOR((ND_pos(n))[1] / T_Cell),
-		n);
+static void *runWorker(void *arg)
+{
+    const worker_t *w = arg;
+    for (size_t k = w->first; k < w->L->nstripes; k += w->L->threads)
+	w->fn(w->L, &w->L->stripes[k]);
+    return NULL;
+}
+
+/* forStripes:
+ * Run fn on every stripe, sharing the stripes among L->threads threads.
+ */
+static void forStripes(tlayout_t * L, stripefn_t fn)
+{
+#ifdef HAVE_PTHREAD
+    worker_t workers[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    bool started[MAX_THREADS] = {false};
+    for (size_t t = 0; t < L->threads; t++)
+	workers[t] = (worker_t){.L = L, .fn = fn, .first = t};
+    for (size_t t = 1; t < L->threads; t++)
+	started[t] = pthread_create(&tid[t], NULL, runWorker, &workers[t]) == 0;
+    runWorker(&workers[0]);
+    for (size_t t = 1; t < L->threads; t++) {
+	if (started[t]) {
+	    pthread_join(tid[t], NULL);
+	} else {
+	    runWorker(&workers[t]);
+	}
     }
+#else
+    for (size_t k = 0; k < L->nstripes; k++)
+	fn(L, &L->stripes[k]);
+#endif
+}
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	for (e = agfstout(g, n); e; e = agnxtout(g, e))
-	    if (n != aghead(e))
-		applyAttr(n, aghead(e), e);
+/* gAdjust:
+ */
+static void gAdjust(tlayout_t * L, double temp, bport_t * pp, Grid * grid)
+{
+    if (temp <= 0.0)
+	return;
+
+    buildGrid(grid, L->nnodes, L->pos, T_Cell);
+    if (Verbose >= 3) {
+	for (size_t n = 0; n < L->nnodes; n++)
+	    fprintf(stderr, "grid(%d,%d): %s\n",
+	            (int)floor(L->pos[2 * n] / T_Cell),
+	            (int)floor(L->pos[2 * n + 1] / T_Cell),
+	            agnameof(L->nodes[n]));
     }
-    walkGrid(grid, gridRepulse);
 
+    /* give each stripe the cells starting within its share of the nodes */
+    size_t ncells;
+    const cell *cells = gridCells(grid, &ncells);
+    size_t c = 0;
+    for (size_t k = 0; k < L->nstripes; k++) {
+	stripe_t *sp = &L->stripes[k];
+	sp->cfirst = &cells[c];
+	while (c < ncells && (k + 1 == L->nstripes || cells[c].first < sp->nlast))
+	    c++;
+	sp->clast = &cells[c];
+    }
 
-    updatePos(g, temp, pp);
+    L->grid = grid;
+    L->temp = temp;
+    L->pp = pp;
+    forStripes(L, stripeForces);
+    forStripes(L, stripeUpdate);
 }
 
 /* adjust:
  */
-static void adjust(Agraph_t * g, double temp, bport_t * pp)
+static void adjust(tlayout_t * L, double temp, bport_t * pp)
 {
-    Agnode_t *n;
-    Agnode_t *n1;
-    Agedge_t *e;
+    stripe_t all = {.disp = L->disp, .rng = L->stripes[0].rng,
+                    .nfirst = 0, .nlast = L->nnodes};
 
     if (temp <= 0.0)
 	return;
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	DISP(n)[0] = DISP(n)[1] = 0;
-    }
+    memset(L->disp, 0, 2 * L->nnodes * sizeof(double));
 
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	for (n1 = agnxtnode(g, n); n1; n1 = agnxtnode(g, n1)) {
-	    applyRep(n, n1);
-	}
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    if (n != aghead(e))
-		applyAttr(n, aghead(e), e);
+    for (size_t n = 0; n < L->nnodes; n++) {
+	for (size_t n1 = n + 1; n1 < L->nnodes; n1++) {
+	    applyRep(L, &all, n, n1);
 	}
+	for (size_t e = L->efirst[n]; e < L->efirst[n + 1]; e++)
+	    applyAttr(L, &all, n, e);
     }
+    L->stripes[0].rng = all.rng;
 
-    updatePos(g, temp, pp);
+    L->temp = temp;
+    L->pp = pp;
+    updatePos(L, &all);
 }
 
 /* initPositions:
@@ -631,20 +911,21 @@ void fdp_tLayout(graph_t * g, xparams * xpms)
 
     ctr = initPositions(g, pp);
 
+    tlayout_t L = mkLayout(g);
     if (T_useGrid) {
-	grid = mkGrid(agnnodes(g));
-	adjustGrid(grid, agnnodes(g));
+	grid = mkGrid(L.nnodes);
 	for (i = 0; i < T_loopcnt; i++) {
 	    temp = cool(i);
-	    gAdjust(g, temp, pp, grid);
+	    gAdjust(&L, temp, pp, grid);
 	}
 	delGrid(grid);
     } else {
 	for (i = 0; i < T_loopcnt; i++) {
 	    temp = cool(i);
-	    adjust(g, temp, pp);
+	    adjust(&L, temp, pp);
 	}
     }
+    freeLayout(&L);
 
     if (ctr.x != 0.0 || ctr.y != 0.0) {
 	for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
@@ -1,7 +1,10 @@
 #include <cassert>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "GVContext.h"
 #include "GVLayout.h"
@@ -63,4 +66,39 @@ GVRenderData GVLayout::render(const std::string &format) const {
   return GVRenderData(result, length);
 }
 
+namespace {
+
+// state of a `render` to a sink, passed through gvRenderSink
+struct SinkContext {
+  const std::function<void(std::string_view)> &sink;
+  std::exception_ptr error;
+};
+
+// gvRenderSink callback, keeping exceptions from unwinding through C code
+size_t write_to_sink(void *context, const char *data, size_t length) {
+  auto &ctx = *static_cast<SinkContext *>(context);
+  try {
+    ctx.sink(std::string_view(data, length));
+  } catch (...) {
+    ctx.error = std::current_exception();
+    return 0;
+  }
+  return length;
+}
+
+} // namespace
+
+void GVLayout::render(const std::string &format,
+                      const std::function<void(std::string_view)> &sink) const {
+  SinkContext ctx{sink, nullptr};
+  const auto rc = gvRenderSink(m_gvc->c_struct(), m_g->c_struct(),
+                               format.c_str(), write_to_sink, &ctx);
+  if (ctx.error) {
+    std::rethrow_exception(ctx.error);
+  }
+  if (rc) {
+    throw std::runtime_error("Rendering failed");
+  }
+}
+
 } // namespace GVC
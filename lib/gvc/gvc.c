@@ -17,8 +17,10 @@
 #include <gvc/gvcproc.h>
 #include <gvc/gvconfig.h>
 #include <gvc/gvio.h>
+#include <cgraph/alloc.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 GVC_t *gvContext(void)
 {
@@ -215,6 +217,95 @@ int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result, unsi
     return rc;
 }
 
+/// output collected for the callback of gvRenderSink
+struct gvsink_s {
+    size_t (*write)(void *context, const char *data, size_t length);
+    void *context;
+    /// write discipline that was in place before gvRenderSink
+    size_t (*write_fn)(GVJ_t *job, const char *s, size_t len);
+    bool failed;		///< has the callback refused output?
+    size_t len;			///< bytes pending in `buf`
+    char buf[64 * 1024];
+};
+
+/// pass the pending output of a sink to its callback
+static void sink_flush(struct gvsink_s *sink) {
+    if (sink->len > 0 && !sink->failed &&
+        sink->write(sink->context, sink->buf, sink->len) != sink->len)
+	sink->failed = true;
+    sink->len = 0;
+}
+
+/// write discipline of gvRenderSink, cutting the output into chunks
+static size_t sink_write(GVJ_t *job, const char *s, size_t len) {
+    struct gvsink_s *sink = job->gvc->sink;
+    for (size_t left = len; left > 0 && !sink->failed; ) {
+	const size_t n = left < sizeof(sink->buf) - sink->len
+	                 ? left : sizeof(sink->buf) - sink->len;
+	memcpy(sink->buf + sink->len, s, n);
+	sink->len += n;
+	s += n;
+	left -= n;
+	if (sink->len == sizeof(sink->buf))
+	    sink_flush(sink);
+    }
+    // output refused by the callback is dropped rather than reported here,
+    // as a short write is fatal to the renderer
+    return len;
+}
+
+/* Render layout in a specified format, passing the output to a callback */
+int gvRenderSink(GVC_t *gvc, graph_t *g, const char *format,
+                 size_t (*write)(void *context, const char *data, size_t length),
+                 void *context)
+{
+    int rc;
+    GVJ_t *job;
+
+    if (!write) {
+	agerrorf("no output callback given\n");
+	return -1;
+    }
+
+    /* create a job for the required format */
+    bool r = gvjobs_output_langname(gvc, format);
+    job = gvc->job;
+    if (!r) {
+	agerr(AGERR, "Format: \"%s\" not recognized. Use one of:%s\n",
+                format, gvplugin_list(gvc, API_device, format));
+	return -1;
+    }
+
+    job->output_lang = gvrender_select(job, job->output_langname);
+    if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
+	agerrorf( "Layout was not done\n");
+	return -1;
+    }
+
+    struct gvsink_s *sink = gv_alloc(sizeof(*sink));
+    sink->write = write;
+    sink->context = context;
+    sink->write_fn = gvc->write_fn;
+    struct gvsink_s *const outer = gvc->sink;
+    gvc->sink = sink;
+    gvc->write_fn = sink_write;
+
+    rc = gvRenderJobs(gvc, g);
+    gvrender_end_job(job);
+    sink_flush(sink);
+
+    gvc->write_fn = sink->write_fn;
+    gvc->sink = outer;
+    if (rc == 0 && sink->failed) {
+	agerrorf("output callback failed\n");
+	rc = -1;
+    }
+    free(sink);
+    gvjobs_delete(gvc);
+
+    return rc;
+}
+
 /* gvFreeRenderData:
  * Utility routine to free memory allocated in gvRenderData, as the application code may use
  * a different runtime library.
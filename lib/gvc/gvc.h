@@ -99,9 +99,28 @@ GVC_API int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **resu
 /* Free memory allocated and pointed to by *result in gvRenderData */
 GVC_API void gvFreeRenderData (char* data);
 
+/* Render layout in a specified format, passing the output to a callback
+ *
+ * The output is handed to `write`, together with `context`, in chunks of at
+ * most 64KB as it is produced, so memory use does not grow with the size of
+ * the output. `write` returns the number of bytes it accepted; returning
+ * fewer than it was given stops further output and makes the call fail.
+ */
+GVC_API int gvRenderSink(GVC_t *gvc, graph_t *g, const char *format,
+                         size_t (*write)(void *context, const char *data,
+                                         size_t length),
+                         void *context);
+
 /* Render layout according to -T and -o options found by gvParseArgs */
 GVC_API int gvRenderJobs(GVC_t *gvc, graph_t *g);
 
+/* Lay out and render all input graphs in worker processes, as requested by
+ * the -j option found by gvParseArgs. Returns the maximum error count over
+ * all graphs, or -1 if pipelining was not requested or is not possible, in
+ * which case the caller should process graphs from gvNextInputGraph itself.
+ */
+GVC_API int gvPipelineJobs(GVC_t *gvc);
+
 /* Clean up layout data structures - layouts are not nestable (yet) */
 GVC_API int gvFreeLayout(GVC_t *gvc, graph_t *g);
 
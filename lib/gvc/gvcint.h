@@ -101,10 +101,18 @@ extern "C" {
 
         /* externally provided write() displine */
 	size_t (*write_fn) (GVJ_t *job, const char *s, size_t len);
+	struct gvsink_s *sink; ///< output callback of gvRenderSink, see gvc.c
 
 	/* fonts and textlayout */
 	Dtdisc_t textfont_disc;
 	Dt_t *textfont_dt;
+	struct textspan_cache_s *textspan_cache; ///< memoised span metrics
+
+	/// node and edge drawing shared by the jobs of gvRenderJobs, or NULL
+	struct displaylist_s *displaylist;
+
+	/// spatial index of the last laid out graph emitted in part, or NULL
+	struct emit_index_s *emit_index;
 	gvplugin_active_textlayout_t textlayout; /* always use best avail for all jobs */
 //	void (*free_layout) (void *layout);   /* function for freeing layouts (mostly used by pango) */
 	
@@ -56,6 +56,7 @@ extern "C" {
  GVDEVICE_DOES_TRUECOLOR	supports alpha channel -Tpng, -Tgtk, -Txlib 
  GVDEVICE_BINARY_FORMAT		Suppresses \r\n substitution for linends 
  GVDEVICE_COMPRESSED_FORMAT	controls libz compression		
+ GVDEVICE_ZSTD_FORMAT		controls zstd compression		
  GVDEVICE_NO_WRITER		used when gvdevice is not used because device uses its own writer, devil outputs   (FIXME seems to overlap OUTPUT_NOT_REQUIRED)
 
  GVRENDER_Y_GOES_DOWN		device origin top left, y goes down, otherwise
@@ -106,6 +107,7 @@ extern "C" {
 #define GVRENDER_NO_WHITE_BG (1<<25)
 #define LAYOUT_NOT_REQUIRED (1<<26)
 #define OUTPUT_NOT_REQUIRED (1<<27)
+#define GVDEVICE_ZSTD_FORMAT (1<<28)
 
     typedef struct {
 	int flags;
@@ -366,6 +368,8 @@ extern "C" {
 	gvevent_key_binding_t *keybindings;
 	int numkeys;
 	void *keycodes;
+
+	struct colorcache_s *colorcache; /* resolved colors, see gvrender.c */
     };
 
 #ifdef __cplusplus
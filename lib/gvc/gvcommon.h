@@ -30,6 +30,10 @@ typedef struct GVCOMMON_s {
                ///< layers
   const lt_symlist_t *builtins;
   int demand_loading;
+
+  /// number of worker processes for pipelined rendering of input graphs (-j);
+  /// 0 for none, -1 for one per online processor
+  int workers;
 } GVCOMMON_t;
 
 #ifdef __cplusplus
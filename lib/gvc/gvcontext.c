@@ -56,8 +56,12 @@ GVC_t *gvNEWcontext(const lt_symlist_t *builtins, int demand_loading)
 
 void gvFinalize(GVC_t * gvc)
 {
-    if (gvc->active_jobs)
+    if (gvc->active_jobs) {
 	gvrender_end_job(gvc->active_jobs);
+	/* the next gvRenderJobs, if any, starts a fresh job list */
+	gvc->active_jobs = NULL;
+	gvc->common.viewNum = 0;
+    }
 }
 
 
@@ -68,6 +72,7 @@ int gvFreeContext(GVC_t * gvc)
     gvplugin_available_t *api, *api_next;
 
     emit_once_reset();
+    emit_index_free(gvc);
     gvg_next = gvc->gvgs;
     while ((gvg = gvg_next)) {
 	gvg_next = gvg->next;
@@ -86,6 +86,7 @@ gvplugin_available_t *gvplugin_load(GVC_t *gvc, api_t api, const char *type,
     void gvrender_end_job(GVJ_t * job);
     int gvrender_select(GVJ_t * job, const char *lang);
     int gvrender_features(GVJ_t * job);
+    void gvrender_free_colorcache(GVJ_t *job);
     void gvrender_begin_graph(GVJ_t *job);
     void gvrender_end_graph(GVJ_t * job);
     void gvrender_begin_page(GVJ_t * job);
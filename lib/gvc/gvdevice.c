@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 #include <errno.h>
 #include <unistd.h>
 
@@ -37,16 +38,18 @@
 #endif
 static const unsigned char z_file_header[] =
    {0x1f, 0x8b, /*magic*/ Z_DEFLATED, 0 /*flags*/, 0,0,0,0 /*time*/, 0 /*xflags*/, OS_CODE};
-
-static z_stream z_strm;
-static unsigned char *df;
-static unsigned int dfallocated;
-static uint64_t crc;
 #endif /* HAVE_LIBZ */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include <assert.h>
 #include <cgraph/agxbuf.h>
-#include <cgraph/startswith.h>
 #include <cgraph/exit.h>
 #include <common/const.h>
 #include <common/memory.h>
@@ -81,6 +84,318 @@ static size_t gvwrite_no_z(GVJ_t * job, const void *s, size_t len) {
     return fwrite(s, sizeof(char), len, job->output_file);
 }
 
+/* Compressed output
+ *
+ * GVDEVICE_COMPRESSED_FORMAT output is a single gzip member. Rather than
+ * pushing everything through one deflate stream, the input is cut into
+ * blocks that are deflated independently, each primed with the 32K of
+ * input preceding it as a dictionary and ending on a byte boundary (as
+ * pigz does). Their output concatenates to one valid deflate stream, and
+ * the blocks of a batch can be compressed in parallel. The result depends
+ * only on the block size and the compression level, not on the number of
+ * threads.
+ *
+ * GVDEVICE_ZSTD_FORMAT output is a zstd frame, using zstd's own worker
+ * threads where the library supports them.
+ *
+ * GV_COMPRESSION_LEVEL sets the compression level and
+ * GV_COMPRESSION_THREADS the number of threads to use.
+ */
+
+#if defined(HAVE_LIBZ) || defined(HAVE_ZSTD)
+
+/// compression level requested through the environment
+///
+/// @param lo Lowest valid level
+/// @param hi Highest valid level
+/// @param dflt Level to use if none was requested
+/// @return Level to use
+static int compression_level(int lo, int hi, int dflt) {
+    const char *s = getenv("GV_COMPRESSION_LEVEL");
+    if (s == NULL || *s == '\0')
+	return dflt;
+    char *end;
+    const long level = strtol(s, &end, 10);
+    if (*end != '\0') {
+	agerr(AGWARN, "ignoring invalid GV_COMPRESSION_LEVEL \"%s\"\n", s);
+	return dflt;
+    }
+    if (level < lo)
+	return lo;
+    if (level > hi)
+	return hi;
+    return (int)level;
+}
+
+/// upper bound on compression threads
+enum { MAX_COMPRESSION_THREADS = 64 };
+
+/// number of threads to compress with
+static size_t compression_threads(void) {
+#ifdef HAVE_PTHREAD
+    long n = -1;
+    const char *s = getenv("GV_COMPRESSION_THREADS");
+    if (s != NULL && *s != '\0') {
+	char *end;
+	n = strtol(s, &end, 10);
+	if (*end != '\0' || n < 1) {
+	    agerr(AGWARN, "ignoring invalid GV_COMPRESSION_THREADS \"%s\"\n", s);
+	    n = -1;
+	}
+    }
+    if (n < 1)
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+	return 1;
+    return n > MAX_COMPRESSION_THREADS ? MAX_COMPRESSION_THREADS : (size_t)n;
+#else
+    return 1;
+#endif
+}
+
+#ifdef HAVE_LIBZ
+enum {
+    GZ_BLOCK_SIZE = 128 * 1024, ///< uncompressed bytes per block
+    GZ_DICT_SIZE = 32 * 1024,   ///< history primed into each block
+};
+
+/// one block of a batch
+typedef struct {
+    z_stream z;
+    const unsigned char *in;	///< input, preceded by `dict_len` bytes of history
+    size_t in_len;
+    size_t dict_len;
+    bool last;			///< is this the end of the output?
+    unsigned char *out;		///< compressed output
+    size_t out_size;
+    size_t out_len;
+    uLong crc;			///< CRC-32 of the input
+    int status;			///< zlib result
+} gz_block_t;
+
+static struct {
+    size_t threads;		///< number of blocks in a batch
+    gz_block_t *blocks;
+    /// `GZ_DICT_SIZE` of history followed by the input of a batch
+    unsigned char *buf;
+    size_t history;		///< bytes of history at the end of the first part of `buf`
+    size_t len;			///< bytes of input in the second part of `buf`
+    uLong crc;			///< CRC-32 of all input so far
+    uint64_t total;		///< length of all input so far
+} gz;
+
+static void *gz_compress_block(void *arg) {
+    gz_block_t *b = arg;
+    z_stream *z = &b->z;
+
+    b->status = deflateReset(z);
+    if (b->status == Z_OK && b->dict_len > 0)
+	b->status = deflateSetDictionary(z, b->in - b->dict_len,
+	                                 (uInt)b->dict_len);
+    if (b->status != Z_OK)
+	return NULL;
+
+    z->next_in = (unsigned char *)b->in;
+    z->avail_in = (uInt)b->in_len;
+    z->next_out = b->out;
+    z->avail_out = (uInt)b->out_size;
+    b->status = deflate(z, b->last ? Z_FINISH : Z_SYNC_FLUSH);
+    b->out_len = b->out_size - z->avail_out;
+
+    // the output buffer is sized so a block always fits in one call
+    if (b->last ? b->status != Z_STREAM_END
+                : b->status != Z_OK || z->avail_in != 0 || z->avail_out == 0) {
+	if (b->status == Z_OK || b->status == Z_STREAM_END)
+	    b->status = Z_BUF_ERROR;
+	return NULL;
+    }
+    b->status = Z_OK;
+    b->crc = crc32(0L, b->in, (uInt)b->in_len);
+    return NULL;
+}
+
+static int gz_init(GVJ_t *job) {
+    const int level = compression_level(0, 9, Z_DEFAULT_COMPRESSION);
+    gz.threads = compression_threads();
+    gz.blocks = gv_calloc(gz.threads, sizeof(gz.blocks[0]));
+    gz.buf = gv_alloc(GZ_DICT_SIZE + gz.threads * GZ_BLOCK_SIZE);
+    gz.history = 0;
+    gz.len = 0;
+    gz.crc = crc32(0L, Z_NULL, 0);
+    gz.total = 0;
+
+    for (size_t i = 0; i < gz.threads; ++i) {
+	gz_block_t *b = &gz.blocks[i];
+	if (deflateInit2(&b->z, level, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL,
+	                 Z_DEFAULT_STRATEGY) != Z_OK) {
+	    job->common->errorfn("Error initializing for deflation\n");
+	    return 1;
+	}
+	// room for the worst case expansion plus a sync flush marker
+	b->out_size = deflateBound(&b->z, GZ_BLOCK_SIZE) + 64;
+	b->out = gv_alloc(b->out_size);
+    }
+
+    gvwrite_no_z(job, z_file_header, sizeof(z_file_header));
+    return 0;
+}
+
+/// compress and write out the input collected so far
+///
+/// @param last Is this the end of the output?
+static void gz_flush(GVJ_t *job, bool last) {
+    unsigned char *const start = gz.buf + GZ_DICT_SIZE;
+    size_t n = (gz.len + GZ_BLOCK_SIZE - 1) / GZ_BLOCK_SIZE;
+    if (last && n == 0)
+	n = 1; // an empty final block
+    assert(n <= gz.threads);
+
+    for (size_t i = 0; i < n; ++i) {
+	gz_block_t *b = &gz.blocks[i];
+	b->in = start + i * GZ_BLOCK_SIZE;
+	b->in_len = i + 1 < n ? GZ_BLOCK_SIZE : gz.len - i * GZ_BLOCK_SIZE;
+	b->dict_len = i == 0 ? gz.history : GZ_DICT_SIZE;
+	b->last = last && i + 1 == n;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_t tid[MAX_COMPRESSION_THREADS];
+    bool started[MAX_COMPRESSION_THREADS];
+    for (size_t i = 1; i < n; ++i)
+	started[i] = pthread_create(&tid[i], NULL, gz_compress_block,
+	                            &gz.blocks[i]) == 0;
+    gz_compress_block(&gz.blocks[0]);
+    for (size_t i = 1; i < n; ++i) {
+	if (started[i]) {
+	    pthread_join(tid[i], NULL);
+	} else {
+	    gz_compress_block(&gz.blocks[i]);
+	}
+    }
+#else
+    for (size_t i = 0; i < n; ++i)
+	gz_compress_block(&gz.blocks[i]);
+#endif
+
+    for (size_t i = 0; i < n; ++i) {
+	const gz_block_t *b = &gz.blocks[i];
+	if (b->status != Z_OK) {
+	    job->common->errorfn("deflation problem %d\n", b->status);
+	    graphviz_exit(1);
+	}
+	const size_t ret = gvwrite_no_z(job, b->out, b->out_len);
+	if (ret != b->out_len) {
+	    job->common->errorfn("gvwrite_no_z problem %zu\n", ret);
+	    graphviz_exit(1);
+	}
+	gz.crc = crc32_combine(gz.crc, b->crc, (z_off_t)b->in_len);
+	gz.total += b->in_len;
+    }
+
+    // keep the end of this batch as history for the next one, a full batch
+    // being at least as long as the history
+    if (!last) {
+	assert(gz.len >= GZ_DICT_SIZE);
+	memcpy(gz.buf, start + gz.len - GZ_DICT_SIZE, GZ_DICT_SIZE);
+	gz.history = GZ_DICT_SIZE;
+    }
+    gz.len = 0;
+}
+
+static void gz_write(GVJ_t *job, const char *s, size_t len) {
+    const size_t capacity = gz.threads * GZ_BLOCK_SIZE;
+    while (len > 0) {
+	const size_t n = len < capacity - gz.len ? len : capacity - gz.len;
+	memcpy(gz.buf + GZ_DICT_SIZE + gz.len, s, n);
+	gz.len += n;
+	s += n;
+	len -= n;
+	if (gz.len == capacity)
+	    gz_flush(job, false);
+    }
+}
+
+static void gz_finish(GVJ_t *job) {
+    gz_flush(job, true);
+
+    unsigned char out[8];
+    out[0] = (unsigned char)gz.crc;
+    out[1] = (unsigned char)(gz.crc >> 8);
+    out[2] = (unsigned char)(gz.crc >> 16);
+    out[3] = (unsigned char)(gz.crc >> 24);
+    out[4] = (unsigned char)gz.total;
+    out[5] = (unsigned char)(gz.total >> 8);
+    out[6] = (unsigned char)(gz.total >> 16);
+    out[7] = (unsigned char)(gz.total >> 24);
+    gvwrite_no_z(job, out, sizeof(out));
+
+    for (size_t i = 0; i < gz.threads; ++i) {
+	// streams last used for a non-final block report Z_DATA_ERROR here,
+	// which is expected as their output was complete
+	(void)deflateEnd(&gz.blocks[i].z);
+	free(gz.blocks[i].out);
+    }
+    free(gz.blocks);
+    free(gz.buf);
+    gz.blocks = NULL;
+    gz.buf = NULL;
+}
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_ZSTD
+static ZSTD_CCtx *zstd_ctx;
+static unsigned char *zstd_out;
+static size_t zstd_out_size;
+
+static int zstd_init(GVJ_t *job) {
+    zstd_ctx = ZSTD_createCCtx();
+    if (zstd_ctx == NULL) {
+	job->common->errorfn("Error initializing for zstd compression\n");
+	return 1;
+    }
+    const int level = compression_level(ZSTD_minCLevel(), ZSTD_maxCLevel(),
+                                        ZSTD_CLEVEL_DEFAULT);
+    ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_compressionLevel, level);
+    ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_checksumFlag, 1);
+    const size_t threads = compression_threads();
+    if (threads > 1) {
+	// fails harmlessly if the library was built without thread support
+	(void)ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_nbWorkers, (int)threads);
+    }
+    zstd_out_size = ZSTD_CStreamOutSize();
+    zstd_out = gv_alloc(zstd_out_size);
+    return 0;
+}
+
+static void zstd_compress(GVJ_t *job, const char *s, size_t len,
+                          ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = {.src = s, .size = len};
+    size_t remaining;
+    do {
+	ZSTD_outBuffer out = {.dst = zstd_out, .size = zstd_out_size};
+	remaining = ZSTD_compressStream2(zstd_ctx, &out, &in, mode);
+	if (ZSTD_isError(remaining)) {
+	    job->common->errorfn("zstd compression problem: %s\n",
+	                         ZSTD_getErrorName(remaining));
+	    graphviz_exit(1);
+	}
+	if (out.pos > 0 && gvwrite_no_z(job, zstd_out, out.pos) != out.pos) {
+	    job->common->errorfn("gvwrite_no_z problem %zu\n", out.pos);
+	    graphviz_exit(1);
+	}
+    } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+}
+
+static void zstd_finish(GVJ_t *job) {
+    zstd_compress(job, NULL, 0, ZSTD_e_end);
+    ZSTD_freeCCtx(zstd_ctx);
+    zstd_ctx = NULL;
+    free(zstd_out);
+    zstd_out = NULL;
+}
+#endif /* HAVE_ZSTD */
+#endif /* HAVE_LIBZ || HAVE_ZSTD */
+
 static void auto_output_filename(GVJ_t *job)
 {
     static agxbuf buf;
@@ -154,25 +469,20 @@ int gvdevice_initialize(GVJ_t * job)
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_stream *z = &z_strm;
-
-	z->zalloc = 0;
-	z->zfree = 0;
-	z->opaque = 0;
-	z->next_in = NULL;
-	z->next_out = NULL;
-	z->avail_in = 0;
-
-	crc = crc32(0L, Z_NULL, 0);
-
-	if (deflateInit2(z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
-	    job->common->errorfn("Error initializing for deflation\n");
+	if (gz_init(job) != 0)
 	    return 1;
-	}
-	gvwrite_no_z(job, z_file_header, sizeof(z_file_header));
 #else
 	job->common->errorfn("No libz support.\n");
 	return 1;
+#endif
+    }
+    if (job->flags & GVDEVICE_ZSTD_FORMAT) {
+#ifdef HAVE_ZSTD
+	if (zstd_init(job) != 0)
+	    return 1;
+#else
+	job->common->errorfn("No zstd support.\n");
+	return 1;
 #endif
     }
     return 0;
@@ -180,51 +490,25 @@ int gvdevice_initialize(GVJ_t * job)
 
 size_t gvwrite (GVJ_t * job, const char *s, size_t len)
 {
-    size_t ret, olen;
+    size_t ret;
 
     if (!len || !s)
 	return 0;
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
-
-	size_t dflen = deflateBound(z, len);
-	if (dfallocated < dflen) {
-	    dfallocated = (dflen + 1 + PAGE_ALIGN) & ~PAGE_ALIGN;
-	    df = realloc(df, dfallocated);
-	    if (! df) {
-                job->common->errorfn("memory allocation failure\n");
-		graphviz_exit(1);
-	    }
-	}
-
-	crc = crc32(crc, (const unsigned char*)s, len);
-
-	z->next_in = (unsigned char*)s;
-	z->avail_in = len;
-	while (z->avail_in) {
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	    int r = deflate(z, Z_NO_FLUSH);
-	    if (r != Z_OK) {
-                job->common->errorfn("deflation problem %d\n", r);
-	        graphviz_exit(1);
-	    }
-
-	    if ((olen = z->next_out - df)) {
-		ret = gvwrite_no_z(job, df, olen);
-	        if (ret != olen) {
-                    job->common->errorfn("gvwrite_no_z problem %d\n", ret);
-	            graphviz_exit(1);
-	        }
-	    }
-	}
-
+	gz_write(job, s, len);
 #else
-        (void)olen;
 	job->common->errorfn("No libz support.\n");
 	graphviz_exit(1);
+#endif
+    }
+    else if (job->flags & GVDEVICE_ZSTD_FORMAT) {
+#ifdef HAVE_ZSTD
+	zstd_compress(job, s, len, ZSTD_e_continue);
+#else
+	job->common->errorfn("No zstd support.\n");
+	graphviz_exit(1);
 #endif
     }
     else { /* uncompressed write */
@@ -324,45 +608,20 @@ void gvdevice_finalize(GVJ_t * job)
 
     if (job->flags & GVDEVICE_COMPRESSED_FORMAT) {
 #ifdef HAVE_LIBZ
-	z_streamp z = &z_strm;
-	unsigned char out[8] = "";
-	int ret;
-	int cnt = 0;
-
-	z->next_in = out;
-	z->avail_in = 0;
-	z->next_out = df;
-	z->avail_out = dfallocated;
-	while ((ret = deflate (z, Z_FINISH)) == Z_OK && (cnt++ <= 100)) {
-	    gvwrite_no_z(job, df, z->next_out - df);
-	    z->next_out = df;
-	    z->avail_out = dfallocated;
-	}
-	if (ret != Z_STREAM_END) {
-            job->common->errorfn("deflation finish problem %d cnt=%d\n", ret, cnt);
-	    graphviz_exit(1);
-	}
-	gvwrite_no_z(job, df, z->next_out - df);
-
-	ret = deflateEnd(z);
-	if (ret != Z_OK) {
-	    job->common->errorfn("deflation end problem %d\n", ret);
-	    graphviz_exit(1);
-	}
-	out[0] = (unsigned char)crc;
-	out[1] = (unsigned char)(crc >> 8);
-	out[2] = (unsigned char)(crc >> 16);
-	out[3] = (unsigned char)(crc >> 24);
-	out[4] = (unsigned char)z->total_in;
-	out[5] = (unsigned char)(z->total_in >> 8);
-	out[6] = (unsigned char)(z->total_in >> 16);
-	out[7] = (unsigned char)(z->total_in >> 24);
-	gvwrite_no_z(job, out, sizeof(out));
+	gz_finish(job);
 #else
 	job->common->errorfn("No libz support\n");
 	graphviz_exit(1);
 #endif
     }
+    if (job->flags & GVDEVICE_ZSTD_FORMAT) {
+#ifdef HAVE_ZSTD
+	zstd_finish(job);
+#else
+	job->common->errorfn("No zstd support\n");
+	graphviz_exit(1);
+#endif
+    }
 
     if (gvde) {
 	if (gvde->finalize) {
@@ -397,105 +656,186 @@ void gvprintf(GVJ_t * job, const char *format, ...)
 }
 
 
-/* Test with:
- *	cc -DGVPRINTNUM_TEST gvprintnum.c -o gvprintnum
- */
-
 /* use macro so maxnegnum is stated just once for both double and string versions */
 #define val_str(n, x) static double n = x; static char n##str[] = #x;
 val_str(maxnegnum, -999999999999999.99)
 
-static void gvprintnum(agxbuf *xb, double number) {
+/// room for the longest output of `gvprintnum` and a NUL terminator
+enum { GVPRINTNUM_SIZE = 24 };
+
+/// drop “0”s that provide no information from a printed number
+///
+/// This is `agxbuf_trim_zeros` for a plain character buffer.
+///
+/// @param buf Printed number
+/// @param len Length of `buf`
+/// @return Length of the trimmed number
+static size_t trim_zeros(char *buf, size_t len) {
+  if (memchr(buf, '.', len) == NULL) {
+    return len;
+  }
+  while (buf[len - 1] == '0') {
+    --len;
+  }
+  if (buf[len - 1] == '.') {
+    --len;
+  }
+  // turn “-0” into “0”
+  if (len == 2 && buf[0] == '-' && buf[1] == '0') {
+    buf[0] = '0';
+    len = 1;
+  }
+  return len;
+}
+
+/// print a number with a fixed number of fractional digits, without `printf`
+///
+/// The result is what `"%.*f"` followed by `trim_zeros` gives, except that a
+/// “0” integer part is omitted when `strip_lead` is set and there is a
+/// fraction. Only moderately sized numbers are handled. Numbers whose scaled
+/// fraction lies too close to a rounding tie to decide with `double`
+/// arithmetic are declined too, leaving them to `printf`’s correctly rounded
+/// conversion.
+///
+/// @param buf Destination, with room for at least `GVPRINTNUM_SIZE` bytes
+/// @param number Value to print
+/// @param precision Number of fractional digits, at most 3
+/// @param strip_lead Omit a “0” integer part?
+/// @return Number of bytes written, or 0 if the number was declined
+static size_t print_fixed(char *buf, double number, int precision,
+                          bool strip_lead) {
+  static const double scale[] = {1, 10, 100, 1000};
+  assert(precision >= 0 && precision <= 3);
+
+  // this also rejects NaN
+  if (!(number > -1e8 && number < 1e8)) {
+    return 0;
+  }
+
+  const double scaled = fabs(number) * scale[precision];
+  const double whole = floor(scaled);
+  const double frac = scaled - whole;
+  if (fabs(frac - 0.5) < 1e-4) {
+    return 0;
+  }
+  uint64_t digits = (uint64_t)whole + (frac > 0.5);
+
+  // write the digits right to left into a scratch buffer
+  char tmp[GVPRINTNUM_SIZE];
+  char *const end = tmp + sizeof(tmp);
+  char *p = end;
+  for (int i = 0; i < precision; ++i) {
+    const char d = (char)('0' + digits % 10);
+    digits /= 10;
+    if (p != end || d != '0') {
+      *--p = d;
+    }
+  }
+  const bool fraction = p != end;
+  if (fraction) {
+    *--p = '.';
+  }
+  if (digits > 0 || !fraction || !strip_lead) {
+    do {
+      *--p = (char)('0' + digits % 10);
+      digits /= 10;
+    } while (digits > 0);
+  }
+
+  // a value that rounded to zero is printed without a sign
+  size_t len = 0;
+  if (number < 0 && (p[0] != '0' || p + 1 != end)) {
+    buf[len++] = '-';
+  }
+  memcpy(buf + len, p, (size_t)(end - p));
+  return len + (size_t)(end - p);
+}
+
+/// print a coordinate
+///
+/// @param buf Destination, with room for at least `GVPRINTNUM_SIZE` bytes
+/// @param number Value to print
+/// @return Number of bytes written, excluding a NUL terminator
+static size_t gvprintnum(char *buf, double number) {
     /*
         number limited to a working range: maxnegnum >= n >= -maxnegnum
 	suppressing trailing "0" and "."
      */
 
     if (number < maxnegnum) {		/* -ve limit */
-	agxbput(xb, maxnegnumstr);
-	return;
+	memcpy(buf, maxnegnumstr, sizeof(maxnegnumstr));
+	return sizeof(maxnegnumstr) - 1;
     }
     if (number > -maxnegnum) {		/* +ve limit */
-	agxbput(xb, maxnegnumstr + 1); // +1 to skip the '-' sign
-	return;
+	// +1 to skip the '-' sign
+	memcpy(buf, maxnegnumstr + 1, sizeof(maxnegnumstr) - 1);
+	return sizeof(maxnegnumstr) - 2;
     }
 
-    agxbprint(xb, "%.03f", number);
-    agxbuf_trim_zeros(xb);
-
-    // strip off unnecessary leading '0'
-    {
-        char *staging = agxbdisown(xb);
-        if (startswith(staging, "0.")) {
-            memmove(staging, &staging[1], strlen(staging));
-        } else if (startswith(staging, "-0.")) {
-            memmove(&staging[1], &staging[2], strlen(&staging[1]));
-        }
-        agxbput(xb, staging);
-        free(staging);
+    size_t len = print_fixed(buf, number, 3, true);
+    if (len > 0) {
+	buf[len] = '\0';
+	return len;
     }
-}
 
+    const int r = snprintf(buf, GVPRINTNUM_SIZE, "%.03f", number);
+    assert(r > 0 && r < GVPRINTNUM_SIZE);
+    len = trim_zeros(buf, (size_t)r);
 
-#ifdef GVPRINTNUM_TEST
-int main (int argc, char *argv[])
-{
-    agxbuf xb = {0};
-    char *buf;
-    size_t len;
-
-    double test[] = {
-	-maxnegnum*1.1, -maxnegnum*.9,
-	1e8, 10.008, 10, 1, .1, .01,
-	.006, .005, .004, .001, 1e-8, 
-	0, -0,
-	-1e-8, -.001, -.004, -.005, -.006,
-	-.01, -.1, -1, -10, -10.008, -1e8,
-	maxnegnum*.9, maxnegnum*1.1
-    };
-    int i = sizeof(test) / sizeof(test[0]);
-
-    while (i--) {
-	gvprintnum(&xb, test[i]);
-	buf = agxbuse(&xb);;
-        fprintf (stdout, "%g = %s %d\n", test[i], buf, len);
+    // strip off unnecessary leading '0'
+    if (len > 1 && buf[0] == '0' && buf[1] == '.') {
+	memmove(buf, &buf[1], len - 1);
+	--len;
+    } else if (len > 2 && buf[0] == '-' && buf[1] == '0' && buf[2] == '.') {
+	memmove(&buf[1], &buf[2], len - 2);
+	--len;
     }
-
-    agxbfree(&xb);
-    graphviz_exit(0);
+    buf[len] = '\0';
+    return len;
 }
-#endif
 
 void gvprintdouble(GVJ_t * job, double num)
 {
-    agxbuf buf = {0};
+    char buf[GVPRINTNUM_SIZE];
+    const size_t len = print_fixed(buf, num, 2, false);
+    if (len > 0) {
+	gvwrite(job, buf, len);
+	return;
+    }
 
-    agxbprint(&buf, "%.02f", num);
-    agxbuf_trim_zeros(&buf);
+    agxbuf xb = {0};
 
-    gvputs(job, agxbuse(&buf));
-    agxbfree(&buf);
+    agxbprint(&xb, "%.02f", num);
+    agxbuf_trim_zeros(&xb);
+
+    gvputs(job, agxbuse(&xb));
+    agxbfree(&xb);
 }
 
 void gvprintpointf(GVJ_t * job, pointf p)
 {
-    agxbuf xb = {0};
-
-    gvprintnum(&xb, p.x);
-    const char *buf = agxbuse(&xb);
-    gvwrite(job, buf, strlen(buf));
-    gvwrite(job, " ", 1);
-    gvprintnum(&xb, p.y);
-    buf = agxbuse(&xb);
-    gvwrite(job, buf, strlen(buf));
-    agxbfree(&xb);
-} 
+    char buf[2 * GVPRINTNUM_SIZE];
+    size_t len = gvprintnum(buf, p.x);
+    buf[len++] = ' ';
+    len += gvprintnum(buf + len, p.y);
+    gvwrite(job, buf, len);
+}
 
 void gvprintpointflist(GVJ_t *job, pointf *p, size_t n) {
-  const char *separator = "";
+  // print into a local buffer and write it out in blocks
+  char buf[BUFSIZ];
+  size_t len = 0;
   for (size_t i = 0; i < n; ++i) {
-    gvputs(job, separator);
-    gvprintpointf(job, p[i]);
-    separator = " ";
+    if (sizeof(buf) - len < 2 * GVPRINTNUM_SIZE + 1) {
+      gvwrite(job, buf, len);
+      len = 0;
+    }
+    if (i > 0) {
+      buf[len++] = ' ';
+    }
+    len += gvprintnum(buf + len, p[i].x);
+    buf[len++] = ' ';
+    len += gvprintnum(buf + len, p[i].y);
   }
-} 
+  gvwrite(job, buf, len);
+}
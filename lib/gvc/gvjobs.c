@@ -130,6 +130,7 @@ void gvjobs_delete(GVC_t * gvc)
 	gv_argvlist_reset(&(j->selected_obj_type_name));
 	free(j->active_tooltip);
 	free(j->selected_href);
+	gvrender_free_colorcache(j);
 	free(j);
     }
     gvc->jobs = gvc->job = gvc->active_jobs = output_filename_job = output_langname_job =
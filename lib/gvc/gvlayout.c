@@ -28,6 +28,7 @@ extern void graph_init(Agraph_t *g, bool use_rankdir);
 extern void graph_cleanup(Agraph_t *g);
 extern void gv_fixLocale (int set);
 extern void gv_initShapes (void);
+extern void emit_index_free(GVC_t *gvc);
 
 int gvlayout_select(GVC_t * gvc, const char *layout)
 {
@@ -78,6 +79,7 @@ int gvLayoutJobs(GVC_t * gvc, Agraph_t * g)
     if (! gvle)
 	return -1;
 
+    emit_index_free(gvc);
     gv_fixLocale (1);
     graph_init(g, !!(gvc->layout.features->flags & LAYOUT_USES_RANKDIR));
     GD_drawing(agroot(g)) = GD_drawing(g);
@@ -106,7 +108,7 @@ bool gvLayoutDone(Agraph_t * g)
  */
 int gvFreeLayout(GVC_t * gvc, Agraph_t * g)
 {
-    (void)gvc;
+    emit_index_free(gvc);
 
     /* skip if no Agraphinfo_t yet */
     if (! agbindrec(g, "Agraphinfo_t", 0, true))
@@ -0,0 +1,506 @@
+/// @file
+/// @brief pipelined layout and rendering of multi-graph input streams
+///
+/// With `-j`, the input is split at top level graph boundaries and each
+/// graph is parsed, laid out and rendered by one of a pool of worker
+/// processes. Results are collected and written to standard output in input
+/// order, so the output is the same as if the graphs had been processed one
+/// after another.
+///
+/// Workers are processes rather than threads because layout engines and
+/// renderers keep per-graph state in globals.
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+#include "config.h"
+
+#include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
+#include <cgraph/cgraph.h>
+#include <cgraph/gv_ctype.h>
+#include <common/globals.h>
+#include <common/render.h>
+#include <errno.h>
+#include <gvc/gvc.h>
+#include <gvc/gvcint.h>
+#include <gvc/gvcjob.h>
+#include <gvc/gvcproc.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// header of a graph sent to a worker, followed by `size` bytes of DOT text
+typedef struct {
+  size_t size;
+  int fidx; ///< index into gvc->input_filenames, or -1 for stdin
+  int line; ///< line number on which the text starts
+  int gidx; ///< index of the graph within its input file
+} task_t;
+
+/// header of a worker’s result, followed by `size` bytes of output
+typedef struct {
+  size_t size;
+  int errors; ///< agreseterrors() after processing the graph
+} result_t;
+
+typedef struct {
+  pid_t pid;
+  int to;    ///< write end of the worker’s task pipe
+  int from;  ///< read end of the worker’s result pipe
+  bool dead; ///< has the worker stopped responding?
+} worker_t;
+
+typedef struct {
+  worker_t *workers;
+  size_t n_workers;
+  size_t sent;    ///< number of graphs handed to workers
+  size_t relayed; ///< number of results written to stdout
+  int rc;         ///< maximum error count seen so far
+} pipeline_t;
+
+/// DOT input being split into top level graphs
+typedef struct {
+  FILE *fp;
+  int line; ///< current line number
+  bool bol; ///< at the beginning of a line?
+} splitter_t;
+
+static bool read_all(int fd, void *buf, size_t size) {
+  char *p = buf;
+  while (size > 0) {
+    const ssize_t r = read(fd, p, size);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    p += r;
+    size -= (size_t)r;
+  }
+  return true;
+}
+
+static bool write_all(int fd, const void *buf, size_t size) {
+  const char *p = buf;
+  while (size > 0) {
+    const ssize_t w = write(fd, p, size);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      return false;
+    p += w;
+    size -= (size_t)w;
+  }
+  return true;
+}
+
+/// copy input into xb up to and including the terminator `end`
+static int copy_until(splitter_t *s, agxbuf *xb, int end) {
+  int c;
+  while ((c = getc(s->fp)) != EOF) {
+    agxbputc(xb, (char)c);
+    if (c == '\n')
+      ++s->line;
+    if (end == '"' && c == '\\') {
+      if ((c = getc(s->fp)) == EOF)
+        break;
+      agxbputc(xb, (char)c);
+      if (c == '\n')
+        ++s->line;
+    } else if (c == end) {
+      break;
+    }
+  }
+  return c;
+}
+
+/* Read the next top level graph, including any preceding whitespace and
+ * comments, into xb. Only as much of the DOT lexical structure as is
+ * needed to track brace nesting is recognized: quoted strings, HTML-like
+ * strings, comments and preprocessor lines. Returns false if the input
+ * held nothing else but whitespace and comments.
+ */
+static bool split_graph(splitter_t *s, agxbuf *xb) {
+  int depth = 0;
+  bool seen = false;
+  int c;
+
+  while ((c = getc(s->fp)) != EOF) {
+    agxbputc(xb, (char)c);
+    const bool bol = s->bol;
+    s->bol = c == '\n';
+    switch (c) {
+    case '\n':
+      ++s->line;
+      break;
+    case '#':
+      if (bol) {
+        copy_until(s, xb, '\n');
+        s->bol = true;
+      } else {
+        seen = true;
+      }
+      break;
+    case '/':
+      c = getc(s->fp);
+      if (c == '/') {
+        agxbputc(xb, (char)c);
+        copy_until(s, xb, '\n');
+        s->bol = true;
+      } else if (c == '*') {
+        agxbputc(xb, (char)c);
+        int prev = 0;
+        while ((c = getc(s->fp)) != EOF) {
+          agxbputc(xb, (char)c);
+          if (c == '\n')
+            ++s->line;
+          if (prev == '*' && c == '/')
+            break;
+          prev = c;
+        }
+      } else {
+        if (c != EOF)
+          ungetc(c, s->fp);
+        seen = true;
+      }
+      break;
+    case '"':
+      copy_until(s, xb, '"');
+      seen = true;
+      break;
+    case '<':
+      for (int nest = 1; nest > 0 && (c = getc(s->fp)) != EOF;) {
+        agxbputc(xb, (char)c);
+        if (c == '\n')
+          ++s->line;
+        else if (c == '<')
+          ++nest;
+        else if (c == '>')
+          --nest;
+      }
+      seen = true;
+      break;
+    case '{':
+      ++depth;
+      seen = true;
+      break;
+    case '}':
+      seen = true;
+      if (depth > 0 && --depth == 0)
+        return true;
+      break;
+    default:
+      if (!gv_isspace(c))
+        seen = true;
+      break;
+    }
+  }
+
+  // a truncated graph is still handed on, so the parser can report it
+  return seen;
+}
+
+/// parse, lay out and render graphs from the task pipe until it is closed
+static void worker(GVC_t *gvc, int in, int out) {
+  // jobs write to stdout, which is captured so each graph’s output can be
+  // returned separately
+  FILE *capture = tmpfile();
+  if (capture == NULL || dup2(fileno(capture), STDOUT_FILENO) < 0) {
+    agerrorf("could not capture output of pipelined worker: %s\n",
+             strerror(errno));
+    _exit(EXIT_FAILURE);
+  }
+
+  // ending a job forgets -l libraries, so restore them for every graph
+  const char **lib = gvc->common.lib;
+
+  task_t task;
+  while (read_all(in, &task, sizeof(task))) {
+    char *dot = gv_alloc(task.size + 1);
+    if (!read_all(in, dot, task.size)) {
+      free(dot);
+      break;
+    }
+
+    char *fn = task.fidx < 0 ? NULL : gvc->input_filenames[task.fidx];
+    agsetfile(fn ? fn : "<stdin>");
+    agreadline(task.line);
+    const bool binary = task.size >= sizeof(AGBIN_MAGIC) - 1 &&
+                        memcmp(dot, AGBIN_MAGIC, sizeof(AGBIN_MAGIC) - 1) == 0;
+    graph_t *g = binary ? agmemreadbin(dot, task.size, NULL) : agmemread(dot);
+    free(dot);
+
+    if (g) {
+      gvg_init(gvc, g, fn, task.gidx);
+      gvc->common.lib = lib;
+      gvLayoutJobs(gvc, g);
+      gvRenderJobs(gvc, g);
+      gvFinalize(gvc);
+      gvFreeLayout(gvc, g);
+      agclose(g);
+    }
+
+    result_t result = {.errors = agreseterrors()};
+    fflush(stdout);
+    const off_t end = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+    result.size = end > 0 ? (size_t)end : 0;
+    if (!write_all(out, &result, sizeof(result)))
+      break;
+    char buf[BUFSIZ];
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < result.size;) {
+      const ssize_t r = pread(STDOUT_FILENO, buf, sizeof(buf), (off_t)offset);
+      ok = r > 0 && write_all(out, buf, (size_t)r);
+      offset += r > 0 ? (size_t)r : 0;
+    }
+    if (!ok || ftruncate(STDOUT_FILENO, 0) < 0)
+      break;
+    lseek(STDOUT_FILENO, 0, SEEK_SET);
+  }
+
+  _exit(EXIT_SUCCESS);
+}
+
+static bool spawn(GVC_t *gvc, pipeline_t *p) {
+  int task[2];
+  int result[2];
+
+  if (pipe(task) < 0)
+    return false;
+  if (pipe(result) < 0) {
+    close(task[0]);
+    close(task[1]);
+    return false;
+  }
+
+  // do not let the child inherit, and later repeat, buffered output
+  fflush(stdout);
+  fflush(stderr);
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(task[0]);
+    close(task[1]);
+    close(result[0]);
+    close(result[1]);
+    return false;
+  }
+  if (pid == 0) {
+    // drop the pipes to earlier workers, so they see end-of-file when the
+    // parent closes its ends
+    for (size_t i = 0; i < p->n_workers; ++i) {
+      close(p->workers[i].to);
+      close(p->workers[i].from);
+    }
+    close(task[1]);
+    close(result[0]);
+    worker(gvc, task[0], result[1]);
+  }
+
+  close(task[0]);
+  close(result[1]);
+  p->workers[p->n_workers++] =
+      (worker_t){.pid = pid, .to = task[1], .from = result[0]};
+  return true;
+}
+
+/// write the next result in input order to stdout
+static void relay(pipeline_t *p) {
+  worker_t *w = &p->workers[p->relayed % p->n_workers];
+  ++p->relayed;
+
+  result_t result;
+  if (w->dead || !read_all(w->from, &result, sizeof(result))) {
+    if (!w->dead)
+      agerrorf("pipelined worker %d exited unexpectedly\n", (int)w->pid);
+    w->dead = true;
+    p->rc = MAX(p->rc, 1);
+    return;
+  }
+
+  char buf[BUFSIZ];
+  for (size_t left = result.size; left > 0;) {
+    const size_t n = MIN(left, sizeof(buf));
+    if (!read_all(w->from, buf, n)) {
+      agerrorf("pipelined worker %d exited unexpectedly\n", (int)w->pid);
+      w->dead = true;
+      result.errors = MAX(result.errors, 1);
+      break;
+    }
+    fwrite(buf, 1, n, stdout);
+    left -= n;
+  }
+  p->rc = MAX(p->rc, result.errors);
+}
+
+/* Hand a graph to the next worker in turn. Each worker holds at most one
+ * graph at a time, so its previous result, the oldest outstanding one, is
+ * relayed first.
+ */
+static void dispatch(pipeline_t *p, const task_t *task, const char *text) {
+  worker_t *w = &p->workers[p->sent % p->n_workers];
+  if (p->sent >= p->n_workers)
+    relay(p);
+  ++p->sent;
+
+  if (!w->dead && !(write_all(w->to, task, sizeof(*task)) &&
+                    write_all(w->to, text, task->size)))
+    w->dead = true;
+}
+
+/* Read the next graph of a binary (-Tgvb) input into xb, using the payload
+ * size from its header. Returns false at the end of input. A malformed or
+ * truncated graph is still handed on, for the worker to report.
+ */
+static bool split_binary(FILE *fp, agxbuf *xb) {
+  int c = getc(fp);
+  if (c == EOF)
+    return false;
+  agxbputc(xb, (char)c);
+
+  // magic, then the version and payload size varints
+  for (size_t i = 1; i < sizeof(AGBIN_MAGIC) - 1; ++i) {
+    if ((c = getc(fp)) == EOF)
+      return true;
+    agxbputc(xb, (char)c);
+  }
+  uint64_t size = 0;
+  for (int field = 0; field < 2; ++field) {
+    unsigned shift = 0;
+    size = 0;
+    do {
+      if ((c = getc(fp)) == EOF || shift >= 64)
+        return true;
+      agxbputc(xb, (char)c);
+      size |= (uint64_t)(c & 0x7f) << shift;
+      shift += 7;
+    } while (c & 0x80);
+  }
+
+  char buf[BUFSIZ];
+  while (size > 0) {
+    const size_t n = fread(buf, 1, size < sizeof(buf) ? size : sizeof(buf),
+                           fp);
+    if (n == 0)
+      break;
+    agxbput_n(xb, buf, n);
+    size -= n;
+  }
+  return true;
+}
+
+/// split one input and hand each of its graphs on
+static void split_input(pipeline_t *p, FILE *fp, int fidx) {
+  splitter_t s = {.fp = fp, .line = 1, .bol = true};
+  agxbuf text = {0};
+  int gidx = 0;
+
+  const int first = getc(fp);
+  const bool binary = first == (unsigned char)AGBIN_MAGIC[0];
+  if (first != EOF)
+    ungetc(first, fp);
+
+  for (;;) {
+    const int line = s.line;
+    if (binary ? !split_binary(fp, &text) : !split_graph(&s, &text))
+      break;
+    const task_t task = {
+        .size = agxblen(&text), .fidx = fidx, .line = line, .gidx = gidx++};
+    dispatch(p, &task, agxbuse(&text));
+  }
+  agxbfree(&text);
+}
+
+int gvPipelineJobs(GVC_t *gvc) {
+  int n = gvc->common.workers;
+  if (n < 0) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n = cpus > 0 ? (int)MIN(cpus, INT_MAX) : 1;
+  }
+  if (n <= 1)
+    return -1;
+
+  // output can only be put back in order when it goes to stdout
+  if (!gvc->common.auto_outfile_names) {
+    for (GVJ_t *job = gvc->jobs; job; job = job->next) {
+      if (job->output_filename) {
+        agwarningf("-j is ignored with -o; processing graphs sequentially\n");
+        return -1;
+      }
+    }
+  }
+
+  pipeline_t p = {.workers = gv_calloc((size_t)n, sizeof(worker_t))};
+  void (*sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+  while (p.n_workers < (size_t)n && spawn(gvc, &p))
+    ;
+  if (p.n_workers == 0) {
+    agwarningf("could not start pipelined workers (%s); processing graphs "
+               "sequentially\n", strerror(errno));
+    signal(SIGPIPE, sigpipe);
+    free(p.workers);
+    return -1;
+  }
+
+  if (gvc->input_filenames[0] == NULL) {
+    split_input(&p, stdin, -1);
+  } else {
+    for (int fidx = 0; gvc->input_filenames[fidx]; ++fidx) {
+      const char *fn = gvc->input_filenames[fidx];
+      FILE *fp = fopen(fn, "r");
+      if (fp == NULL) {
+        agerrorf("%s: can't open %s: %s\n", gvc->common.cmdname, fn,
+                 strerror(errno));
+        graphviz_errors++;
+        continue;
+      }
+      split_input(&p, fp, fidx);
+      fclose(fp);
+    }
+  }
+
+  while (p.relayed < p.sent)
+    relay(&p);
+  fflush(stdout);
+
+  for (size_t i = 0; i < p.n_workers; ++i) {
+    close(p.workers[i].to);
+    close(p.workers[i].from);
+  }
+  for (size_t i = 0; i < p.n_workers; ++i) {
+    int status;
+    while (waitpid(p.workers[i].pid, &status, 0) < 0 && errno == EINTR)
+      ;
+  }
+
+  signal(SIGPIPE, sigpipe);
+  free(p.workers);
+  return p.rc;
+}
+
+#else
+
+int gvPipelineJobs(GVC_t *gvc) {
+  if (gvc->common.workers != 0)
+    agwarningf("-j is not supported on this platform; processing graphs "
+               "sequentially\n");
+  return -1;
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <common/const.h>
 #include <common/macros.h>
 #include <common/colorprocs.h>
+#include <common/displaylist.h>
 #include <gvc/gvplugin_render.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
@@ -34,10 +35,17 @@
 #include <cgraph/strcasecmp.h>
 #include <cgraph/streq.h>
 #include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 extern bool mapbool(const char *s);
 
+/// the display list recording this job's drawing, if any
+static displaylist_t *recording(GVJ_t *job) {
+    return job->gvc ? job->gvc->displaylist : NULL;
+}
+
 int gvrender_select(GVJ_t * job, const char *str)
 {
     GVC_t *gvc = job->gvc;
@@ -180,20 +188,127 @@ static int gvrender_comparestr(const void *s1, const void *s2)
   return strcmp(s1, *(char *const *) s2);
 }
 
+/// a color name resolved for a job’s renderer
+typedef struct {
+  const char *name; ///< the name resolved, compared by address
+  char *text;       ///< copy of the name’s content when it was resolved
+  char *scheme;     ///< color scheme in effect at the time, or NULL
+  gvcolor_t color;  ///< result of the resolution
+} colorcache_entry_t;
+
+/// colors resolved by a job, keyed by the address of the color name
+///
+/// Color names mostly come from interned attribute values, so the objects of
+/// a graph pass the same few pointers over and over. Because a name can also
+/// live in a transient buffer, and because the current color scheme affects
+/// the result, a hit on the address is confirmed against the content and
+/// scheme it was resolved with.
+struct colorcache_s {
+  const gvrender_features_t *features; ///< renderer the entries are valid for
+  colorcache_entry_t *entries;         ///< open addressed hash table
+  size_t size;                         ///< number of occupied entries
+  size_t capacity;                     ///< number of entries, a power of 2
+};
+
+/// upper bound on cache entries, beyond which the cache is emptied
+///
+/// This bounds the memory taken by names in transient buffers, each of
+/// which may occupy its own entry.
+enum { COLORCACHE_LIMIT = 4096 };
+
+static void colorcache_clear(struct colorcache_s *cache) {
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    free(cache->entries[i].text);
+    free(cache->entries[i].scheme);
+  }
+  memset(cache->entries, 0, cache->capacity * sizeof(cache->entries[0]));
+  cache->size = 0;
+}
+
+void gvrender_free_colorcache(GVJ_t *job) {
+  struct colorcache_s *cache = job->colorcache;
+  if (cache == NULL)
+    return;
+  colorcache_clear(cache);
+  free(cache->entries);
+  free(cache);
+  job->colorcache = NULL;
+}
+
+static size_t colorcache_hash(const char *name, size_t capacity) {
+  const uint64_t h = (uint64_t)(uintptr_t)name * 0x9e3779b97f4a7c15ull;
+  return (size_t)(h >> 32) & (capacity - 1);
+}
+
+/// find the entry for a color name, or the empty entry it would occupy
+static colorcache_entry_t *colorcache_slot(GVJ_t *job, const char *name) {
+  struct colorcache_s *cache = job->colorcache;
+  if (cache == NULL) {
+    cache = job->colorcache = gv_alloc(sizeof(*cache));
+    cache->capacity = 64;
+    cache->entries = gv_calloc(cache->capacity, sizeof(cache->entries[0]));
+  }
+  if (cache->features != job->render.features) {
+    colorcache_clear(cache);
+    cache->features = job->render.features;
+  }
+
+  // keep the load factor at most ½, so probing always finds an empty entry
+  if (cache->size >= COLORCACHE_LIMIT) {
+    colorcache_clear(cache);
+  } else if (2 * (cache->size + 1) > cache->capacity) {
+    colorcache_entry_t *old = cache->entries;
+    const size_t old_capacity = cache->capacity;
+    cache->capacity *= 2;
+    cache->entries = gv_calloc(cache->capacity, sizeof(cache->entries[0]));
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old[i].name == NULL)
+        continue;
+      size_t j = colorcache_hash(old[i].name, cache->capacity);
+      while (cache->entries[j].name != NULL)
+        j = (j + 1) & (cache->capacity - 1);
+      cache->entries[j] = old[i];
+    }
+    free(old);
+  }
+
+  size_t i = colorcache_hash(name, cache->capacity);
+  while (cache->entries[i].name != NULL && cache->entries[i].name != name)
+    i = (i + 1) & (cache->capacity - 1);
+  return &cache->entries[i];
+}
+
+static bool scheme_eq(const char *a, const char *b) {
+  if (a == NULL || b == NULL)
+    return a == b;
+  return streq(a, b);
+}
+
 /* gvrender_resolve_color:
  * N.B. strcmp cannot be used in bsearch, as it will pass a pointer
  * to an element in the array features->knowncolors (i.e., a char**)
  * as an argument of the compare function, while the arguments to 
  * strcmp are both char*.
  */
-static void gvrender_resolve_color(gvrender_features_t * features,
-				   char *name, gvcolor_t * color)
+static void gvrender_resolve_color(GVJ_t *job, char *name, gvcolor_t *color)
 {
+    gvrender_features_t *features = job->render.features;
     char *tok;
     int rc;
 
+    colorcache_entry_t *entry = colorcache_slot(job, name);
+    const char *scheme = getColorScheme();
+    if (entry->name == name && streq(entry->text, name) &&
+	scheme_eq(entry->scheme, scheme)) {
+	*color = entry->color;
+	if (color->type == COLOR_STRING || color->type == COLOR_INDEX)
+	    color->u.string = name;
+	return;
+    }
+
     color->u.string = name;
     color->type = COLOR_STRING;
+    rc = COLOR_OK;
     tok = canontoken(name);
     if (!features->knowncolors
 	||
@@ -214,6 +329,20 @@ static void gvrender_resolve_color(gvrender_features_t * features,
 	}
     }
     free(tok);
+
+    // remember successful resolutions, leaving failures to warn as before
+    if (rc == COLOR_OK) {
+	if (entry->name == NULL) {
+	    ++job->colorcache->size;
+	} else {
+	    free(entry->text);
+	    free(entry->scheme);
+	}
+	entry->name = name;
+	entry->text = gv_strdup(name);
+	entry->scheme = scheme == NULL ? NULL : gv_strdup(scheme);
+	entry->color = *color;
+    }
 }
 
 void gvrender_begin_graph(GVJ_t *job) {
@@ -377,6 +506,8 @@ void gvrender_end_edge(GVJ_t * job)
 void gvrender_begin_anchor(GVJ_t * job, char *href, char *tooltip,
 			   char *target, char *id)
 {
+    displaylist_abort(job);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -387,6 +518,8 @@ void gvrender_begin_anchor(GVJ_t * job, char *href, char *tooltip,
 
 void gvrender_end_anchor(GVJ_t * job)
 {
+    displaylist_abort(job);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -397,6 +530,10 @@ void gvrender_end_anchor(GVJ_t * job)
 
 void gvrender_begin_label(GVJ_t * job, label_type type)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_begin_label(dl, job, type);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -407,6 +544,10 @@ void gvrender_begin_label(GVJ_t * job, label_type type)
 
 void gvrender_end_label(GVJ_t * job)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_end_label(dl, job);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -417,6 +558,10 @@ void gvrender_end_label(GVJ_t * job)
 
 void gvrender_textspan(GVJ_t * job, pointf p, textspan_t * span)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_textspan(dl, job, p, span);
+
     gvrender_engine_t *gvre = job->render.engine;
     pointf PF;
 
@@ -436,6 +581,10 @@ void gvrender_textspan(GVJ_t * job, pointf p, textspan_t * span)
 
 void gvrender_set_pencolor(GVJ_t * job, char *name)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_pencolor(dl, job, name);
+
     gvrender_engine_t *gvre = job->render.engine;
     gvcolor_t *color = &(job->obj->pencolor);
     char *cp = NULL;
@@ -443,7 +592,7 @@ void gvrender_set_pencolor(GVJ_t * job, char *name)
     if ((cp = strchr(name, ':'))) // if it’s a color list, then use only first
 	*cp = '\0';
     if (gvre) {
-	gvrender_resolve_color(job->render.features, name, color);
+	gvrender_resolve_color(job, name, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -453,6 +602,10 @@ void gvrender_set_pencolor(GVJ_t * job, char *name)
 
 void gvrender_set_fillcolor(GVJ_t * job, char *name)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_fillcolor(dl, job, name);
+
     gvrender_engine_t *gvre = job->render.engine;
     gvcolor_t *color = &(job->obj->fillcolor);
     char *cp = NULL;
@@ -460,7 +613,7 @@ void gvrender_set_fillcolor(GVJ_t * job, char *name)
     if ((cp = strchr(name, ':'))) // if it’s a color list, then use only first
 	*cp = '\0';
     if (gvre) {
-	gvrender_resolve_color(job->render.features, name, color);
+	gvrender_resolve_color(job, name, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -470,11 +623,15 @@ void gvrender_set_fillcolor(GVJ_t * job, char *name)
 
 void gvrender_set_gradient_vals (GVJ_t * job, char *stopcolor, int angle, float frac)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_gradient_vals(dl, job, stopcolor, angle, frac);
+
     gvrender_engine_t *gvre = job->render.engine;
     gvcolor_t *color = &(job->obj->stopcolor);
 
     if (gvre) {
-	gvrender_resolve_color(job->render.features, stopcolor, color);
+	gvrender_resolve_color(job, stopcolor, color);
 	if (gvre->resolve_color)
 	    gvre->resolve_color(job, color);
     }
@@ -484,6 +641,10 @@ void gvrender_set_gradient_vals (GVJ_t * job, char *stopcolor, int angle, float
 
 void gvrender_set_style(GVJ_t * job, char **s)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_style(dl, job, s);
+
     gvrender_engine_t *gvre = job->render.engine;
     obj_state_t *obj = job->obj;
     char *line, *p;
@@ -522,6 +683,10 @@ void gvrender_set_style(GVJ_t * job, char **s)
 }
 
 void gvrender_ellipse(GVJ_t *job, pointf *pf, int filled) {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_ellipse(dl, job, pf, filled);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -542,6 +707,10 @@ void gvrender_ellipse(GVJ_t *job, pointf *pf, int filled) {
 }
 
 void gvrender_polygon(GVJ_t *job, pointf *af, size_t n, int filled) {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_polygon(dl, job, af, n, filled);
+
     int noPoly = 0;
     gvcolor_t save_pencolor;
 
@@ -584,6 +753,10 @@ void gvrender_box(GVJ_t * job, boxf B, int filled)
 }
 
 void gvrender_beziercurve(GVJ_t *job, pointf *af, size_t n, int filled) {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_beziercurve(dl, job, af, n, filled);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -601,6 +774,10 @@ void gvrender_beziercurve(GVJ_t *job, pointf *af, size_t n, int filled) {
 }
 
 void gvrender_polyline(GVJ_t *job, pointf *af, size_t n) {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_polyline(dl, job, af, n);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
@@ -619,6 +796,10 @@ void gvrender_polyline(GVJ_t *job, pointf *af, size_t n) {
 
 void gvrender_comment(GVJ_t * job, char *str)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_comment(dl, job, str);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (!str || !str[0])
@@ -688,6 +869,10 @@ void gvrender_usershape(GVJ_t *job, char *name, pointf *a, size_t n,
     assert(name);
     assert(name[0]);
 
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_usershape(dl, job, name, a, n, filled, imagescale, imagepos);
+
     if (!(us = gvusershape_find(name))) {
 	if (find_user_shape(name)) {
 	    if (gvre && gvre->library_shape)
@@ -804,6 +989,10 @@ void gvrender_usershape(GVJ_t *job, char *name, pointf *a, size_t n,
 
 void gvrender_set_penwidth(GVJ_t * job, double penwidth)
 {
+    displaylist_t *dl = recording(job);
+    if (dl)
+	displaylist_penwidth(dl, job, penwidth);
+
     gvrender_engine_t *gvre = job->render.engine;
 
     if (gvre) {
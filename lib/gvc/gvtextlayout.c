@@ -30,6 +30,7 @@ int gvtextlayout_select(GVC_t * gvc)
     if (plugin) {
 	typeptr = plugin->typeptr;
 	gvc->textlayout.engine = typeptr->engine;
+	gvc->textlayout.type = plugin->package->name;
 	return GVRENDER_PLUGIN;  /* FIXME - need more suitable success code */
     }
     return NO_SUPPORT;
@@ -170,6 +170,28 @@ LeafList_t *RTreeSearch(RTree_t * rtp, Node_t * n, Rect_t * r)
     return llp;
 }
 
+/* RTreeVisit calls visit(data, arg) for each data rectangle in the subtree
+** rooted at n that overlaps r. Unlike RTreeSearch it allocates nothing, so it
+** suits queries returning many rectangles.
+*/
+void RTreeVisit(Node_t *n, const Rect_t *r, void (*visit)(void *, void *),
+                void *arg)
+{
+    assert(n);
+    assert(n->level >= 0);
+    assert(r);
+    assert(visit);
+
+    for (size_t i = 0; i < NODECARD; i++) {
+	if (!n->branch[i].child || !Overlap(r, &n->branch[i].rect))
+	    continue;
+	if (n->level > 0)
+	    RTreeVisit(n->branch[i].child, r, visit, arg);
+	else
+	    visit(n->branch[i].child, arg);
+    }
+}
+
 /* Insert a data rectangle into an index structure.
 ** RTreeInsert provides for splitting the root;
 ** returns 1 if root was split, 0 if it was not.
@@ -75,6 +75,7 @@ RTree_t *RTreeOpen(void);
 int RTreeClose(RTree_t * rtp);
 Node_t *RTreeNewIndex(void);
 LeafList_t *RTreeSearch(RTree_t *, Node_t *, Rect_t *);
+void RTreeVisit(Node_t *, const Rect_t *, void (*)(void *, void *), void *);
 int RTreeInsert(RTree_t *, Rect_t *, void *, Node_t **, int);
 
 LeafList_t *RTreeNewLeafList(Leaf_t * lp);
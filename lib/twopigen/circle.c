@@ -11,57 +11,50 @@
 #include    <assert.h>
 #include    <cgraph/alloc.h>
 #include    <cgraph/gv_ctype.h>
-#include    <cgraph/queue.h>
 #include    <cgraph/streq.h>
 #include    <twopigen/circle.h>
 #include    <inttypes.h>
 #include    <limits.h>
 #include    <math.h>
 #include    <stdbool.h>
+#include    <stddef.h>
 #include    <stdint.h>
 #include    <stdlib.h>
 #include    <string.h>
 #define DEF_RANKSEP 1.00
 #define UNSET 10.00
 
-/* dfs to set distance from a particular leaf.
- * Note that termination is implicit in the test
- * for reduced number of steps. Proof?
+/* Per-node layout data of a connected component. Nodes are numbered in
+ * agfstnode order, with the number kept in ND_id.
  */
-static void setNStepsToLeaf(Agraph_t * g, Agnode_t * n, Agnode_t * prev)
-{
-    Agnode_t *next;
-
-    uint64_t nsteps = SLEAF(n) + 1;
-
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
-
-	if (prev == next)
-	    continue;
-
-	if (nsteps < SLEAF(next)) {	/* handles loops and multiedges */
-	    SLEAF(next) = nsteps;
-	    setNStepsToLeaf(g, next, n);
-	}
-    }
-}
+typedef struct {
+    size_t n;			///< number of nodes
+    Agnode_t **node;		///< node of each number
+    size_t *first;		///< neighbors of i are adj[first[i]] … adj[first[i + 1] - 1]
+    size_t *adj;		///< neighbors, in agfstedge order
+    bool *zero;			///< is the edge to each neighbor of weight 0?
+    uint64_t *nStepsToLeaf;
+    uint64_t *subtreeSize;
+    uint64_t *nChildren;
+    uint64_t *nStepsToCenter;
+    size_t *parent;		///< SIZE_MAX for the center
+    double *span;
+    double *theta;
+    size_t *order;		///< nodes in breadth-first order from the center
+} rdata;
 
 /* isLeaf:
  * Return true if n is a leaf node.
  */
-static bool isLeaf(Agraph_t * g, Agnode_t * n)
+static bool isLeaf(const rdata *r, size_t n)
 {
-    Agnode_t *neighp = 0;
-    Agnode_t *np;
+    size_t neighp = SIZE_MAX;
 
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((np = agtail(ep)) == n)
-	    np = aghead(ep);
+    for (size_t k = r->first[n]; k < r->first[n + 1]; ++k) {
+	const size_t np = r->adj[k];
 	if (n == np)
 	    continue;		/* loop */
-	if (neighp) {
+	if (neighp != SIZE_MAX) {
 	    if (neighp != np)
 		return false;	/* two different neighbors */
 	} else
@@ -70,142 +63,183 @@ static bool isLeaf(Agraph_t * g, Agnode_t * n)
     return true;
 }
 
-static void initLayout(Agraph_t * g)
+static rdata initLayout(Agraph_t * g)
 {
     int nnodes = agnnodes(g);
     assert(nnodes >= 0);
     uint64_t INF = (uint64_t)nnodes * (uint64_t)nnodes;
+    Agsym_t* wt = agfindedgeattr(g,"weight");
+    rdata r = {.n = (size_t)nnodes};
+    size_t i = 0;
 
+    r.node = gv_calloc(r.n, sizeof(Agnode_t*));
     for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	SCENTER(n) = INF;
-	THETA(n) = UNSET;	/* marks theta as unset, since 0 <= theta <= 2PI */
-	if (isLeaf(g, n))
-	    SLEAF(n) = 0;
+	ND_id(n) = (int)i;
+	r.node[i++] = n;
+    }
+
+    size_t nadj = 0;
+    for (i = 0; i < r.n; i++) {
+	for (Agedge_t *ep = agfstedge(g, r.node[i]); ep; ep = agnxtedge(g, ep, r.node[i]))
+	    nadj++;
+    }
+    r.first = gv_calloc(r.n + 1, sizeof(size_t));
+    r.adj = gv_calloc(nadj, sizeof(size_t));
+    r.zero = gv_calloc(nadj, sizeof(bool));
+    nadj = 0;
+    for (i = 0; i < r.n; i++) {
+	Agnode_t *n = r.node[i];
+	r.first[i] = nadj;
+	for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
+	    Agnode_t *next;
+	    if ((next = agtail(ep)) == n)
+		next = aghead(ep);
+	    r.zero[nadj] = wt && streq(ag_xget(ep,wt),"0");
+	    r.adj[nadj++] = (size_t)ND_id(next);
+	}
+    }
+    r.first[r.n] = nadj;
+
+    r.nStepsToLeaf = gv_calloc(r.n, sizeof(uint64_t));
+    r.subtreeSize = gv_calloc(r.n, sizeof(uint64_t));
+    r.nChildren = gv_calloc(r.n, sizeof(uint64_t));
+    r.nStepsToCenter = gv_calloc(r.n, sizeof(uint64_t));
+    r.parent = gv_calloc(r.n, sizeof(size_t));
+    r.span = gv_calloc(r.n, sizeof(double));
+    r.theta = gv_calloc(r.n, sizeof(double));
+    r.order = gv_calloc(r.n, sizeof(size_t));
+
+    for (i = 0; i < r.n; i++) {
+	r.nStepsToCenter[i] = INF;
+	r.theta[i] = UNSET;	/* marks theta as unset, since 0 <= theta <= 2PI */
+	if (isLeaf(&r, i))
+	    r.nStepsToLeaf[i] = 0;
 	else
-	    SLEAF(n) = INF;
+	    r.nStepsToLeaf[i] = INF;
     }
+    return r;
+}
+
+static void freeLayout(rdata *r)
+{
+    free(r->node);
+    free(r->first);
+    free(r->adj);
+    free(r->zero);
+    free(r->nStepsToLeaf);
+    free(r->subtreeSize);
+    free(r->nChildren);
+    free(r->nStepsToCenter);
+    free(r->parent);
+    free(r->span);
+    free(r->theta);
+    free(r->order);
 }
 
 /*
- * Working recursively in from each leaf node (ie, each node
+ * Working in from all leaf nodes at once (ie, each node
  * with nStepsToLeaf == 0; see initLayout), set the
- * minimum value of nStepsToLeaf for each node.  Using
- * that information, assign some node to be the centerNode.
+ * minimum value of nStepsToLeaf for each node by breadth-first
+ * search.  Using that information, assign some node to be the
+ * centerNode.
 */
-static Agnode_t *findCenterNode(Agraph_t * g)
+static size_t findCenterNode(rdata *r)
 {
-    Agnode_t *center = NULL;
+    size_t *queue = r->order;
+    size_t head = 0, tail = 0;
+    size_t center = 0;
     uint64_t maxNStepsToLeaf = 0;
 
-    /* dfs from each leaf node */
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (SLEAF(n) == 0)
-	    setNStepsToLeaf(g, n, 0);
+    for (size_t n = 0; n < r->n; n++) {
+	if (r->nStepsToLeaf[n] == 0)
+	    queue[tail++] = n;
     }
-
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (center == NULL || SLEAF(n) > maxNStepsToLeaf) {
-	    maxNStepsToLeaf = SLEAF(n);
-	    center = n;
+    while (head < tail) {
+	const size_t n = queue[head++];
+	const uint64_t nsteps = r->nStepsToLeaf[n] + 1;
+	for (size_t k = r->first[n]; k < r->first[n + 1]; ++k) {
+	    const size_t next = r->adj[k];
+	    if (nsteps < r->nStepsToLeaf[next]) {	/* handles loops and multiedges */
+		r->nStepsToLeaf[next] = nsteps;
+		queue[tail++] = next;
+	    }
 	}
     }
-    return center;
-}
 
-/* bfs to create tree structure */
-static void setNStepsToCenter(Agraph_t * g, Agnode_t * n)
-{
-    Agnode_t *next;
-    Agsym_t* wt = agfindedgeattr(g,"weight");
-    queue_t q = {0};
-
-    queue_push(&q,n);
-    while ((n = queue_pop(&q))) {
-	uint64_t nsteps = SCENTER(n) + 1;
-	for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	    if (wt && streq(ag_xget(ep,wt),"0")) continue;
-	    if ((next = agtail(ep)) == n)
-		next = aghead(ep);
-	    if (nsteps < SCENTER(next)) {
-		SCENTER(next) = nsteps;
-		SPARENT(next) = n;
-		NCHILD(n)++;
-		queue_push(&q, next);
-	    }
+    for (size_t n = 0; n < r->n; n++) {
+	if (n == 0 || r->nStepsToLeaf[n] > maxNStepsToLeaf) {
+	    maxNStepsToLeaf = r->nStepsToLeaf[n];
+	    center = n;
 	}
     }
-    queue_free(&q);
+    return center;
 }
 
 /*
- * Work out from the center and determine the value of
- * nStepsToCenter and parent node for each node.
+ * Work out from the center by breadth-first search and determine
+ * the value of nStepsToCenter and parent node for each node,
+ * recording the order nodes are reached in.
  * Return UINT64_MAX if some node was not reached.
  */
-static uint64_t setParentNodes(Agraph_t * sg, Agnode_t * center)
+static uint64_t setParentNodes(rdata *r, size_t center)
 {
+    size_t *queue = r->order;
+    size_t head = 0, tail = 0;
     uint64_t maxn = 0;
-    uint64_t unset = SCENTER(center);
-
-    SCENTER(center) = 0;
-    SPARENT(center) = 0;
-    setNStepsToCenter(sg, center);
 
-    /* find the maximum number of steps from the center */
-    for (Agnode_t *n = agfstnode(sg); n; n = agnxtnode(sg, n)) {
-	if (SCENTER(n) == unset) {
-	    return UINT64_MAX;
-	}
-	else if (SCENTER(n) > maxn) {
-	    maxn = SCENTER(n);
+    r->nStepsToCenter[center] = 0;
+    r->parent[center] = SIZE_MAX;
+    queue[tail++] = center;
+    while (head < tail) {
+	const size_t n = queue[head++];
+	const uint64_t nsteps = r->nStepsToCenter[n] + 1;
+	for (size_t k = r->first[n]; k < r->first[n + 1]; ++k) {
+	    if (r->zero[k]) continue;
+	    const size_t next = r->adj[k];
+	    if (nsteps < r->nStepsToCenter[next]) {
+		r->nStepsToCenter[next] = nsteps;
+		r->parent[next] = n;
+		r->nChildren[n]++;
+		queue[tail++] = next;
+	    }
 	}
+	maxn = r->nStepsToCenter[n];
     }
+
+    if (tail < r->n)
+	return UINT64_MAX;
     return maxn;
 }
 
 /* Sets each node's subtreeSize, which counts the number of 
  * leaves in subtree rooted at the node.
- * At present, this is done bottom-up.
+ * This is done bottom-up, children before their parents.
  */
-static void setSubtreeSize(Agraph_t * g)
+static void setSubtreeSize(rdata *r)
 {
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (NCHILD(n) > 0)
-	    continue;
-	STSIZE(n)++;
-	for (Agnode_t *parent = SPARENT(n); parent; parent = SPARENT(parent)) {
-	    STSIZE(parent)++;
-	}
+    for (size_t k = r->n; k-- > 0; ) {
+	const size_t n = r->order[k];
+	if (r->nChildren[n] == 0)
+	    r->subtreeSize[n]++;
+	if (r->parent[n] != SIZE_MAX)
+	    r->subtreeSize[r->parent[n]] += r->subtreeSize[n];
     }
 }
 
-static void setChildSubtreeSpans(Agraph_t * g, Agnode_t * n)
+/* Divide each node's span among its children in proportion to their
+ * subtree sizes, top-down.
+ */
+static void setSubtreeSpans(rdata *r, size_t center)
 {
-    Agnode_t *next;
-
-    double ratio = SPAN(n) / STSIZE(n);
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
-	if (SPARENT(next) != n)
-	    continue;		/* handles loops */
-
-	if (SPAN(next) != 0.0)
-	    continue;		/* multiedges */
-	SPAN(next) = ratio * STSIZE(next);
-
-	if (NCHILD(next) > 0) {
-	    setChildSubtreeSpans(g, next);
-	}
+    r->span[center] = 2 * M_PI;
+    for (size_t k = 1; k < r->n; k++) {
+	const size_t n = r->order[k];
+	const size_t parent = r->parent[n];
+	double ratio = r->span[parent] / r->subtreeSize[parent];
+	r->span[n] = ratio * r->subtreeSize[n];
     }
 }
 
-static void setSubtreeSpans(Agraph_t * sg, Agnode_t * center)
-{
-    SPAN(center) = 2 * M_PI;
-    setChildSubtreeSpans(sg, center);
-}
-
 /// has the given value been assigned?
 static bool is_set(double a) {
   // Compare exactly against our sentinel. No need for a tolerance or
@@ -214,37 +248,36 @@ static bool is_set(double a) {
   return memcmp(&a, &unset, sizeof(a)) != 0;
 }
 
- /* Set the node positions for the 2nd and later rings. */
-static void setChildPositions(Agraph_t * sg, Agnode_t * n)
+/* Set the node positions for the 2nd and later rings, fanning out the
+ * children of each node in edge order. Parents come before their children
+ * in breadth-first order, so theta of each node is known by the time its
+ * children are placed.
+ */
+static void setPositions(rdata *r, size_t center)
 {
-    Agnode_t *next;
-    double theta;		/* theta is the lower boundary radius of the fan */
-
-    if (SPARENT(n) == 0)	/* center */
-	theta = 0;
-    else
-	theta = THETA(n) - SPAN(n) / 2;
-
-    for (Agedge_t *ep = agfstedge(sg, n); ep; ep = agnxtedge(sg, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
-	if (SPARENT(next) != n)
-	    continue;		/* handles loops */
-	if (is_set(THETA(next)))
-	    continue;		/* handles multiedges */
-
-	THETA(next) = theta + SPAN(next) / 2.0;
-	theta += SPAN(next);
-
-	if (NCHILD(next) > 0)
-	    setChildPositions(sg, next);
-    }
-}
+    r->theta[center] = 0;
+    for (size_t k = 0; k < r->n; k++) {
+	const size_t n = r->order[k];
+	double theta;		/* theta is the lower boundary radius of the fan */
 
-static void setPositions(Agraph_t * sg, Agnode_t * center)
-{
-    THETA(center) = 0;
-    setChildPositions(sg, center);
+	if (r->nChildren[n] == 0)
+	    continue;
+	if (n == center)
+	    theta = 0;
+	else
+	    theta = r->theta[n] - r->span[n] / 2;
+
+	for (size_t j = r->first[n]; j < r->first[n + 1]; ++j) {
+	    const size_t next = r->adj[j];
+	    if (r->parent[next] != n)
+		continue;		/* handles loops */
+	    if (is_set(r->theta[next]))
+		continue;		/* handles multiedges */
+
+	    r->theta[next] = theta + r->span[next] / 2.0;
+	    theta += r->span[next];
+	}
+    }
 }
 
 /* getRankseps:
@@ -286,7 +319,7 @@ getRankseps (Agraph_t* g, uint64_t maxrank)
     return ranks;
 }
 
-static void setAbsolutePos(Agraph_t * g, uint64_t maxrank)
+static void setAbsolutePos(Agraph_t * g, const rdata *r, uint64_t maxrank)
 {
     double* ranksep = getRankseps (g, maxrank);
     if (Verbose) {
@@ -297,10 +330,11 @@ static void setAbsolutePos(Agraph_t * g, uint64_t maxrank)
     }
 
     /* Convert circular to cartesian coordinates */
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	double hyp = ranksep[SCENTER(n)];
-	ND_pos(n)[0] = hyp * cos(THETA(n));
-	ND_pos(n)[1] = hyp * sin(THETA(n));
+    for (size_t i = 0; i < r->n; i++) {
+	Agnode_t *n = r->node[i];
+	double hyp = ranksep[r->nStepsToCenter[i]];
+	ND_pos(n)[0] = hyp * cos(r->theta[i]);
+	ND_pos(n)[1] = hyp * sin(r->theta[i]);
     }
     free (ranksep);
 }
@@ -319,26 +353,28 @@ Agnode_t* circleLayout(Agraph_t * sg, Agnode_t * center)
 	return center;
     }
 
-    initLayout(sg);
+    rdata r = initLayout(sg);
 
-    if (!center)
-	center = findCenterNode(sg);
+    size_t c = center ? (size_t)ND_id(center) : findCenterNode(&r);
+    center = r.node[c];
 
-    uint64_t maxNStepsToCenter = setParentNodes(sg,center);
+    uint64_t maxNStepsToCenter = setParentNodes(&r, c);
     if (Verbose)
 	fprintf(stderr, "root = %s max steps to root = %" PRIu64 "\n",
 	        agnameof(center), maxNStepsToCenter);
     if (maxNStepsToCenter == UINT64_MAX) {
 	agerr(AGERR, "twopi: use of weight=0 creates disconnected component.\n");
+	freeLayout(&r);
 	return center;
     }
 
-    setSubtreeSize(sg);
+    setSubtreeSize(&r);
 
-    setSubtreeSpans(sg, center);
+    setSubtreeSpans(&r, c);
 
-    setPositions(sg, center);
+    setPositions(&r, c);
 
-    setAbsolutePos(sg, maxNStepsToCenter);
+    setAbsolutePos(sg, &r, maxNStepsToCenter);
+    freeLayout(&r);
     return center;
 }
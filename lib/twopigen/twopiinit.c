@@ -37,11 +37,9 @@ static void twopi_init_node_edge(graph_t * g)
     int i = 0;
     int n_nodes = agnnodes(g);
 
-    rdata* alg = gv_calloc(n_nodes, sizeof(rdata));
     GD_neato_nlist(g) = gv_calloc(n_nodes + 1, sizeof(node_t*));
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	neato_init_node(n);
-	ND_alg(n) = alg + i;
 	GD_neato_nlist(g)[i++] = n;
     }
     for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
@@ -112,7 +110,6 @@ void twopi_layout(Agraph_t * g)
 	Agraph_t **ccs;
 	Agraph_t *sg;
 	Agnode_t *c = NULL;
-	Agnode_t *n;
 	Agnode_t* lctr;
 
 	size_t ncc;
@@ -127,9 +124,6 @@ void twopi_layout(Agraph_t * g)
 		ctr = c;
 	    if (setLocalRoot && !lctr)
 		agxset (c, rootattr, "1"); 
-	    n = agfstnode(g);
-	    free(ND_alg(n));
-	    ND_alg(n) = NULL;
 	    adjustNodes(g);
 	    spline_edges(g);
 	} else {
@@ -151,9 +145,6 @@ void twopi_layout(Agraph_t * g)
 		    agxset (c, rootattr, "1"); 
 		adjustNodes(sg);
 	    }
-	    n = agfstnode(g);
-	    free(ND_alg(n));
-	    ND_alg(n) = NULL;
 	    packSubgraphs(ncc, ccs, g, &pinfo);
 	    spline_edges(g);
 	}
@@ -174,8 +165,8 @@ static void twopi_cleanup_graph(graph_t * g)
 }
 
 /* twopi_cleanup:
- * The ND_alg data used by twopi is freed in twopi_layout
- * before edge routing as edge routing may use this field.
+ * The layout data used by twopi is local to circleLayout,
+ * so only the common node and edge data are left to free.
  */
 void twopi_cleanup(graph_t * g)
 {
@@ -184,7 +175,6 @@ void twopi_cleanup(graph_t * g)
 
     n = agfstnode (g);
     if (!n) return; /* empty graph */
-    /* free (ND_alg(n)); */
     for (; n; n = agnxtnode(g, n)) {
 	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
 	    gv_cleanup_edge(e);
@@ -8,26 +8,142 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include "config.h"
+
 #include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
 #include <cgraph/gv_ctype.h>
 #include <cgraph/prisize_t.h>
 #include <cgraph/unreachable.h>
 #include <xdot/xdot.h>
+#include <float.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/// a block of storage for the points and strings of an xdot
+struct xdot_arena_s {
+    struct xdot_arena_s *next;	///< previously filled block
+    size_t size;		///< bytes in `data`
+    size_t used;		///< bytes of `data` handed out
+    double data[];		///< storage, typed to be suitably aligned
+};
+
+/// make sure the current block of an arena has room for `size` bytes
+static void arena_reserve(struct xdot_arena_s **arena, size_t size) {
+    struct xdot_arena_s *a = *arena;
+    if (a != NULL && a->size - a->used >= size)
+	return;
+    struct xdot_arena_s *b = gv_alloc(sizeof(*b) + size);
+    b->next = a;
+    b->size = size;
+    *arena = b;
+}
+
+static void arena_free(struct xdot_arena_s *arena) {
+    while (arena != NULL) {
+	struct xdot_arena_s *next = arena->next;
+	free(arena);
+	arena = next;
+    }
+}
+
+/// allocate storage for parsed data
+///
+/// @param arena Arena to allocate from, or NULL to allocate from the heap
+/// @param count Number of items needed
+/// @param size Size of each item
+/// @return Zeroed storage
+static void *xd_alloc(struct xdot_arena_s **arena, size_t count, size_t size) {
+    enum { MIN_BLOCK = 4096 };
+    if (arena == NULL ||
+        (size != 0 && count > (SIZE_MAX / 2 - MIN_BLOCK) / size))
+	return gv_calloc(count, size); // this also reports overflow
+    size = (count * size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    if (*arena == NULL || (*arena)->size - (*arena)->used < size) {
+	const size_t block = *arena == NULL ? MIN_BLOCK : (*arena)->size;
+	arena_reserve(arena, size > block ? size : block);
+    }
+    struct xdot_arena_s *a = *arena;
+    void *p = (char *)a->data + a->used;
+    a->used += size;
+    return p;
+}
+
+/// release storage from `xd_alloc`
+static void xd_free(struct xdot_arena_s **arena, void *p) {
+    if (arena == NULL)
+	free(p);
+    // arena storage is released with the whole arena
+}
+
+/// powers of ten that are exactly representable in a double
+static const double exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
 /* the parse functions should return NULL on error */
+
+/// parse a floating point number, as `strtod` does
+///
+/// Plain decimals of up to 19 digits are converted directly. When their
+/// digits form an integer a double holds exactly, one division by an exact
+/// power of ten gives the correctly rounded result, as `strtod` does.
+/// Everything else is left to `strtod`.
 static char *parseReal(char *s, double *fp)
 {
-    char *p;
-    double d;
-
-    d = strtod(s, &p);
-    if (p == s) return 0;
+#if FLT_EVAL_METHOD == 0
+    char *p = s;
+    while (gv_isspace(*p))
+	p++;
+    const bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+	p++;
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction = 0;
+    bool point = false;
+    for (;; p++) {
+	if (gv_isdigit(*p)) {
+	    if (digits == 19)
+		goto fallback;
+	    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+	    digits++;
+	    fraction += point;
+	} else if (*p == '.' && !point) {
+	    point = true;
+	} else {
+	    break;
+	}
+    }
+    // exponents, hexadecimal, infinities and NaNs
+    if (digits == 0 || *p == 'e' || *p == 'E' || *p == 'x' || *p == 'X')
+	goto fallback;
+    if (mantissa > (UINT64_C(1) << 53) ||
+        fraction >= (int)(sizeof(exact_pow10) / sizeof(exact_pow10[0])))
+	goto fallback;
+
+    double d = (double)mantissa;
+    if (fraction > 0)
+	d /= exact_pow10[fraction];
+    *fp = negative ? -d : d;
+    return p;
+
+fallback:;
+#endif
+    char *end;
+    const double value = strtod(s, &end);
+    if (end == s) return 0;
 	
-    *fp = d;
-    return (p);
+    *fp = value;
+    return end;
 }
 
 
@@ -55,61 +171,40 @@ static char *parseUInt(char *s, unsigned int *ip)
 
 static char *parseRect(char *s, xdot_rect * rp)
 {
-    char* endp;
-
-    rp->x = strtod (s, &endp);
-    if (s == endp)
-	return 0;
-    else
-	s = endp;
-
-    rp->y = strtod (s, &endp);
-    if (s == endp)
+    s = parseReal(s, &rp->x);
+    if (!s)
 	return 0;
-    else
-	s = endp;
-
-    rp->w = strtod (s, &endp);
-    if (s == endp)
+    s = parseReal(s, &rp->y);
+    if (!s)
 	return 0;
-    else
-	s = endp;
-
-    rp->h = strtod (s, &endp);
-    if (s == endp)
+    s = parseReal(s, &rp->w);
+    if (!s)
 	return 0;
-    else
-	s = endp;
-
-    return s;
+    return parseReal(s, &rp->h);
 }
 
-static char *parsePolyline(char *s, xdot_polyline * pp)
+static char *parsePolyline(char *s, xdot_polyline * pp,
+                           struct xdot_arena_s **arena)
 {
     unsigned i;
     xdot_point *pts;
     xdot_point *ps;
-    char* endp;
 
     s = parseUInt(s, &i);
     if (!s) return NULL;
-    pts = ps = gv_calloc(i, sizeof(ps[0]));
+    pts = ps = xd_alloc(arena, i, sizeof(ps[0]));
     pp->cnt = i;
     for (i = 0; i < pp->cnt; i++) {
-	ps->x = strtod (s, &endp);
-	if (s == endp) {
-	    free (pts);
+	s = parseReal(s, &ps->x);
+	if (!s) {
+	    xd_free(arena, pts);
 	    return NULL;
 	}
-	else
-	    s = endp;
-	ps->y = strtod (s, &endp);
-	if (s == endp) {
-	    free (pts);
+	s = parseReal(s, &ps->y);
+	if (!s) {
+	    xd_free(arena, pts);
 	    return NULL;
 	}
-	else
-	    s = endp;
 	ps->z = 0;
 	ps++;
     }
@@ -117,7 +212,7 @@ static char *parsePolyline(char *s, xdot_polyline * pp)
     return s;
 }
 
-static char *parseString(char *s, char **sp)
+static char *parseString(char *s, char **sp, struct xdot_arena_s **arena)
 {
     int i;
     s = parseInt(s, &i);
@@ -132,21 +227,21 @@ static char *parseString(char *s, char **sp)
     // characters in the upcoming string. But the string may contain \-escaped
     // characters. So the count alone does not tell us how many bytes we need to
     // now read.
-    agxbuf c = {0};
-    int j = 0;
+    size_t j = 0;
     for (int accounted = 0; accounted < i; ++j) {
 	if (s[j] == '\0') {
-	    agxbfree(&c);
 	    return 0;
 	}
-	agxbputc(&c, s[j]);
 	// only count this character if it was not an escape prefix
 	if (s[j] != '\\' || (j > 0 && s[j - 1] == '\\')) {
 	    ++accounted;
 	}
     }
 
-    *sp = agxbdisown(&c);
+    char *str = xd_alloc(arena, j + 1, 1);
+    memcpy(str, s, j);
+    str[j] = '\0';
+    *sp = str;
     return s + j;
 }
 
@@ -164,9 +259,12 @@ static char *parseAlign(char *s, xdot_align * ap)
     return s;
 }
 
+static char *parseColor(char *cp, xdot_color *clr, struct xdot_arena_s **arena);
+
 #define CHK(s) if(!s){*error=1;return 0;}
 
-static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
+static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error,
+                     struct xdot_arena_s **arena)
 {
     char* cs;
     xdot_color clr;
@@ -193,7 +291,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'P':
 	op->kind = xd_filled_polygon;
-	s = parsePolyline(s, &op->u.polygon);
+	s = parsePolyline(s, &op->u.polygon, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polygon];
@@ -201,7 +299,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'p':
 	op->kind = xd_unfilled_polygon;
-	s = parsePolyline(s, &op->u.polygon);
+	s = parsePolyline(s, &op->u.polygon, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polygon];
@@ -209,7 +307,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'b':
 	op->kind = xd_filled_bezier;
-	s = parsePolyline(s, &op->u.bezier);
+	s = parsePolyline(s, &op->u.bezier, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_bezier];
@@ -217,16 +315,16 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'B':
 	op->kind = xd_unfilled_bezier;
-	s = parsePolyline(s, &op->u.bezier);
+	s = parsePolyline(s, &op->u.bezier, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_bezier];
 	break;
 
     case 'c':
-	s = parseString(s, &cs);
+	s = parseString(s, &cs, arena);
 	CHK(s);
-	cs = parseXDotColor (cs, &clr);
+	cs = parseColor(cs, &clr, arena);
 	CHK(cs);
 	if (clr.type == xd_none) {
 	    op->kind = xd_pen_color;
@@ -243,9 +341,9 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	break;
 
     case 'C':
-	s = parseString(s, &cs);
+	s = parseString(s, &cs, arena);
 	CHK(s);
-	cs = parseXDotColor (cs, &clr);
+	cs = parseColor(cs, &clr, arena);
 	CHK(cs);
 	if (clr.type == xd_none) {
 	    op->kind = xd_fill_color;
@@ -263,7 +361,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'L':
 	op->kind = xd_polyline;
-	s = parsePolyline(s, &op->u.polyline);
+	s = parsePolyline(s, &op->u.polyline, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_polyline];
@@ -279,7 +377,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	CHK(s);
 	s = parseReal(s, &op->u.text.width);
 	CHK(s);
-	s = parseString(s, &op->u.text.text);
+	s = parseString(s, &op->u.text.text, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_text];
@@ -289,7 +387,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	op->kind = xd_font;
 	s = parseReal(s, &op->u.font.size);
 	CHK(s);
-	s = parseString(s, &op->u.font.name);
+	s = parseString(s, &op->u.font.name, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_font];
@@ -297,7 +395,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 
     case 'S':
 	op->kind = xd_style;
-	s = parseString(s, &op->u.style);
+	s = parseString(s, &op->u.style, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_style];
@@ -307,7 +405,7 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
 	op->kind = xd_image;
 	s = parseRect(s, &op->u.image.pos);
 	CHK(s);
-	s = parseString(s, &op->u.image.name);
+	s = parseString(s, &op->u.image.name, arena);
 	CHK(s);
 	if (ops)
 	    op->drawfunc = ops[xop_image];
@@ -334,16 +432,12 @@ static char *parseOp(xdot_op * op, char *s, drawfunc_t ops[], int* error)
     return s;
 }
 
-#define XDBSIZE 100
-
-/* parseXDotFOn:
- * Parse and append additional xops onto a given xdot object.
- * Return x.
- */ 
-xdot *parseXDotFOn(char *s, drawfunc_t fns[], size_t sz, xdot *x) {
+/// parse and append xops onto a given xdot object
+///
+/// @param arena Allocate points and strings from an arena owned by `x`?
+static xdot *parseXDotOn(char *s, drawfunc_t fns[], size_t sz, xdot *x,
+                         bool arena) {
     xdot_op op;
-    char *ops;
-    size_t oldsz, bufsz;
     int error;
 
     if (!s)
@@ -354,37 +448,53 @@ xdot *parseXDotFOn(char *s, drawfunc_t fns[], size_t sz, xdot *x) {
 	if (sz <= sizeof(xdot_op))
 	    sz = sizeof(xdot_op);
 
-	/* cnt, freefunc, ops, flags zeroed by gv_alloc */
+	/* cnt, freefunc, ops, flags, arena zeroed by gv_alloc */
 	x->sz = sz;
     }
-    size_t initcnt = x->cnt;
     sz = x->sz;
 
-    if (initcnt == 0) {
-	bufsz = XDBSIZE;
-	ops = gv_calloc(XDBSIZE, sz);
-    }
-    else {
-	bufsz = initcnt + XDBSIZE;
-	ops = gv_recalloc(x->ops, initcnt, bufsz, sz);
+    // ops of an xdot either all use its arena or none do
+    struct xdot_arena_s **a = NULL;
+    if (x->arena != NULL || (arena && x->cnt == 0)) {
+	a = &x->arena;
+	// room for the points and strings of typical input
+	arena_reserve(a, 2 * strlen(s) + 64);
     }
 
-    while ((s = parseOp(&op, s, fns, &error))) {
-	if (x->cnt == bufsz) {
-	    oldsz = bufsz;
-	    bufsz *= 2;
-	    ops = gv_recalloc(ops, oldsz, bufsz, sz);
+    // collect ops locally, so the array of `x` is resized only once
+    enum { LOCAL_OPS = 32 };
+    xdot_op local[LOCAL_OPS];
+    xdot_op *parsed = local;
+    size_t n = 0;
+    size_t capacity = LOCAL_OPS;
+    while ((s = parseOp(&op, s, fns, &error, a))) {
+	if (n == capacity) {
+	    if (parsed == local) {
+		parsed = gv_calloc(capacity * 2, sizeof(parsed[0]));
+		memcpy(parsed, local, sizeof(local));
+	    } else {
+		parsed = gv_recalloc(parsed, capacity, capacity * 2,
+		                     sizeof(parsed[0]));
+	    }
+	    capacity *= 2;
 	}
-	*(xdot_op *) (ops + x->cnt * sz) = op;
-	x->cnt++;
+	parsed[n++] = op;
     }
     if (error)
 	x->flags |= XDOT_PARSE_ERROR;
-    if (x->cnt) {
-	x->ops = gv_recalloc(ops, bufsz, x->cnt, sz);
+
+    if (n > 0) {
+	char *ops = gv_recalloc(x->ops, x->cnt, x->cnt + n, sz);
+	for (size_t i = 0; i < n; ++i)
+	    *(xdot_op *)(ops + (x->cnt + i) * sz) = parsed[i];
+	x->ops = (xdot_op *)ops;
+	x->cnt += n;
     }
-    else {
-	free (ops);
+    if (parsed != local)
+	free(parsed);
+
+    if (x->cnt == 0) {
+	arena_free(x->arena);
 	free (x);
 	x = NULL;
     }
@@ -393,6 +503,14 @@ xdot *parseXDotFOn(char *s, drawfunc_t fns[], size_t sz, xdot *x) {
 
 }
 
+/* parseXDotFOn:
+ * Parse and append additional xops onto a given xdot object.
+ * Return x.
+ */ 
+xdot *parseXDotFOn(char *s, drawfunc_t fns[], size_t sz, xdot *x) {
+    return parseXDotOn(s, fns, sz, x, false);
+}
+
 xdot *parseXDotF(char *s, drawfunc_t fns[], size_t sz) {
     return parseXDotFOn (s, fns, sz, NULL);
 }
@@ -402,6 +520,81 @@ xdot *parseXDot(char *s)
     return parseXDotF(s, 0, 0);
 }
 
+xdot *parseXDotArena(char *s, drawfunc_t fns[], size_t sz, xdot *x) {
+    return parseXDotOn(s, fns, sz, x, true);
+}
+
+/// a range of the inputs of parseXDotArenaMany
+typedef struct {
+    char **s;
+    xdot **results;
+    size_t from, to;
+    drawfunc_t *fns;
+    size_t sz;
+} parse_range_t;
+
+static void *parse_range(void *arg) {
+    const parse_range_t *r = arg;
+    for (size_t i = r->from; i < r->to; ++i)
+	r->results[i] = parseXDotArena(r->s[i], r->fns, r->sz, NULL);
+    return NULL;
+}
+
+void parseXDotArenaMany(char *s[], size_t n, drawfunc_t fns[], size_t sz,
+                        xdot *results[], int threads) {
+#ifdef HAVE_PTHREAD
+    enum { MAX_THREADS = 64 };
+    if (threads <= 0) {
+	const long online = sysconf(_SC_NPROCESSORS_ONLN);
+	threads = online < 1 ? 1 : online > MAX_THREADS ? MAX_THREADS : (int)online;
+    }
+    if (threads > MAX_THREADS)
+	threads = MAX_THREADS;
+    if ((size_t)threads > n)
+	threads = n == 0 ? 1 : (int)n;
+
+    // give each thread a run of inputs of about the same total length
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i)
+	total += s[i] == NULL ? 0 : strlen(s[i]);
+    parse_range_t ranges[MAX_THREADS];
+    size_t from = 0;
+    size_t seen = 0;
+    for (int t = 0; t < threads; ++t) {
+	const size_t goal = total / (size_t)threads * (size_t)(t + 1);
+	size_t to = from;
+	if (t + 1 == threads) {
+	    to = n;
+	} else {
+	    while (to < n && seen < goal) {
+		seen += s[to] == NULL ? 0 : strlen(s[to]);
+		++to;
+	    }
+	}
+	ranges[t] = (parse_range_t){.s = s, .results = results, .from = from,
+	                            .to = to, .fns = fns, .sz = sz};
+	from = to;
+    }
+
+    pthread_t tid[MAX_THREADS];
+    bool started[MAX_THREADS] = {false};
+    for (int t = 1; t < threads; ++t)
+	started[t] = pthread_create(&tid[t], NULL, parse_range, &ranges[t]) == 0;
+    parse_range(&ranges[0]);
+    for (int t = 1; t < threads; ++t) {
+	if (started[t]) {
+	    pthread_join(tid[t], NULL);
+	} else {
+	    parse_range(&ranges[t]);
+	}
+    }
+#else
+    (void)threads;
+    parse_range(&(parse_range_t){.s = s, .results = results, .from = 0,
+                                 .to = n, .fns = fns, .sz = sz});
+#endif
+}
+
 typedef int (*pf)(void*, char*, ...);
 
 static void printRect(xdot_rect * r, pf print, void *info)
@@ -786,9 +979,12 @@ void freeXDot (xdot * x)
     for (size_t i = 0; i < x->cnt; i++) {
 	op = (xdot_op *) (base + i * x->sz);
 	if (ff) ff (op);
-	freeXOpData(op);
+	// data allocated from an arena is released with it
+	if (!x->arena)
+	    freeXOpData(op);
     }
     free(base);
+    arena_free(x->arena);
     free(x);
 }
 
@@ -853,14 +1049,14 @@ int statXDot (xdot* x, xdot_stats* sp)
     return 0;
 }
 
-#define CHK1(s) if(!s){free(stops);return NULL;}
+#define CHK1(s) if(!s){xd_free(arena, stops);return NULL;}
 
 /* radGradient:
  * Parse radial gradient spec
  * Return NULL on failure.
  */
 static char*
-radGradient (char* cp, xdot_color* clr)
+radGradient (char* cp, xdot_color* clr, struct xdot_arena_s **arena)
 {
     char* s = cp;
     int i;
@@ -883,12 +1079,12 @@ radGradient (char* cp, xdot_color* clr)
     s = parseInt(s, &clr->u.ring.n_stops);
     CHK1(s);
 
-    stops = gv_calloc(clr->u.ring.n_stops, sizeof(stops[0]));
+    stops = xd_alloc(arena, (size_t)clr->u.ring.n_stops, sizeof(stops[0]));
     for (i = 0; i < clr->u.ring.n_stops; i++) {
 	s = parseReal(s, &d);
 	CHK1(s);
 	stops[i].frac = d;
-	s = parseString(s, &stops[i].color);
+	s = parseString(s, &stops[i].color, arena);
 	CHK1(s);
     }
     clr->u.ring.stops = stops;
@@ -901,7 +1097,7 @@ radGradient (char* cp, xdot_color* clr)
  * Return NULL on failure.
  */
 static char*
-linGradient (char* cp, xdot_color* clr)
+linGradient (char* cp, xdot_color* clr, struct xdot_arena_s **arena)
 {
     char* s = cp;
     int i;
@@ -920,12 +1116,12 @@ linGradient (char* cp, xdot_color* clr)
     s = parseInt(s, &clr->u.ling.n_stops);
     CHK1(s);
 
-    stops = gv_calloc(clr->u.ling.n_stops, sizeof(stops[0]));
+    stops = xd_alloc(arena, (size_t)clr->u.ling.n_stops, sizeof(stops[0]));
     for (i = 0; i < clr->u.ling.n_stops; i++) {
 	s = parseReal(s, &d);
 	CHK1(s);
 	stops[i].frac = d;
-	s = parseString(s, &stops[i].color);
+	s = parseString(s, &stops[i].color, arena);
 	CHK1(s);
     }
     clr->u.ling.stops = stops;
@@ -933,22 +1129,17 @@ linGradient (char* cp, xdot_color* clr)
     return cp;
 }
 
-/* parseXDotColor:
- * Parse xdot color spec: ordinary or gradient
- * The result is stored in clr.
- * Return NULL on failure.
- */
-char*
-parseXDotColor (char* cp, xdot_color* clr)
+/// parse an xdot color spec, with storage from an arena or the heap
+static char *parseColor(char *cp, xdot_color *clr, struct xdot_arena_s **arena)
 {
     char c = *cp;
 
     switch (c) {
     case '[' :
-	return linGradient (cp+1, clr);
+	return linGradient (cp+1, clr, arena);
 	break;
     case '(' :
-	return radGradient (cp+1, clr);
+	return radGradient (cp+1, clr, arena);
 	break;
     case '#' :
     case '/' :
@@ -967,6 +1158,17 @@ parseXDotColor (char* cp, xdot_color* clr)
     }
 }
 
+/* parseXDotColor:
+ * Parse xdot color spec: ordinary or gradient
+ * The result is stored in clr.
+ * Return NULL on failure.
+ */
+char*
+parseXDotColor (char* cp, xdot_color* clr)
+{
+    return parseColor(cp, clr, NULL);
+}
+
 void freeXDotColor (xdot_color* cp)
 {
     int i;
@@ -985,6 +1187,79 @@ void freeXDotColor (xdot_color* cp)
     }
 }
 
+/// does a section of `count` items of `size` bytes at `offset` fit in `size`?
+static bool bin_section_ok(size_t total, uint32_t offset, uint32_t count,
+                           size_t size) {
+    if (offset % 4 != 0 || offset > total)
+	return false;
+    return count <= (total - offset) / size;
+}
+
+int xdotBinOpen(xdot_bin *xb, const void *data, size_t size)
+{
+    const xdot_bin_header *h = data;
+
+    if ((uintptr_t)data % 4 != 0 || size < sizeof(*h))
+	return XDOT_PARSE_ERROR;
+    if (memcmp(h->magic, XDOT_BIN_MAGIC, sizeof(h->magic)) != 0 ||
+        h->byte_order != XDOT_BIN_BYTE_ORDER || h->version != XDOT_BIN_VERSION)
+	return XDOT_PARSE_ERROR;
+    if (!bin_section_ok(size, h->objects, h->n_objects, sizeof(xdot_bin_object)) ||
+        !bin_section_ok(size, h->ops, h->n_ops, sizeof(xdot_bin_op)) ||
+        !bin_section_ok(size, h->points, h->n_points, 2 * sizeof(float)) ||
+        !bin_section_ok(size, h->strings, h->n_strings, sizeof(uint32_t)))
+	return XDOT_PARSE_ERROR;
+    const size_t string_data = h->strings + (size_t)h->n_strings * sizeof(uint32_t);
+    if (h->string_bytes > size - string_data)
+	return XDOT_PARSE_ERROR;
+
+    const char *base = data;
+    const xdot_bin_object *objects = (const void *)(base + h->objects);
+    const xdot_bin_op *ops = (const void *)(base + h->ops);
+    const uint32_t *offsets = (const void *)(base + h->strings);
+    const char *strings = base + string_data;
+
+    // every string must start within the data, which must end in a NUL
+    if (h->n_strings > 0 &&
+        (h->string_bytes == 0 || strings[h->string_bytes - 1] != '\0'))
+	return XDOT_PARSE_ERROR;
+    for (uint32_t i = 0; i < h->n_strings; ++i) {
+	if (offsets[i] >= h->string_bytes)
+	    return XDOT_PARSE_ERROR;
+    }
+
+    for (uint32_t i = 0; i < h->n_objects; ++i) {
+	const xdot_bin_object *o = &objects[i];
+	if (o->kind > xd_bin_edge || o->stream > xd_bin_tldraw ||
+	    (o->name != XDOT_BIN_NONE && o->name >= h->n_strings) ||
+	    o->first_op > h->n_ops || o->n_ops > h->n_ops - o->first_op)
+	    return XDOT_PARSE_ERROR;
+    }
+
+    for (uint32_t i = 0; i < h->n_ops; ++i) {
+	const xdot_bin_op *op = &ops[i];
+	if (op->kind > xd_fontchar ||
+	    op->first_point > h->n_points ||
+	    op->n_points > h->n_points - op->first_point)
+	    return XDOT_PARSE_ERROR;
+	if (op->kind != xd_fontchar && op->str != XDOT_BIN_NONE &&
+	    op->str >= h->n_strings)
+	    return XDOT_PARSE_ERROR;
+    }
+
+    *xb = (xdot_bin){.header = h, .objects = objects, .ops = ops,
+                     .points = (const void *)(base + h->points),
+                     .string_offsets = offsets, .strings = strings};
+    return 0;
+}
+
+const char *xdotBinString(const xdot_bin *xb, uint32_t index)
+{
+    if (index == XDOT_BIN_NONE)
+	return NULL;
+    return xb->strings + xb->string_offsets[index];
+}
+
 /**
  * @dir lib/xdot
  * @brief parsing and deparsing of xdot operations, API xdot.h
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -158,6 +159,7 @@ typedef struct {
     xdot_op* ops;
     freefunc_t freefunc;
     int flags;
+    struct xdot_arena_s *arena; /* storage of points and strings, or NULL */
 } xdot;
 
 typedef struct {
@@ -182,6 +184,17 @@ typedef struct {
 XDOT_API xdot *parseXDotF(char*, drawfunc_t opfns[], size_t sz);
 XDOT_API xdot *parseXDotFOn(char*, drawfunc_t opfns[], size_t sz, xdot*);
 XDOT_API xdot* parseXDot (char*);
+/* Like parseXDotFOn, but points and strings are allocated from an arena
+ * owned by the result and released all at once by freeXDot. The ops of an
+ * xdot either all use an arena or none do, so appending to an xdot without
+ * one behaves like parseXDotFOn.
+ */
+XDOT_API xdot *parseXDotArena(char*, drawfunc_t opfns[], size_t sz, xdot*);
+/* Parse n strings with parseXDotArena into results, spreading the work over
+ * up to threads threads, or one per processor if threads is 0.
+ */
+XDOT_API void parseXDotArenaMany(char *s[], size_t n, drawfunc_t opfns[],
+                                 size_t sz, xdot *results[], int threads);
 XDOT_API char* sprintXDot (xdot*);
 XDOT_API void fprintXDot (FILE*, xdot*);
 XDOT_API void jsonXDot (FILE*, xdot*);
@@ -191,6 +204,94 @@ XDOT_API xdot_grad_type colorTypeXDot (char*);
 XDOT_API char* parseXDotColor (char* cp, xdot_color* clr);
 XDOT_API void freeXDotColor (xdot_color*);
 
+/* Binary xdot, as written by -Txdot_bin
+ *
+ * A header followed by four sections, each 4-byte aligned: an index of
+ * objects, the ops they draw, the points of those ops as x, y float pairs and
+ * a table of strings. Everything refers to everything else by index, so the
+ * data can be mapped into memory and used where it lies. Numbers are in the
+ * byte order of the machine that wrote them.
+ */
+#define XDOT_BIN_MAGIC "GVXB"
+#define XDOT_BIN_BYTE_ORDER 0x01020304u
+#define XDOT_BIN_VERSION 1
+#define XDOT_BIN_NONE UINT32_MAX /* no string */
+
+typedef enum {
+    xd_bin_graph, xd_bin_cluster, xd_bin_node, xd_bin_edge
+} xdot_bin_object_kind;
+
+/* the attribute of an object the ops would be stored in by -Txdot */
+typedef enum {
+    xd_bin_draw,   /* _draw_ */
+    xd_bin_ldraw,  /* _ldraw_ */
+    xd_bin_hdraw,  /* _hdraw_ */
+    xd_bin_tdraw,  /* _tdraw_ */
+    xd_bin_hldraw, /* _hldraw_ */
+    xd_bin_tldraw  /* _tldraw_ */
+} xdot_bin_stream;
+
+typedef struct {
+    char magic[4];          /* XDOT_BIN_MAGIC */
+    uint32_t byte_order;    /* XDOT_BIN_BYTE_ORDER */
+    uint32_t version;       /* XDOT_BIN_VERSION */
+    uint32_t xdot_version;  /* of the ops, e.g. 17 for xdot 1.7 */
+    float bb[4];            /* bounding box: LL.x, LL.y, UR.x, UR.y */
+    uint32_t n_objects, objects; /* number and byte offset of objects */
+    uint32_t n_ops, ops;
+    uint32_t n_points, points;
+    uint32_t n_strings, strings; /* offsets of each string in the data */
+    uint32_t string_bytes;  /* size of the string data following them */
+} xdot_bin_header;
+
+typedef struct {
+    uint8_t kind;           /* xdot_bin_object_kind */
+    uint8_t stream;         /* xdot_bin_stream */
+    uint16_t reserved;
+    uint32_t id;            /* AGSEQ of the graph, subgraph, node or edge */
+    uint32_t name;          /* string index of its name, or XDOT_BIN_NONE */
+    uint32_t first_op;
+    uint32_t n_ops;
+} xdot_bin_object;
+
+typedef struct {
+    uint8_t kind;           /* xdot_kind */
+    uint8_t align;          /* xdot_align of xd_text */
+    uint16_t reserved;
+    /* string index of the color, text, font name, style or image name, or
+     * the flags of xd_fontchar. Gradients are given in their xdot text form,
+     * as accepted by parseXDotColor.
+     */
+    uint32_t str;
+    /* The numbers of the op, as x, y pairs in points: those of polygons,
+     * polylines and beziers; x, y then width, height of ellipses and images;
+     * x, y then width, 0 of text; size, 0 of fonts.
+     */
+    uint32_t first_point;
+    uint32_t n_points;
+} xdot_bin_op;
+
+/* binary xdot in memory; all pointers refer into the data given to
+ * xdotBinOpen
+ */
+typedef struct {
+    const xdot_bin_header *header;
+    const xdot_bin_object *objects;
+    const xdot_bin_op *ops;
+    const float *points;
+    const uint32_t *string_offsets;
+    const char *strings;
+} xdot_bin;
+
+/* Check size bytes of binary xdot at data and set up xb to read them. The
+ * data must be 4-byte aligned and outlive xb. Nothing is allocated or
+ * copied. Returns 0 on success and XDOT_PARSE_ERROR if the data is not valid
+ * binary xdot from a machine of the same byte order.
+ */
+XDOT_API int xdotBinOpen(xdot_bin *xb, const void *data, size_t size);
+/* string at index, or NULL for XDOT_BIN_NONE */
+XDOT_API const char *xdotBinString(const xdot_bin *xb, uint32_t index);
+
 #ifdef __cplusplus
 }
 #endif
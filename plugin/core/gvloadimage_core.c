@@ -341,6 +341,13 @@ gvplugin_installed_t gvloadimage_core_types[] = {
 
     {FORMAT_SVG_SVG, "svg:svg", 1, &engine_svg, NULL},
 
+    {FORMAT_PNG_SVG, "png:compact", 1, &engine_svg, NULL},
+    {FORMAT_GIF_SVG, "gif:compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpeg:compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpe:compact", 1, &engine_svg, NULL},
+    {FORMAT_JPEG_SVG, "jpg:compact", 1, &engine_svg, NULL},
+    {FORMAT_SVG_SVG, "svg:compact", 1, &engine_svg, NULL},
+
     {FORMAT_GIF_TK, "gif:tk", 1, &engine_tk, NULL},
 
     {0, NULL, 0, NULL, NULL}
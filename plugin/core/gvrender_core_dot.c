@@ -16,20 +16,24 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <common/macros.h>
 #include <common/const.h>
+#include <xdot/xdot.h>
 
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
 #include <cgraph/alloc.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/gv_ctype.h>
+#include <cgraph/list.h>
 #include <cgraph/prisize_t.h>
 #include <cgraph/streq.h>
 #include <cgraph/unreachable.h>
+#include <common/globals.h>
 #include <common/utils.h>
 #include <gvc/gvc.h>
 #include <gvc/gvio.h>
@@ -42,6 +46,8 @@ typedef enum {
 	FORMAT_XDOT,
 	FORMAT_XDOT12,
 	FORMAT_XDOT14,
+	FORMAT_GVB,
+	FORMAT_XDOT_BIN,
 } format_type;
 
 #define XDOTVERSION "1.7"
@@ -77,9 +83,171 @@ typedef struct {
     attrsym_t *tl_draw;
     unsigned short version;
     char* version_s;
+    bool binary; ///< writing binary xdot rather than attributes?
+    double y_off; ///< for inverting y in binary xdot
 } xdot_state_t;
 static xdot_state_t* xd;
 
+/* Binary xdot (-Txdot_bin) is produced by the same callbacks as xdot, but
+ * they append ops to the lists below rather than text to xbufs. The ops of
+ * each object are moved to the output lists as it ends, and everything is
+ * written out at the end of the graph. See xdot.h for the layout.
+ */
+DEFINE_LIST(xbin_ops, xdot_bin_op)
+DEFINE_LIST(xbin_objects, xdot_bin_object)
+DEFINE_LIST(xbin_floats, float)
+DEFINE_LIST(xbin_offsets, uint32_t)
+
+/// ops of one emit state, with point indices local to `points`
+typedef struct {
+    xbin_ops_t ops;
+    xbin_floats_t points;
+} xbin_buf_t;
+
+static struct {
+    xbin_buf_t bufs[NUMXBUFS]; ///< parallel to xbuf
+    /// index entries of the root graph, written first so it is drawn first
+    xbin_objects_t graph_objects;
+    xbin_objects_t objects;
+    xbin_ops_t ops;
+    xbin_floats_t points;
+    xbin_offsets_t string_offsets;
+    agxbuf strings; ///< NUL-terminated strings, each stored once
+    uint32_t *string_table; ///< hash table of string indices + 1, or 0
+    size_t string_table_size; ///< a power of 2
+} xbin;
+
+static double xdot_y(double y)
+{
+    if (xd->binary)
+	return Y_invert ? xd->y_off - y : y;
+    return yDir(y);
+}
+
+static uint64_t xbin_hash(const char *s)
+{
+    uint64_t h = 14695981039346656037ull; // FNV-1a
+    for (; *s != '\0'; ++s)
+	h = (h ^ (unsigned char)*s) * 1099511628211ull;
+    return h;
+}
+
+/// index of a string in the string table, adding it if necessary
+static uint32_t xbin_string(const char *s)
+{
+    const size_t count = xbin_offsets_size(&xbin.string_offsets);
+
+    // keep the table at most half full
+    if (2 * (count + 1) > xbin.string_table_size) {
+	const size_t size = xbin.string_table_size ? 2 * xbin.string_table_size : 256;
+	uint32_t *table = gv_calloc(size, sizeof(table[0]));
+	for (size_t i = 0; i < count; ++i) {
+	    const char *t = agxbstart(&xbin.strings) + xbin_offsets_get(&xbin.string_offsets, i);
+	    size_t slot = xbin_hash(t) & (size - 1);
+	    while (table[slot] != 0)
+		slot = (slot + 1) & (size - 1);
+	    table[slot] = (uint32_t)i + 1;
+	}
+	free(xbin.string_table);
+	xbin.string_table = table;
+	xbin.string_table_size = size;
+    }
+
+    size_t slot = xbin_hash(s) & (xbin.string_table_size - 1);
+    for (; xbin.string_table[slot] != 0;
+         slot = (slot + 1) & (xbin.string_table_size - 1)) {
+	const uint32_t i = xbin.string_table[slot] - 1;
+	const char *t = agxbstart(&xbin.strings) + xbin_offsets_get(&xbin.string_offsets, i);
+	if (streq(s, t))
+	    return i;
+    }
+
+    xbin_offsets_append(&xbin.string_offsets, (uint32_t)agxblen(&xbin.strings));
+    agxbput_n(&xbin.strings, s, strlen(s) + 1);
+    xbin.string_table[slot] = (uint32_t)count + 1;
+    return (uint32_t)count;
+}
+
+/// the ops of the current emit state
+static xbin_buf_t *xbin_buf(GVJ_t *job)
+{
+    return &xbin.bufs[xbufs[job->obj->emit_state] - xbuf];
+}
+
+/// append an op without points
+static xdot_bin_op *xbin_op(GVJ_t *job, xdot_kind kind)
+{
+    xbin_buf_t *b = xbin_buf(job);
+    xbin_ops_append(&b->ops, (xdot_bin_op){.kind = (uint8_t)kind,
+                                           .str = XDOT_BIN_NONE});
+    return xbin_ops_at(&b->ops, xbin_ops_size(&b->ops) - 1);
+}
+
+static void xbin_str_op(GVJ_t *job, xdot_kind kind, const char *s)
+{
+    xbin_op(job, kind)->str = xbin_string(s);
+}
+
+static void xbin_points(GVJ_t *job, xdot_kind kind, pointf *A, size_t n)
+{
+    xbin_buf_t *b = xbin_buf(job);
+    xdot_bin_op *op = xbin_op(job, kind);
+    op->first_point = (uint32_t)(xbin_floats_size(&b->points) / 2);
+    op->n_points = (uint32_t)n;
+    for (size_t i = 0; i < n; i++) {
+	xbin_floats_append(&b->points, (float)A[i].x);
+	xbin_floats_append(&b->points, (float)xdot_y(A[i].y));
+    }
+}
+
+/// append an op whose numbers are not points, as `n` pairs of `v`
+static xdot_bin_op *xbin_values(GVJ_t *job, xdot_kind kind, const double *v,
+                                size_t n)
+{
+    xbin_buf_t *b = xbin_buf(job);
+    xdot_bin_op *op = xbin_op(job, kind);
+    op->first_point = (uint32_t)(xbin_floats_size(&b->points) / 2);
+    op->n_points = (uint32_t)n;
+    for (size_t i = 0; i < 2 * n; i++)
+	xbin_floats_append(&b->points, (float)v[i]);
+    return op;
+}
+
+/// move the ops of an emit state to the output, as one stream of an object
+static void xbin_flush(xbin_objects_t *objects, emit_state_t emit_state,
+                       xdot_bin_object_kind kind, xdot_bin_stream stream,
+                       void *obj)
+{
+    xbin_buf_t *b = &xbin.bufs[xbufs[emit_state] - xbuf];
+    const size_t n_ops = xbin_ops_size(&b->ops);
+    if (n_ops == 0)
+	return;
+
+    const char *name = agnameof(obj);
+    const xdot_bin_object o = {
+	.kind = (uint8_t)kind,
+	.stream = (uint8_t)stream,
+	.id = (uint32_t)AGSEQ(obj),
+	.name = name ? xbin_string(name) : XDOT_BIN_NONE,
+	.first_op = (uint32_t)xbin_ops_size(&xbin.ops),
+	.n_ops = (uint32_t)n_ops,
+    };
+    xbin_objects_append(objects, o);
+
+    const uint32_t first_point = (uint32_t)(xbin_floats_size(&xbin.points) / 2);
+    for (size_t i = 0; i < n_ops; i++) {
+	xdot_bin_op op = xbin_ops_get(&b->ops, i);
+	if (op.n_points > 0)
+	    op.first_point += first_point;
+	xbin_ops_append(&xbin.ops, op);
+    }
+    for (size_t i = 0; i < xbin_floats_size(&b->points); i++)
+	xbin_floats_append(&xbin.points, xbin_floats_get(&b->points, i));
+
+    xbin_ops_clear(&b->ops);
+    xbin_floats_clear(&b->points);
+}
+
 static void xdot_str_xbuf (agxbuf* xb, char* pfx, const char* s)
 {
     agxbprint (xb, "%s%" PRISIZE_T " -%s ", pfx, strlen(s), s);
@@ -101,10 +269,10 @@ static void xdot_fmt_num(agxbuf *buf, double v) {
   agxbputc(buf, ' ');
 }
 
-static void xdot_point(agxbuf *xb, pointf p)
+static void xdot_fmt_point(agxbuf *xb, pointf p)
 {
   xdot_fmt_num(xb, p.x);
-  xdot_fmt_num(xb, yDir(p.y));
+  xdot_fmt_num(xb, xdot_y(p.y));
 }
 
 static void xdot_num(agxbuf *xb, double v)
@@ -114,9 +282,20 @@ static void xdot_num(agxbuf *xb, double v)
 
 static void xdot_points(GVJ_t *job, char c, pointf *A, size_t n) {
     emit_state_t emit_state = job->obj->emit_state;
+    if (xd->binary) {
+	switch (c) {
+	    case 'b': xbin_points(job, xd_filled_bezier, A, n); break;
+	    case 'B': xbin_points(job, xd_unfilled_bezier, A, n); break;
+	    case 'P': xbin_points(job, xd_filled_polygon, A, n); break;
+	    case 'p': xbin_points(job, xd_unfilled_polygon, A, n); break;
+	    case 'L': xbin_points(job, xd_polyline, A, n); break;
+	    default: UNREACHABLE();
+	}
+	return;
+    }
     agxbprint(xbufs[emit_state], "%c %" PRISIZE_T " ", c, n);
     for (size_t i = 0; i < n; i++)
-        xdot_point(xbufs[emit_state], A[i]);
+        xdot_fmt_point(xbufs[emit_state], A[i]);
 }
 
 static char*
@@ -134,12 +313,26 @@ color2str (unsigned char rgba[4])
 
 static void xdot_pencolor (GVJ_t *job)
 {
-    xdot_str (job, "c ", color2str (job->obj->pencolor.u.rgba));
+    if (xd->binary)
+	xbin_str_op(job, xd_pen_color, color2str(job->obj->pencolor.u.rgba));
+    else
+	xdot_str (job, "c ", color2str (job->obj->pencolor.u.rgba));
 }
 
 static void xdot_fillcolor (GVJ_t *job)
 {
-    xdot_str (job, "C ", color2str (job->obj->fillcolor.u.rgba));
+    if (xd->binary)
+	xbin_str_op(job, xd_fill_color, color2str(job->obj->fillcolor.u.rgba));
+    else
+	xdot_str (job, "C ", color2str (job->obj->fillcolor.u.rgba));
+}
+
+static void xdot_style_str(GVJ_t *job, const char *style)
+{
+    if (xd->binary)
+	xbin_str_op(job, xd_style, style);
+    else
+	xdot_str(job, "S ", style);
 }
 
 static void xdot_style (GVJ_t *job)
@@ -154,7 +347,7 @@ static void xdot_style (GVJ_t *job)
 	agxbprint(&xb, "%.3f", job->obj->penwidth);
 	agxbuf_trim_zeros(&xb);
 	agxbputc(&xb, ')');
-        xdot_str (job, "S ", agxbuse(&xb));
+        xdot_style_str(job, agxbuse(&xb));
     }
 
     /* now process raw style, if any */
@@ -179,7 +372,7 @@ static void xdot_style (GVJ_t *job)
             }
             agxbputc(&xb, ')');
         }
-        xdot_str (job, "S ", agxbuse(&xb));
+        xdot_style_str(job, agxbuse(&xb));
     }
 
     agxbfree(&xb);
@@ -221,10 +414,15 @@ static void put_escaping_backslashes(Agobj_t* n, Agsym_t *sym, const char *value
 static void xdot_end_node(GVJ_t* job)
 {
     Agnode_t* n = job->obj->u.n; 
-    if (agxblen(xbufs[EMIT_NDRAW]))
-	agxset(n, xd->n_draw, agxbuse(xbufs[EMIT_NDRAW]));
-    if (agxblen(xbufs[EMIT_NLABEL]))
-	put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs[EMIT_NLABEL]));
+    if (xd->binary) {
+	xbin_flush(&xbin.objects, EMIT_NDRAW, xd_bin_node, xd_bin_draw, n);
+	xbin_flush(&xbin.objects, EMIT_NLABEL, xd_bin_node, xd_bin_ldraw, n);
+    } else {
+	if (agxblen(xbufs[EMIT_NDRAW]))
+	    agxset(n, xd->n_draw, agxbuse(xbufs[EMIT_NDRAW]));
+	if (agxblen(xbufs[EMIT_NLABEL]))
+	    put_escaping_backslashes(&n->base, xd->n_l_draw, agxbuse(xbufs[EMIT_NLABEL]));
+    }
     penwidth[EMIT_NDRAW] = 1;
     penwidth[EMIT_NLABEL] = 1;
     textflags[EMIT_NDRAW] = 0;
@@ -235,18 +433,27 @@ static void xdot_end_edge(GVJ_t* job)
 {
     Agedge_t* e = job->obj->u.e; 
 
-    if (agxblen(xbufs[EMIT_EDRAW]))
-	agxset(e, xd->e_draw, agxbuse(xbufs[EMIT_EDRAW]));
-    if (agxblen(xbufs[EMIT_TDRAW]))
-	agxset(e, xd->t_draw, agxbuse(xbufs[EMIT_TDRAW]));
-    if (agxblen(xbufs[EMIT_HDRAW]))
-	agxset(e, xd->h_draw, agxbuse(xbufs[EMIT_HDRAW]));
-    if (agxblen(xbufs[EMIT_ELABEL]))
-	put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs[EMIT_ELABEL]));
-    if (agxblen(xbufs[EMIT_TLABEL]))
-	agxset(e, xd->tl_draw, agxbuse(xbufs[EMIT_TLABEL]));
-    if (agxblen(xbufs[EMIT_HLABEL]))
-	agxset(e, xd->hl_draw, agxbuse(xbufs[EMIT_HLABEL]));
+    if (xd->binary) {
+	xbin_flush(&xbin.objects, EMIT_EDRAW, xd_bin_edge, xd_bin_draw, e);
+	xbin_flush(&xbin.objects, EMIT_ELABEL, xd_bin_edge, xd_bin_ldraw, e);
+	xbin_flush(&xbin.objects, EMIT_HDRAW, xd_bin_edge, xd_bin_hdraw, e);
+	xbin_flush(&xbin.objects, EMIT_TDRAW, xd_bin_edge, xd_bin_tdraw, e);
+	xbin_flush(&xbin.objects, EMIT_HLABEL, xd_bin_edge, xd_bin_hldraw, e);
+	xbin_flush(&xbin.objects, EMIT_TLABEL, xd_bin_edge, xd_bin_tldraw, e);
+    } else {
+	if (agxblen(xbufs[EMIT_EDRAW]))
+	    agxset(e, xd->e_draw, agxbuse(xbufs[EMIT_EDRAW]));
+	if (agxblen(xbufs[EMIT_TDRAW]))
+	    agxset(e, xd->t_draw, agxbuse(xbufs[EMIT_TDRAW]));
+	if (agxblen(xbufs[EMIT_HDRAW]))
+	    agxset(e, xd->h_draw, agxbuse(xbufs[EMIT_HDRAW]));
+	if (agxblen(xbufs[EMIT_ELABEL]))
+	    put_escaping_backslashes(&e->base, xd->e_l_draw, agxbuse(xbufs[EMIT_ELABEL]));
+	if (agxblen(xbufs[EMIT_TLABEL]))
+	    agxset(e, xd->tl_draw, agxbuse(xbufs[EMIT_TLABEL]));
+	if (agxblen(xbufs[EMIT_HLABEL]))
+	    agxset(e, xd->hl_draw, agxbuse(xbufs[EMIT_HLABEL]));
+    }
     penwidth[EMIT_EDRAW] = 1;
     penwidth[EMIT_ELABEL] = 1;
     penwidth[EMIT_TDRAW] = 1;
@@ -265,9 +472,14 @@ static void xdot_end_cluster(GVJ_t * job)
 {
     Agraph_t* cluster_g = job->obj->u.sg;
 
-    agxset(cluster_g, xd->g_draw, agxbuse(xbufs[EMIT_CDRAW]));
-    if (GD_label(cluster_g))
-	agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs[EMIT_CLABEL]));
+    if (xd->binary) {
+	xbin_flush(&xbin.objects, EMIT_CDRAW, xd_bin_cluster, xd_bin_draw, cluster_g);
+	xbin_flush(&xbin.objects, EMIT_CLABEL, xd_bin_cluster, xd_bin_ldraw, cluster_g);
+    } else {
+	agxset(cluster_g, xd->g_draw, agxbuse(xbufs[EMIT_CDRAW]));
+	if (GD_label(cluster_g))
+	    agxset(cluster_g, xd->g_l_draw, agxbuse(xbufs[EMIT_CLABEL]));
+    }
     penwidth[EMIT_CDRAW] = 1;
     penwidth[EMIT_CLABEL] = 1;
     textflags[EMIT_CDRAW] = 0;
@@ -337,6 +549,15 @@ static void xdot_begin_graph(graph_t *g, bool s_arrows, bool e_arrows,
 	xd->version_s = XDOTVERSION;
     }
 
+    for (i = 0; i < NUMXBUFS; i++)
+	xbuf[i] = (agxbuf){0};
+
+    if (id == FORMAT_XDOT_BIN) {
+	xd->binary = true;
+	xd->y_off = GD_bb(g).UR.y + GD_bb(g).LL.y;
+	return;
+    }
+
     if (GD_n_cluster(g))
 	xd->g_draw = safe_dcl(g, AGRAPH, "_draw_", "");
     else
@@ -370,9 +591,6 @@ static void xdot_begin_graph(graph_t *g, bool s_arrows, bool e_arrows,
 	xd->tl_draw = safe_dcl(g, AGEDGE, "_tldraw_", "");
     else
 	xd->tl_draw = NULL;
-
-    for (i = 0; i < NUMXBUFS; i++)
-	xbuf[i] = (agxbuf){0};
 }
 
 static void dot_begin_graph(GVJ_t *job)
@@ -381,6 +599,7 @@ static void dot_begin_graph(GVJ_t *job)
 
     switch (job->render.id) {
 	case FORMAT_DOT:
+	case FORMAT_GVB:
 	    attach_attrs(g);
 	    break;
 	case FORMAT_CANON:
@@ -399,6 +618,10 @@ static void dot_begin_graph(GVJ_t *job)
 	    xdot_begin_graph(g, s_arrows, e_arrows, job->render.id);
 	    break;
 	}
+	case FORMAT_XDOT_BIN:
+	    // nothing is written as attributes, so there is nothing to attach
+	    xdot_begin_graph(g, false, false, job->render.id);
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -426,6 +649,96 @@ static void xdot_end_graph(graph_t* g)
     textflags[EMIT_GLABEL] = 0;
 }
 
+/// write out the binary xdot of a graph
+static void xbin_write(GVJ_t *job, graph_t *g)
+{
+    const size_t n_graph_objects = xbin_objects_size(&xbin.graph_objects);
+    const size_t n_objects = n_graph_objects + xbin_objects_size(&xbin.objects);
+    const size_t n_ops = xbin_ops_size(&xbin.ops);
+    const size_t n_points = xbin_floats_size(&xbin.points) / 2;
+    const size_t n_strings = xbin_offsets_size(&xbin.string_offsets);
+    const size_t string_bytes = agxblen(&xbin.strings);
+
+    xdot_bin_header h = {
+	.magic = XDOT_BIN_MAGIC,
+	.byte_order = XDOT_BIN_BYTE_ORDER,
+	.version = XDOT_BIN_VERSION,
+	.xdot_version = xd->version,
+	.bb = {(float)GD_bb(g).LL.x, (float)GD_bb(g).LL.y,
+	       (float)GD_bb(g).UR.x, (float)GD_bb(g).UR.y},
+    };
+    size_t size = sizeof(h);
+    h.n_objects = (uint32_t)n_objects;
+    h.objects = (uint32_t)size;
+    size += n_objects * sizeof(xdot_bin_object);
+    h.n_ops = (uint32_t)n_ops;
+    h.ops = (uint32_t)size;
+    size += n_ops * sizeof(xdot_bin_op);
+    h.n_points = (uint32_t)n_points;
+    h.points = (uint32_t)size;
+    size += n_points * 2 * sizeof(float);
+    h.n_strings = (uint32_t)n_strings;
+    h.strings = (uint32_t)size;
+    size += n_strings * sizeof(uint32_t);
+    h.string_bytes = (uint32_t)string_bytes;
+    size += string_bytes;
+    if (size > UINT32_MAX) {
+	agerrorf("graph %s is too large for xdot_bin output\n", agnameof(g));
+	return;
+    }
+
+    gvwrite(job, (const char *)&h, sizeof(h));
+    if (n_graph_objects > 0)
+	gvwrite(job, (const char *)xbin_objects_at(&xbin.graph_objects, 0),
+	        n_graph_objects * sizeof(xdot_bin_object));
+    if (n_objects > n_graph_objects)
+	gvwrite(job, (const char *)xbin_objects_at(&xbin.objects, 0),
+	        (n_objects - n_graph_objects) * sizeof(xdot_bin_object));
+    if (n_ops > 0)
+	gvwrite(job, (const char *)xbin_ops_at(&xbin.ops, 0),
+	        n_ops * sizeof(xdot_bin_op));
+    if (n_points > 0)
+	gvwrite(job, (const char *)xbin_floats_at(&xbin.points, 0),
+	        n_points * 2 * sizeof(float));
+    if (n_strings > 0) {
+	gvwrite(job, (const char *)xbin_offsets_at(&xbin.string_offsets, 0),
+	        n_strings * sizeof(uint32_t));
+	gvwrite(job, agxbstart(&xbin.strings), string_bytes);
+    }
+}
+
+static void xbin_end_graph(GVJ_t *job, graph_t *g)
+{
+    xbin_flush(&xbin.graph_objects, EMIT_GDRAW, xd_bin_graph, xd_bin_draw, g);
+    xbin_flush(&xbin.graph_objects, EMIT_GLABEL, xd_bin_graph, xd_bin_ldraw, g);
+    if (!(job->flags & OUTPUT_NOT_REQUIRED))
+	xbin_write(job, g);
+
+    for (size_t i = 0; i < NUMXBUFS; i++) {
+	xbin_ops_free(&xbin.bufs[i].ops);
+	xbin_floats_free(&xbin.bufs[i].points);
+	agxbfree(xbuf + i);
+    }
+    xbin_objects_free(&xbin.graph_objects);
+    xbin_objects_free(&xbin.objects);
+    xbin_ops_free(&xbin.ops);
+    xbin_floats_free(&xbin.points);
+    xbin_offsets_free(&xbin.string_offsets);
+    agxbfree(&xbin.strings);
+    free(xbin.string_table);
+    xbin.string_table = NULL;
+    xbin.string_table_size = 0;
+    free(xd);
+    for (size_t i = 0; i < sizeof(penwidth) / sizeof(penwidth[0]); i++)
+	penwidth[i] = 1;
+    memset(textflags, 0, sizeof(textflags));
+}
+
+static size_t gvb_write(void *chan, const char *buf, size_t size)
+{
+    return gvwrite(chan, buf, size);
+}
+
 typedef int (*putstrfn) (void *chan, const char *str);
 typedef int (*flushfn) (void *chan);
 static void dot_end_graph(GVJ_t *job)
@@ -461,6 +774,13 @@ static void dot_end_graph(GVJ_t *job)
 	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
 		agwrite(g, job);
 	    break;
+	case FORMAT_GVB:
+	    if (!(job->flags & OUTPUT_NOT_REQUIRED))
+		agwritebin(g, job, gvb_write);
+	    break;
+	case FORMAT_XDOT_BIN:
+	    xbin_end_graph(job, g);
+	    break;
 	default:
 	    UNREACHABLE();
     }
@@ -475,9 +795,14 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
     unsigned flags;
     int j;
     
-    agxbput(xbufs[emit_state], "F ");
-    xdot_fmt_num(xbufs[emit_state], span->font->size);
-    xdot_str (job, "", span->font->name);
+    if (xd->binary) {
+	const double v[] = {span->font->size, 0};
+	xbin_values(job, xd_font, v, 1)->str = xbin_string(span->font->name);
+    } else {
+	agxbput(xbufs[emit_state], "F ");
+	xdot_fmt_num(xbufs[emit_state], span->font->size);
+	xdot_str (job, "", span->font->name);
+    }
     xdot_pencolor(job);
 
     switch (span->just) {
@@ -501,20 +826,30 @@ static void xdot_textspan(GVJ_t * job, pointf p, textspan_t * span)
 	unsigned int mask = flag_masks[xd->version-15];
 	unsigned int bits = flags & mask;
 	if (textflags[emit_state] != bits) {
-	    agxbprint(xbufs[emit_state], "t %u ", bits);
+	    if (xd->binary)
+		xbin_op(job, xd_fontchar)->str = bits;
+	    else
+		agxbprint(xbufs[emit_state], "t %u ", bits);
 	    textflags[emit_state] = bits;
 	}
     }
 
     p.y += span->yoffset_centerline;
+    if (xd->binary) {
+	const double v[] = {p.x, xdot_y(p.y), span->size.x, 0};
+	xdot_bin_op *op = xbin_values(job, xd_text, v, 2);
+	op->align = (uint8_t)(j < 0 ? xd_left : j > 0 ? xd_right : xd_center);
+	op->str = xbin_string(span->str);
+	return;
+    }
     agxbput(xbufs[emit_state], "T ");
-    xdot_point(xbufs[emit_state], p);
+    xdot_fmt_point(xbufs[emit_state], p);
     agxbprint(xbufs[emit_state], "%d ", j);
     xdot_fmt_num(xbufs[emit_state], span->size.x);
     xdot_str (job, "", span->str);
 }
 
-static void xdot_color_stop (agxbuf* xb, float v, gvcolor_t* clr)
+static void xdot_fmt_color_stop (agxbuf* xb, float v, gvcolor_t* clr)
 {
   agxbprint(xb, "%.03f", v);
   agxbuf_trim_zeros(xb);
@@ -537,8 +872,8 @@ static void xdot_gradient_fillcolor(GVJ_t *job, int filled, pointf *A, size_t n)
     if (filled == GRADIENT) {
 	get_gradient_points(A, G, n, angle, 2);
 	agxbputc (&xb, '[');
-	xdot_point (&xb, G[0]);
-	xdot_point (&xb, G[1]);
+	xdot_fmt_point (&xb, G[0]);
+	xdot_fmt_point (&xb, G[1]);
     }
     else {
 	get_gradient_points(A, G, n, 0, 3);
@@ -556,27 +891,30 @@ static void xdot_gradient_fillcolor(GVJ_t *job, int filled, pointf *A, size_t n)
 	c2.y = G[0].y;
 	double r1 = r2 / 4;
 	agxbputc(&xb, '(');
-	xdot_point (&xb, c1);
+	xdot_fmt_point (&xb, c1);
 	xdot_num (&xb, r1);
-	xdot_point (&xb, c2);
+	xdot_fmt_point (&xb, c2);
 	xdot_num (&xb, r2);
     }
     
     agxbput(&xb, "2 ");
     if (obj->gradient_frac > 0) {
-	xdot_color_stop (&xb, obj->gradient_frac, &obj->fillcolor);
-	xdot_color_stop (&xb, obj->gradient_frac, &obj->stopcolor);
+	xdot_fmt_color_stop (&xb, obj->gradient_frac, &obj->fillcolor);
+	xdot_fmt_color_stop (&xb, obj->gradient_frac, &obj->stopcolor);
     }
     else {
-	xdot_color_stop (&xb, 0, &obj->fillcolor);
-	xdot_color_stop (&xb, 1, &obj->stopcolor);
+	xdot_fmt_color_stop (&xb, 0, &obj->fillcolor);
+	xdot_fmt_color_stop (&xb, 1, &obj->stopcolor);
     }
     agxbpop(&xb);
     if (filled == GRADIENT)
 	agxbputc(&xb, ']');
     else
 	agxbputc(&xb, ')');
-    xdot_str (job, "C ", agxbuse(&xb));
+    if (xd->binary)
+	xbin_str_op(job, xd_grad_fill_color, agxbuse(&xb));
+    else
+	xdot_str (job, "C ", agxbuse(&xb));
     agxbfree(&xb);
 }
 
@@ -592,11 +930,15 @@ static void xdot_ellipse(GVJ_t * job, pointf * A, int filled)
 	}
         else 
 	    xdot_fillcolor (job);
-        agxbput(xbufs[emit_state], "E ");
     }
-    else
-        agxbput(xbufs[emit_state], "e ");
-    xdot_point(xbufs[emit_state], A[0]);
+    if (xd->binary) {
+	const double v[] = {A[0].x, xdot_y(A[0].y), A[1].x - A[0].x,
+	                    A[1].y - A[0].y};
+	xbin_values(job, filled ? xd_filled_ellipse : xd_unfilled_ellipse, v, 2);
+	return;
+    }
+    agxbput(xbufs[emit_state], filled ? "E " : "e ");
+    xdot_fmt_point(xbufs[emit_state], A[0]);
     xdot_fmt_num(xbufs[emit_state], A[1].x - A[0].x);
     xdot_fmt_num(xbufs[emit_state], A[1].y - A[0].y);
 }
@@ -631,7 +973,7 @@ static void xdot_polygon(GVJ_t *job, pointf *A, size_t n, int filled) {
         xdot_points(job, 'p', A, n);
 }
 
-static void xdot_polyline(GVJ_t *job, pointf *A, size_t n) {
+static void xdot_render_polyline(GVJ_t *job, pointf *A, size_t n) {
     xdot_style (job);
     xdot_pencolor (job);
     xdot_points(job, 'L', A, n);
@@ -642,9 +984,15 @@ void core_loadimage_xdot(GVJ_t * job, usershape_t *us, boxf b, bool filled)
     (void)filled;
 
     emit_state_t emit_state = job->obj->emit_state;
-    
+
+    if (xd->binary) {
+	const double v[] = {b.LL.x, xdot_y(b.LL.y), b.UR.x - b.LL.x,
+	                    b.UR.y - b.LL.y};
+	xbin_values(job, xd_image, v, 2)->str = xbin_string(us->name);
+	return;
+    }
     agxbput(xbufs[emit_state], "I ");
-    xdot_point(xbufs[emit_state], b.LL);
+    xdot_fmt_point(xbufs[emit_state], b.LL);
     xdot_fmt_num(xbufs[emit_state], b.UR.x - b.LL.x);
     xdot_fmt_num(xbufs[emit_state], b.UR.y - b.LL.y);
     xdot_str (job, "", us->name);
@@ -711,7 +1059,7 @@ gvrender_engine_t xdot_engine = {
     xdot_ellipse,
     xdot_polygon,
     xdot_bezier,
-    xdot_polyline,
+    xdot_render_polyline,
     0,				/* xdot_comment */
     0,				/* xdot_library_shape */
 };
@@ -749,6 +1097,20 @@ gvdevice_features_t device_features_dot = {
     {72.,72.},			/* default dpi */
 };
 
+gvdevice_features_t device_features_gvb = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
+gvdevice_features_t device_features_xdot_bin = {
+    GVDEVICE_BINARY_FORMAT,	/* flags */
+    {0.,0.},			/* default margin - points */
+    {0.,0.},			/* default page width, height - points */
+    {72.,72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_dot_types[] = {
     {FORMAT_DOT, "dot", 1, &dot_engine, &render_features_dot},
     {FORMAT_XDOT, "xdot", 1, &xdot_engine, &render_features_xdot},
@@ -764,5 +1126,7 @@ gvplugin_installed_t gvdevice_dot_types[] = {
     {FORMAT_XDOT, "xdot:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT12, "xdot1.2:xdot", 1, NULL, &device_features_dot},
     {FORMAT_XDOT14, "xdot1.4:xdot", 1, NULL, &device_features_dot},
+    {FORMAT_GVB, "gvb:dot", 1, NULL, &device_features_gvb},
+    {FORMAT_XDOT_BIN, "xdot_bin:xdot", 1, NULL, &device_features_xdot_bin},
     {0, NULL, 0, NULL, NULL}
 };
@@ -14,8 +14,11 @@
 #include <io.h>
 #endif
 
+#include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -26,6 +29,7 @@
 
 #include <gvc/gvplugin_render.h>
 #include <gvc/gvplugin_device.h>
+#include <cgraph/agxbuf.h>
 #include <cgraph/alloc.h>
 #include <cgraph/startswith.h>
 #include <cgraph/streq.h>
@@ -42,21 +46,28 @@ typedef enum {
 	FORMAT_XDOT_JSON,
 } format_type;
 
+/* The output is built in `out` and handed to the job in large pieces, as
+ * each top level object is finished. Numbers, indentation and strings are
+ * formatted directly into it rather than through gvprintf.
+ */
 typedef struct {
     int Level;
     bool isLatin;
     bool doXDot;
+    agxbuf out;      ///< output not yet written
+    int *node_ids;   ///< `_gvid` of each node, indexed by `AGSEQ`
+    int *edge_ids;   ///< `_gvid` of each edge, indexed by `AGSEQ`
+    int *subg_ids;   ///< `_gvid` of each subgraph, indexed by `AGSEQ`
+    Agedge_t **edges; ///< all edges of the root graph, in `AGSEQ` order
+    size_t n_edges;
 } state_t;
 
-typedef struct {
-    Agrec_t h;
-    int id;
-} gvid_t;
+/// how much output to collect before writing it
+enum { FLUSH_SIZE = 64 * 1024 };
 
-#define ID "id"
-#define ND_gid(n) (((gvid_t*)aggetrec(n, ID, 0))->id) 
-#define ED_gid(n) (((gvid_t*)aggetrec(n, ID, 0))->id) 
-#define GD_gid(n) (((gvid_t*)aggetrec(n, ID, 0))->id) 
+#define ND_gid(sp, n) ((sp)->node_ids[AGSEQ(n)])
+#define ED_gid(sp, e) ((sp)->edge_ids[AGSEQ(e)])
+#define GD_gid(sp, g) ((sp)->subg_ids[AGSEQ(g)])
 
 static bool IS_CLUSTER(Agraph_t *s) {
   return startswith(agnameof(s), "cluster");
@@ -77,66 +88,145 @@ static void json_begin_graph(GVJ_t *job)
 
 #define LOCALNAMEPREFIX		'%'
 
+/// write out the collected output if there is enough of it, or all of it
+static void flush(GVJ_t *job, state_t *sp, bool all)
+{
+    const size_t len = agxblen(&sp->out);
+    if (len >= FLUSH_SIZE || (all && len > 0)) {
+	gvwrite(job, agxbstart(&sp->out), len);
+	agxbclear(&sp->out);
+    }
+}
+
+static void put(state_t *sp, const char *s)
+{
+    agxbput(&sp->out, s);
+}
+
+static void put_int(state_t *sp, int v)
+{
+    char buf[16];
+    char *p = buf + sizeof(buf);
+    unsigned u = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+    do {
+	*--p = (char)('0' + u % 10);
+	u /= 10;
+    } while (u > 0);
+    if (v < 0)
+	*--p = '-';
+    agxbput_n(&sp->out, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/** append a number as `"%.03f"` would print it
+ *
+ * Moderately sized numbers are converted here. Those whose scaled fraction
+ * is too close to a rounding tie to decide with `double` arithmetic, and
+ * large ones, are left to `printf`.
+ */
+static void put_num(state_t *sp, double v)
+{
+    if (v > -1e8 && v < 1e8) {
+	const double scaled = fabs(v) * 1000;
+	const double whole = floor(scaled);
+	const double frac = scaled - whole;
+	if (fabs(frac - 0.5) >= 1e-4) {
+	    uint64_t digits = (uint64_t)whole + (frac > 0.5);
+	    char buf[24];
+	    char *p = buf + sizeof(buf);
+	    for (int i = 0; i < 3; i++) {
+		*--p = (char)('0' + digits % 10);
+		digits /= 10;
+	    }
+	    *--p = '.';
+	    do {
+		*--p = (char)('0' + digits % 10);
+		digits /= 10;
+	    } while (digits > 0);
+	    if (signbit(v))
+		*--p = '-';
+	    agxbput_n(&sp->out, p, (size_t)(buf + sizeof(buf) - p));
+	    return;
+	}
+    }
+    agxbprint(&sp->out, "%.03f", v);
+}
+
+/// escape sequences of the characters `stoj` escapes
+static const char *const escapes[UCHAR_MAX + 1] = {
+    ['"'] = "\\\"", ['\\'] = "\\\\", ['/'] = "\\/", ['\b'] = "\\b",
+    ['\f'] = "\\f", ['\n'] = "\\n",  ['\r'] = "\\r", ['\t'] = "\\t",
+};
+
+/// might any of the 8 bytes of `w` need escaping?
+///
+/// This tests for the bytes '"', '/' and '\\' and anything below '\r' + 1,
+/// which covers the escaped control characters.
+static bool maybe_escaped(uint64_t w)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    const uint64_t quote = w ^ (ones * '"');
+    const uint64_t slash = w ^ (ones * '/');
+    const uint64_t backslash = w ^ (ones * '\\');
+    const uint64_t zero = ((quote - ones) & ~quote) | ((slash - ones) & ~slash) |
+                          ((backslash - ones) & ~backslash);
+    const uint64_t low = (w - ones * ('\r' + 1)) & ~w;
+    return ((zero | low) & highs) != 0;
+}
+
 /** Convert dot string to a valid json string embedded in double quotes and
  *   output
  *
+ * Runs of characters that need no escaping are found 8 bytes at a time and
+ * copied in one go.
+ *
  * \param ins Input string
  * \param sp State, used to determine encoding of the input string
- * \param job Output job
  */
-static void stoj(char *ins, state_t *sp, GVJ_t *job) {
-    char* s;
+static void stoj(char *ins, state_t *sp) {
     char* input;
-    char c;
 
     if (sp->isLatin)
 	input = latin1ToUTF8 (ins);
     else
 	input = ins;
 
-    gvputc(job, '"');
-    for (s = input; (c = *s); s++) {
-	switch (c) {
-	case '"' :
-	    gvputs(job, "\\\"");
-	    break;
-	case '\\' :
-	    gvputs(job, "\\\\");
-	    break;
-	case '/' :
-	    gvputs(job, "\\/");
-	    break;
-	case '\b' :
-	    gvputs(job, "\\b");
-	    break;
-	case '\f' :
-	    gvputs(job, "\\f");
-	    break;
-	case '\n' :
-	    gvputs(job, "\\n");
-	    break;
-	case '\r' :
-	    gvputs(job, "\\r");
-	    break;
-	case '\t' :
-	    gvputs(job, "\\t");
-	    break;
-	default :
-	    gvputc(job, c);
-	    break;
+    const size_t len = strlen(input);
+    size_t start = 0; // start of the characters not yet appended
+    size_t i = 0;
+    agxbputc(&sp->out, '"');
+    while (i < len) {
+	for (uint64_t w; i + sizeof(w) <= len; i += sizeof(w)) {
+	    memcpy(&w, input + i, sizeof(w));
+	    if (maybe_escaped(w))
+		break;
+	}
+	const size_t end = i + sizeof(uint64_t) < len ? i + sizeof(uint64_t) : len;
+	for (; i < end; i++) {
+	    const char *e = escapes[(unsigned char)input[i]];
+	    if (e != NULL) {
+		agxbput_n(&sp->out, input + start, i - start);
+		agxbput(&sp->out, e);
+		start = i + 1;
+	    }
 	}
     }
-    gvputc(job, '"');
+    agxbput_n(&sp->out, input + start, len - start);
+    agxbputc(&sp->out, '"');
 
     if (sp->isLatin)
 	free (input);
 }
 
-static void indent(GVJ_t * job, int level)
+static void indent(state_t *sp, int level)
 {
-    int i;
-    for (i = level; i > 0; i--)
-	gvputs(job, "  ");
+    static const char spaces[] = "                                        ";
+    size_t n = 2 * (size_t)(level > 0 ? level : 0);
+    while (n > 0) {
+	const size_t chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+	agxbput_n(&sp->out, spaces, chunk);
+	n -= chunk;
+    }
 }
 
 static void set_attrwf(Agraph_t * g, bool toplevel, bool value)
@@ -158,188 +248,226 @@ static void set_attrwf(Agraph_t * g, bool toplevel, bool value)
     }
 }
 
-static void write_polyline (GVJ_t * job, xdot_polyline* polyline)
+static void write_point(state_t *sp, double x, double y)
+{
+    agxbputc(&sp->out, '[');
+    put_num(sp, x);
+    agxbputc(&sp->out, ',');
+    put_num(sp, y);
+    agxbputc(&sp->out, ']');
+}
+
+static void write_polyline (state_t *sp, xdot_polyline* polyline)
 {
     const size_t cnt = polyline->cnt;
     xdot_point* pts = polyline->pts;
 
-    gvprintf(job, "\"points\": [");
+    put(sp, "\"points\": [");
     for (size_t i = 0; i < cnt; i++) {
-	if (i > 0) gvprintf(job, ",");
-	gvprintf(job, "[%.03f,%.03f]", pts[i].x, pts[i].y);
+	if (i > 0) agxbputc(&sp->out, ',');
+	write_point(sp, pts[i].x, pts[i].y);
     }
-    gvprintf(job, "]\n");
+    put(sp, "]\n");
 }
 
-static void write_stops (GVJ_t * job, int n_stops, xdot_color_stop* stp, state_t* sp)
+static void write_stops (state_t *sp, int n_stops, xdot_color_stop* stp)
 {
     int i;
 
-    gvprintf(job, "\"stops\": [");
+    put(sp, "\"stops\": [");
     for (i = 0; i < n_stops; i++) {
-	if (i > 0) gvprintf(job, ",");
-	gvprintf(job, "{\"frac\": %.03f, \"color\": ", stp[i].frac);
-	stoj(stp[i].color, sp, job);
-	gvputc(job, '}');
-    }
-    gvprintf(job, "]\n");
-} 
+	if (i > 0) agxbputc(&sp->out, ',');
+	put(sp, "{\"frac\": ");
+	put_num(sp, stp[i].frac);
+	put(sp, ", \"color\": ");
+	stoj(stp[i].color, sp);
+	agxbputc(&sp->out, '}');
+    }
+    put(sp, "]\n");
+}
+
+/// write `"name": [x,y(,r)],`
+static void write_grad_point(state_t *sp, const char *name, double x, double y,
+                             const double *r)
+{
+    indent(sp, sp->Level);
+    put(sp, name);
+    put(sp, ": [");
+    put_num(sp, x);
+    agxbputc(&sp->out, ',');
+    put_num(sp, y);
+    if (r != NULL) {
+	agxbputc(&sp->out, ',');
+	put_num(sp, *r);
+    }
+    put(sp, "],\n");
+}
+
+static void write_radial_grad (state_t *sp, xdot_radial_grad* rg)
+{
+    write_grad_point(sp, "\"p0\"", rg->x0, rg->y0, &rg->r0);
+    write_grad_point(sp, "\"p1\"", rg->x1, rg->y1, &rg->r1);
+    indent(sp, sp->Level);
+    write_stops (sp, rg->n_stops, rg->stops);
+}
 
-static void write_radial_grad (GVJ_t * job, xdot_radial_grad* rg, state_t* sp)
+static void write_linear_grad (state_t *sp, xdot_linear_grad* lg)
 {
-    indent(job, sp->Level);
-    gvprintf(job, "\"p0\": [%.03f,%.03f,%.03f],\n", rg->x0, rg->y0, rg->r0); 
-    indent(job, sp->Level);
-    gvprintf(job, "\"p1\": [%.03f,%.03f,%.03f],\n", rg->x1, rg->y1, rg->r1); 
-    indent(job, sp->Level);
-    write_stops (job, rg->n_stops, rg->stops, sp);
+    write_grad_point(sp, "\"p0\"", lg->x0, lg->y0, NULL);
+    write_grad_point(sp, "\"p1\"", lg->x1, lg->y1, NULL);
+    indent(sp, sp->Level);
+    write_stops (sp, lg->n_stops, lg->stops);
 }
 
-static void write_linear_grad (GVJ_t * job, xdot_linear_grad* lg, state_t* sp)
+/// write `"op": "<c>",` and indent the next line
+static void write_op(state_t *sp, char c)
 {
-    indent(job, sp->Level);
-    gvprintf(job, "\"p0\": [%.03f,%.03f],\n", lg->x0, lg->y0); 
-    indent(job, sp->Level);
-    gvprintf(job, "\"p1\": [%.03f,%.03f],\n", lg->x1, lg->y1); 
-    indent(job, sp->Level);
-    write_stops (job, lg->n_stops, lg->stops, sp);
+    put(sp, "\"op\": \"");
+    agxbputc(&sp->out, c);
+    put(sp, "\",\n");
+    indent(sp, sp->Level);
 }
 
-static void write_xdot (xdot_op * op, GVJ_t * job, state_t* sp)
+static void write_xdot (xdot_op * op, state_t* sp)
 {
-    indent(job, sp->Level++);
-    gvputs(job, "{\n");
-    indent(job, sp->Level);
+    indent(sp, sp->Level++);
+    put(sp, "{\n");
+    indent(sp, sp->Level);
 
     switch (op->kind) {
     case xd_filled_ellipse :
     case xd_unfilled_ellipse :
-	gvprintf(job, "\"op\": \"%c\",\n", op->kind == xd_filled_ellipse ? 'E' : 'e');
- 	indent(job, sp->Level);
-	gvprintf(job, "\"rect\": [%.03f,%.03f,%.03f,%.03f]\n", 
-	    op->u.ellipse.x, op->u.ellipse.y, op->u.ellipse.w, op->u.ellipse.h);
+	write_op(sp, op->kind == xd_filled_ellipse ? 'E' : 'e');
+	put(sp, "\"rect\": [");
+	put_num(sp, op->u.ellipse.x);
+	agxbputc(&sp->out, ',');
+	put_num(sp, op->u.ellipse.y);
+	agxbputc(&sp->out, ',');
+	put_num(sp, op->u.ellipse.w);
+	agxbputc(&sp->out, ',');
+	put_num(sp, op->u.ellipse.h);
+	put(sp, "]\n");
 	break;
     case xd_filled_polygon :
     case xd_unfilled_polygon :
-	gvprintf(job, "\"op\": \"%c\",\n", op->kind == xd_filled_polygon ? 'P' : 'p');
- 	indent(job, sp->Level);
-	write_polyline (job, &op->u.polygon);
+	write_op(sp, op->kind == xd_filled_polygon ? 'P' : 'p');
+	write_polyline (sp, &op->u.polygon);
 	break;
     case xd_filled_bezier :
     case xd_unfilled_bezier :
-	gvprintf(job, "\"op\": \"%c\",\n", op->kind == xd_filled_bezier ? 'B' : 'b');
- 	indent(job, sp->Level);
-	write_polyline (job, &op->u.bezier);
+	write_op(sp, op->kind == xd_filled_bezier ? 'B' : 'b');
+	write_polyline (sp, &op->u.bezier);
 	break;
     case xd_polyline :
-	gvprintf(job, "\"op\": \"L\",\n"); 
- 	indent(job, sp->Level);
-	write_polyline (job, &op->u.polyline);
+	write_op(sp, 'L');
+	write_polyline (sp, &op->u.polyline);
 	break;
     case xd_text :
-	gvprintf(job, "\"op\": \"T\",\n"); 
- 	indent(job, sp->Level);
-	gvprintf(job, "\"pt\": [%.03f,%.03f],\n", op->u.text.x, op->u.text.y); 
- 	indent(job, sp->Level);
-	gvprintf(job, "\"align\": \"%c\",\n",
-	    op->u.text.align == xd_left? 'l' :
-	    (op->u.text.align == xd_center ? 'c' : 'r'));
- 	indent(job, sp->Level);
-	gvprintf(job, "\"width\": %.03f,\n", op->u.text.width); 
- 	indent(job, sp->Level);
-	gvputs(job, "\"text\": ");
-	stoj(op->u.text.text, sp, job);
-	gvputc(job, '\n');
+	write_op(sp, 'T');
+	put(sp, "\"pt\": ");
+	write_point(sp, op->u.text.x, op->u.text.y);
+	put(sp, ",\n");
+ 	indent(sp, sp->Level);
+	put(sp, op->u.text.align == xd_left ? "\"align\": \"l\",\n" :
+	        op->u.text.align == xd_center ? "\"align\": \"c\",\n"
+	                                      : "\"align\": \"r\",\n");
+ 	indent(sp, sp->Level);
+	put(sp, "\"width\": ");
+	put_num(sp, op->u.text.width);
+	put(sp, ",\n");
+ 	indent(sp, sp->Level);
+	put(sp, "\"text\": ");
+	stoj(op->u.text.text, sp);
+	agxbputc(&sp->out, '\n');
 	break;
     case xd_fill_color :
     case xd_pen_color :
-	gvprintf(job, "\"op\": \"%c\",\n", op->kind == xd_fill_color ? 'C' : 'c');
- 	indent(job, sp->Level);
-	gvprintf(job, "\"grad\": \"none\",\n"); 
- 	indent(job, sp->Level);
-	gvputs(job, "\"color\": ");
-	stoj(op->u.color, sp, job);
-	gvputc(job, '\n');
+	write_op(sp, op->kind == xd_fill_color ? 'C' : 'c');
+	put(sp, "\"grad\": \"none\",\n");
+ 	indent(sp, sp->Level);
+	put(sp, "\"color\": ");
+	stoj(op->u.color, sp);
+	agxbputc(&sp->out, '\n');
 	break;
     case xd_grad_pen_color :
     case xd_grad_fill_color :
-	gvprintf(job, "\"op\": \"%c\",\n", op->kind == xd_grad_fill_color ? 'C' : 'c');
- 	indent(job, sp->Level);
+	write_op(sp, op->kind == xd_grad_fill_color ? 'C' : 'c');
 	if (op->u.grad_color.type == xd_none) {
-	    gvprintf(job, "\"grad\": \"none\",\n"); 
- 	    indent(job, sp->Level);
-	    gvputs(job, "\"color\": ");
-	    stoj(op->u.grad_color.u.clr, sp, job);
-	    gvputc(job, '\n');
+	    put(sp, "\"grad\": \"none\",\n");
+ 	    indent(sp, sp->Level);
+	    put(sp, "\"color\": ");
+	    stoj(op->u.grad_color.u.clr, sp);
+	    agxbputc(&sp->out, '\n');
 	}
 	else {
 	    if (op->u.grad_color.type == xd_linear) {
-		gvprintf(job, "\"grad\": \"linear\",\n"); 
-		indent(job, sp->Level);
-		write_linear_grad (job, &op->u.grad_color.u.ling, sp);
+		put(sp, "\"grad\": \"linear\",\n");
+		indent(sp, sp->Level);
+		write_linear_grad (sp, &op->u.grad_color.u.ling);
 	    }
 	    else {
-		gvprintf(job, "\"grad\": \"radial\",\n"); 
-		indent(job, sp->Level);
-		write_radial_grad (job, &op->u.grad_color.u.ring, sp);
+		put(sp, "\"grad\": \"radial\",\n");
+		indent(sp, sp->Level);
+		write_radial_grad (sp, &op->u.grad_color.u.ring);
 	    }
 	}
 	break;
     case xd_font :
-	gvprintf(job, "\"op\": \"F\",\n");
- 	indent(job, sp->Level);
-	gvprintf(job, "\"size\": %.03f,\n", op->u.font.size); 
- 	indent(job, sp->Level);
-	gvputs(job, "\"face\": ");
-	stoj(op->u.font.name, sp, job);
-	gvputc(job, '\n');
+	write_op(sp, 'F');
+	put(sp, "\"size\": ");
+	put_num(sp, op->u.font.size);
+	put(sp, ",\n");
+ 	indent(sp, sp->Level);
+	put(sp, "\"face\": ");
+	stoj(op->u.font.name, sp);
+	agxbputc(&sp->out, '\n');
 	break;
     case xd_style :
-	gvprintf(job, "\"op\": \"S\",\n");
- 	indent(job, sp->Level);
-	gvputs(job, "\"style\": ");
-	stoj(op->u.style, sp, job);
-	gvputc(job, '\n');
+	write_op(sp, 'S');
+	put(sp, "\"style\": ");
+	stoj(op->u.style, sp);
+	agxbputc(&sp->out, '\n');
 	break;
     case xd_image :
 	break;
     case xd_fontchar :
-	gvprintf(job, "\"op\": \"t\",\n");
- 	indent(job, sp->Level);
-	gvprintf(job, "\"fontchar\": %d\n", op->u.fontchar);
+	write_op(sp, 't');
+	put(sp, "\"fontchar\": ");
+	put_int(sp, (int)op->u.fontchar);
+	agxbputc(&sp->out, '\n');
 	break;
     default:
 	UNREACHABLE();
     }
     sp->Level--;
-    indent(job, sp->Level);
-    gvputs(job, "}");
+    indent(sp, sp->Level);
+    agxbputc(&sp->out, '}');
 }
 
-static void write_xdots (char * val, GVJ_t * job, state_t* sp)
+static void write_xdots (char * val, state_t* sp)
 {
     xdot* cmds;
 
     if (!val || *val == '\0') return;
 
-    cmds = parseXDot(val);
+    cmds = parseXDotArena(val, NULL, 0, NULL);
     if (!cmds) {
 	agerr(AGWARN, "Could not parse xdot \"%s\"\n", val);
 	return;
     }
 
-    gvputs(job, "\n");
-    indent(job, sp->Level++);
-    gvputs(job, "[\n");
+    agxbputc(&sp->out, '\n');
+    indent(sp, sp->Level++);
+    put(sp, "[\n");
     for (size_t i = 0; i < cmds->cnt; i++) {
 	if (i > 0)
-	    gvputs(job, ",\n");
-	write_xdot (cmds->ops+i, job, sp);
+	    put(sp, ",\n");
+	write_xdot (cmds->ops+i, sp);
     }
     sp->Level--;
-    gvputs(job, "\n");
-    indent(job, sp->Level);
-    gvputs(job, "]");
+    agxbputc(&sp->out, '\n');
+    indent(sp, sp->Level);
+    agxbputc(&sp->out, ']');
     freeXDot(cmds);
 }
 
@@ -349,7 +477,7 @@ static bool isXDot(const char* name) {
          streq(name, "_hldraw_") || streq(name, "_tldraw_");
 }
 
-static void write_attrs(Agobj_t * obj, GVJ_t * job, state_t* sp)
+static void write_attrs(Agobj_t * obj, state_t* sp)
 {
     Agraph_t* g = agroot(obj);
     int type = AGTYPE(obj);
@@ -360,31 +488,31 @@ static void write_attrs(Agobj_t * obj, GVJ_t * job, state_t* sp)
     for (; sym; sym = agnxtattr(g, type, sym)) {
 	if (!(attrval = agxget(obj, sym))) continue;
 	if (*attrval == '\0' && !streq(sym->name, "label")) continue;
-	gvputs(job, ",\n");
-	indent(job, sp->Level);
-	stoj(sym->name, sp, job);
-	gvputs(job, ": ");
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	stoj(sym->name, sp);
+	put(sp, ": ");
 	if (sp->doXDot && isXDot(sym->name))
-	    write_xdots(agxget(obj, sym), job, sp);
+	    write_xdots(attrval, sp);
 	else
-	    stoj(agxget(obj, sym), sp, job);
+	    stoj(attrval, sp);
     }
 }
 
-static void write_hdr(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
+static void write_hdr(Agraph_t *g, bool top, state_t *sp) {
     char *name;
 
     name = agnameof(g);
-    indent(job, sp->Level);
-    gvputs(job, "\"name\": ");
-    stoj(name, sp, job);
+    indent(sp, sp->Level);
+    put(sp, "\"name\": ");
+    stoj(name, sp);
 
     if (top) {
-	gvputs(job, ",\n");
-	indent(job, sp->Level);
-	gvprintf(job, "\"directed\": %s,\n", agisdirected(g)?"true":"false");
-	indent(job, sp->Level);
-	gvprintf(job, "\"strict\": %s", agisstrict(g)?"true":"false");
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, agisdirected(g) ? "\"directed\": true,\n" : "\"directed\": false,\n");
+	indent(sp, sp->Level);
+	put(sp, agisstrict(g) ? "\"strict\": true" : "\"strict\": false");
     }
 }
 
@@ -395,8 +523,9 @@ static void write_subg(Agraph_t * g, GVJ_t * job, state_t* sp)
     Agraph_t* sg;
 
     write_graph (g, job, false, sp);
+    flush(job, sp, false);
     for (sg = agfstsubg(g); sg; sg = agnxtsubg(sg)) {
-	gvputs(job, ",\n");
+	put(sp, ",\n");
 	write_subg(sg, job, sp);
     }
 }
@@ -409,29 +538,29 @@ static bool write_subgs(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
 
     sg = agfstsubg(g);
     if (!sg) return false;
-   
-    gvputs(job, ",\n");
-    indent(job, sp->Level++);
+
+    put(sp, ",\n");
+    indent(sp, sp->Level++);
     if (top)
-	gvputs(job, "\"objects\": [\n");
+	put(sp, "\"objects\": [\n");
     else {
-	gvputs(job, "\"subgraphs\": [\n");
-	indent(job, sp->Level);
+	put(sp, "\"subgraphs\": [\n");
+	indent(sp, sp->Level);
     }
     const char *separator = "";
     for (; sg; sg = agnxtsubg(sg)) {
-	gvputs(job, separator);
+	put(sp, separator);
         if (top)
 	    write_subg (sg, job, sp);
 	else
-	    gvprintf(job, "%d", GD_gid(sg));
+	    put_int(sp, GD_gid(sp, sg));
 	separator = ",\n";
     }
     if (!top) {
 	sp->Level--;
-	gvputs(job, "\n");
-	indent(job, sp->Level);
-	gvputs(job, "]");
+	agxbputc(&sp->out, '\n');
+	indent(sp, sp->Level);
+	agxbputc(&sp->out, ']');
     }
 
     return true;
@@ -464,93 +593,109 @@ static int agseqasc(const void *x, const void *y) {
     }
 }
 
-static void write_edge(Agedge_t *e, GVJ_t *job, bool top, state_t *sp) {
+static void write_edge(Agedge_t *e, bool top, state_t *sp) {
     if (top) {
-	indent(job, sp->Level++);
-	gvputs(job, "{\n");
-	indent(job, sp->Level);
-	gvprintf(job, "\"_gvid\": %d,\n", ED_gid(e));
-	indent(job, sp->Level);
-	gvprintf(job, "\"tail\": %d,\n", ND_gid(agtail(e)));
-	indent(job, sp->Level);
-	gvprintf(job, "\"head\": %d", ND_gid(aghead(e)));
-    	write_attrs((Agobj_t*)e, job, sp);
-	gvputs(job, "\n");
+	indent(sp, sp->Level++);
+	put(sp, "{\n");
+	indent(sp, sp->Level);
+	put(sp, "\"_gvid\": ");
+	put_int(sp, ED_gid(sp, e));
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, "\"tail\": ");
+	put_int(sp, ND_gid(sp, agtail(e)));
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, "\"head\": ");
+	put_int(sp, ND_gid(sp, aghead(e)));
+    	write_attrs((Agobj_t*)e, sp);
+	agxbputc(&sp->out, '\n');
 	sp->Level--;
-	indent(job, sp->Level);
-	gvputs(job, "}");
+	indent(sp, sp->Level);
+	agxbputc(&sp->out, '}');
     }
     else {
-	gvprintf(job, "%d", ED_gid(e));
+	put_int(sp, ED_gid(sp, e));
     }
 }
 
 static int write_edges(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
+    Agedge_t **edges;
     size_t count = 0;
 
-    for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
-        for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
-            ++count;
-        }
+    if (top) {
+	// the root graph's edges were put in order up front
+	edges = sp->edges;
+	count = sp->n_edges;
+    } else {
+	for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	    for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
+		++count;
+	    }
+	}
+	edges = gv_calloc(count, sizeof(Agedge_t *));
+	size_t i = 0;
+	for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	    for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
+		edges[i] = ep;
+		++i;
+	    }
+	}
+	qsort(edges, count, sizeof(Agedge_t *), agseqasc);
     }
 
     if (count == 0) {
+	if (!top)
+	    free(edges);
         return 0;
     }
 
-    Agedge_t **edges = gv_calloc(count, sizeof(Agedge_t *));
-
-    size_t i = 0;
-    for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
-        for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
-            edges[i] = ep;
-            ++i;
-        }
-    }
-
-    qsort(edges, count, sizeof(Agedge_t *), agseqasc);
-
-    gvputs(job, ",\n");
-    indent(job, sp->Level++);
-    gvputs(job, "\"edges\": [\n");
+    put(sp, ",\n");
+    indent(sp, sp->Level++);
+    put(sp, "\"edges\": [\n");
     if (!top)
-        indent(job, sp->Level);
+        indent(sp, sp->Level);
     for (size_t j = 0; j < count; ++j) {
         if (j > 0) {
             if (top)
-                gvputs(job, ",\n");
+                put(sp, ",\n");
             else
-                gvputs(job, ",");
+                agxbputc(&sp->out, ',');
         }
-        write_edge(edges[j], job, top, sp);
+        write_edge(edges[j], top, sp);
+        if (top)
+            flush(job, sp, false);
     }
 
-    free(edges);
+    if (!top)
+        free(edges);
 
     sp->Level--;
-    gvputs(job, "\n");
-    indent(job, sp->Level);
-    gvputs(job, "]");
+    agxbputc(&sp->out, '\n');
+    indent(sp, sp->Level);
+    agxbputc(&sp->out, ']');
     return 1;
 }
 
-static void write_node(Agnode_t *n, GVJ_t *job, bool top, state_t *sp) {
+static void write_node(Agnode_t *n, bool top, state_t *sp) {
     if (top) {
-	indent(job, sp->Level++);
-	gvputs(job, "{\n");
-	indent(job, sp->Level);
-	gvprintf(job, "\"_gvid\": %d,\n", ND_gid(n));
-	indent(job, sp->Level);
-	gvputs(job, "\"name\": ");
-	stoj(agnameof(n), sp, job);
-    	write_attrs((Agobj_t*)n, job, sp);
-	gvputs(job, "\n");
+	indent(sp, sp->Level++);
+	put(sp, "{\n");
+	indent(sp, sp->Level);
+	put(sp, "\"_gvid\": ");
+	put_int(sp, ND_gid(sp, n));
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, "\"name\": ");
+	stoj(agnameof(n), sp);
+    	write_attrs((Agobj_t*)n, sp);
+	agxbputc(&sp->out, '\n');
 	sp->Level--;
-	indent(job, sp->Level);
-	gvputs(job, "}");
+	indent(sp, sp->Level);
+	agxbputc(&sp->out, '}');
     }
     else {
-	gvprintf(job, "%d", ND_gid(n));
+	put_int(sp, ND_gid(sp, n));
     }
 }
 
@@ -568,35 +713,37 @@ static int write_nodes(Agraph_t *g, GVJ_t *job, bool top, bool has_subgs, state_
     if (only_clusters) {
 	if (has_subgs && top) {
 	    sp->Level--;
-	    gvputs(job, "\n");
-	    indent(job, sp->Level);
-	    gvputs(job, "]");
+	    agxbputc(&sp->out, '\n');
+	    indent(sp, sp->Level);
+	    agxbputc(&sp->out, ']');
 	}
 	return 0;
     }
-    gvputs(job, ",\n");
+    put(sp, ",\n");
     if (top) {
 	if (!has_subgs) {
-            indent(job, sp->Level++);
-            gvputs(job, "\"objects\": [\n");
+            indent(sp, sp->Level++);
+            put(sp, "\"objects\": [\n");
         }
     }
     else {
-        indent(job, sp->Level++);
-	gvputs(job, "\"nodes\": [\n");
-	indent(job, sp->Level);
+        indent(sp, sp->Level++);
+	put(sp, "\"nodes\": [\n");
+	indent(sp, sp->Level);
     }
     const char *separator = "";
     for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
 	if (IS_CLUST_NODE(n)) continue;
-	gvputs(job, separator);
-	write_node (n, job, top, sp);
+	put(sp, separator);
+	write_node (n, top, sp);
+	if (top)
+	    flush(job, sp, false);
 	separator = top ? ",\n" : ",";
     }
     sp->Level--;
-    gvputs(job, "\n");
-    indent(job, sp->Level);
-    gvputs(job, "]");
+    agxbputc(&sp->out, '\n');
+    indent(sp, sp->Level);
+    agxbputc(&sp->out, ']');
     return 1;
 }
 
@@ -627,7 +774,7 @@ static int lookup (Dt_t* map, char* name)
     if (ip) return ip->v;
     else return -1;
 }
- 
+
 static void insert (Dt_t* map, char* name, int v)
 {
     intm* ip = dtmatch(map, name);
@@ -643,73 +790,118 @@ static void insert (Dt_t* map, char* name, int v)
     dtinsert (map, ip);
 }
 
-static int label_subgs(Agraph_t* g, int lbl, Dt_t* map)
+/// largest `AGSEQ` of a graph and its subgraphs
+static uint64_t max_subg_seq(Agraph_t *g)
+{
+    uint64_t max = AGSEQ(g);
+    for (Agraph_t *sg = agfstsubg(g); sg; sg = agnxtsubg(sg)) {
+	const uint64_t m = max_subg_seq(sg);
+	if (m > max)
+	    max = m;
+    }
+    return max;
+}
+
+static int label_subgs(Agraph_t* g, int lbl, Dt_t* map, state_t *sp)
 {
     Agraph_t* sg;
 
     if (g != agroot(g)) {
-	GD_gid(g) = lbl++;
+	GD_gid(sp, g) = lbl++;
 	if (IS_CLUSTER(g))
-	    insert (map, agnameof(g), GD_gid(g)); 
+	    insert (map, agnameof(g), GD_gid(sp, g));
     }
     for (sg = agfstsubg(g); sg; sg = agnxtsubg(sg)) {
-	lbl = label_subgs(sg, lbl, map);
+	lbl = label_subgs(sg, lbl, map, sp);
     }
     return lbl;
 }
 
+/// number the objects of the root graph and put its edges in order
+///
+/// \return Number of subgraphs
+static int label_objects(Agraph_t *g, state_t *sp)
+{
+    uint64_t max_node = 0;
+    uint64_t max_edge = 0;
+    size_t n_edges = 0;
+    for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	if (AGSEQ(np) > max_node)
+	    max_node = AGSEQ(np);
+	for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
+	    if (AGSEQ(ep) > max_edge)
+		max_edge = AGSEQ(ep);
+	    ++n_edges;
+	}
+    }
+    sp->node_ids = gv_calloc(max_node + 1, sizeof(int));
+    sp->edge_ids = gv_calloc(max_edge + 1, sizeof(int));
+    sp->subg_ids = gv_calloc(max_subg_seq(g) + 1, sizeof(int));
 
-static void write_graph(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
-    Agnode_t* np; 
-    Agedge_t* ep; 
+    Dt_t *map = dtopen (&intDisc, Dtoset);
+    const int sgcnt = label_subgs(g, 0, map, sp);
+
+    // edges are written in AGSEQ order, which a table indexed by it gives
+    // without sorting
+    Agedge_t **by_seq = gv_calloc(max_edge + 1, sizeof(Agedge_t *));
     int ncnt = 0;
     int ecnt = 0;
-    int sgcnt = 0;
-    Dt_t* map;
-
-    if (top) {
-	map = dtopen (&intDisc, Dtoset);
-	aginit(g, AGNODE, ID, sizeof(gvid_t), false);
-	aginit(g, AGEDGE, ID, sizeof(gvid_t), false);
-	aginit(g, AGRAPH, ID, -((int)sizeof(gvid_t)), false);
-	sgcnt = label_subgs(g, sgcnt, map);
-	for (np = agfstnode(g); np; np = agnxtnode(g,np)) {
-	    if (IS_CLUST_NODE(np)) {
-		ND_gid(np) = lookup(map, agnameof(np));
-	    }
-	    else {
-		ND_gid(np) = sgcnt + ncnt++;
-	    }
-	    for (ep = agfstout(g, np); ep; ep = agnxtout(g,ep)) {
-		ED_gid(ep) = ecnt++;
-	    }
+    for (Agnode_t *np = agfstnode(g); np; np = agnxtnode(g, np)) {
+	if (IS_CLUST_NODE(np)) {
+	    ND_gid(sp, np) = lookup(map, agnameof(np));
 	}
-	dtclose(map);
+	else {
+	    ND_gid(sp, np) = sgcnt + ncnt++;
+	}
+	for (Agedge_t *ep = agfstout(g, np); ep; ep = agnxtout(g, ep)) {
+	    ED_gid(sp, ep) = ecnt++;
+	    by_seq[AGSEQ(ep)] = ep;
+	}
+    }
+    dtclose(map);
+
+    sp->edges = gv_calloc(n_edges, sizeof(Agedge_t *));
+    sp->n_edges = 0;
+    for (uint64_t i = 0; i <= max_edge; ++i) {
+	if (by_seq[i] != NULL)
+	    sp->edges[sp->n_edges++] = by_seq[i];
     }
+    free(by_seq);
+
+    return sgcnt;
+}
 
-    indent(job, sp->Level++);
-    gvputs(job, "{\n");
-    write_hdr(g, job, top, sp);
-    write_attrs((Agobj_t*)g, job, sp);
+static void write_graph(Agraph_t *g, GVJ_t *job, bool top, state_t *sp) {
+    int sgcnt = 0;
+
+    if (top)
+	sgcnt = label_objects(g, sp);
+
+    indent(sp, sp->Level++);
+    put(sp, "{\n");
+    write_hdr(g, top, sp);
+    write_attrs((Agobj_t*)g, sp);
     if (top) {
-	gvputs(job, ",\n");
-	indent(job, sp->Level);
-	gvprintf(job, "\"_subgraph_cnt\": %d", sgcnt);
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, "\"_subgraph_cnt\": ");
+	put_int(sp, sgcnt);
     } else {
-	gvputs(job, ",\n");
-	indent(job, sp->Level);
-	gvprintf(job, "\"_gvid\": %d", GD_gid(g));
+	put(sp, ",\n");
+	indent(sp, sp->Level);
+	put(sp, "\"_gvid\": ");
+	put_int(sp, GD_gid(sp, g));
     }
     bool has_subgs = write_subgs(g, job, top, sp);
     write_nodes (g, job, top, has_subgs, sp);
     write_edges (g, job, top, sp);
-    gvputs(job, "\n");
+    agxbputc(&sp->out, '\n');
     sp->Level--;
-    indent(job, sp->Level);
+    indent(sp, sp->Level);
     if (top)
-	gvputs(job, "}\n");
+	put(sp, "}\n");
     else
-	gvputs(job, "}");
+	agxbputc(&sp->out, '}');
 }
 
 typedef int (*putstrfn) (void *chan, const char *str);
@@ -718,7 +910,7 @@ typedef int (*flushfn) (void *chan);
 static void json_end_graph(GVJ_t *job)
 {
     graph_t *g = job->obj->u.g;
-    state_t sp;
+    state_t sp = {0};
     static Agiodisc_t io;
 
     if (io.afread == NULL) {
@@ -734,6 +926,13 @@ static void json_end_graph(GVJ_t *job)
     sp.isLatin = GD_charset(g) == CHAR_LATIN1;
     sp.doXDot = job->render.id == FORMAT_JSON || job->render.id == FORMAT_XDOT_JSON;
     write_graph(g, job, true, &sp);
+    flush(job, &sp, true);
+
+    agxbfree(&sp.out);
+    free(sp.node_ids);
+    free(sp.edge_ids);
+    free(sp.subg_ids);
+    free(sp.edges);
 }
 
 gvrender_engine_t json_engine = {
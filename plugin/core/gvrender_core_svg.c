@@ -26,12 +26,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stddef.h>
 
 #include <common/macros.h>
 #include <common/const.h>
 
 #include <gvc/gvplugin_render.h>
 #include <cgraph/agxbuf.h>
+#include <cgraph/alloc.h>
 #include <cgraph/unreachable.h>
 #include <common/utils.h>
 #include <gvc/gvplugin_device.h>
@@ -45,7 +47,9 @@
   #define EDGEALIGN 0
 #endif
 
-typedef enum { FORMAT_SVG, FORMAT_SVGZ, FORMAT_SVG_INLINE } format_type;
+typedef enum { FORMAT_SVG, FORMAT_SVGZ, FORMAT_SVG_INLINE, FORMAT_SVG_ZST,
+               FORMAT_SVG_COMPACT, FORMAT_SVGZ_COMPACT,
+               FORMAT_SVG_ZST_COMPACT } format_type;
 
 /* SVG dash array */
 static const char sdasharray[] = "5,2";
@@ -210,8 +214,409 @@ static void svg_grstyle(GVJ_t * job, int filled, int gid)
     gvputc(job, '"');
 }
 
+/* Compact output (-Tsvg:compact):
+ * Presentation attributes are replaced by a class per distinct set of CSS
+ * declarations, coordinates are written to 0.1 units with paths using
+ * relative commands, and arrowheads that recur are drawn by <use> of a
+ * shared definition when that is shorter. The style sheet and definitions
+ * are written at the end of the document, as they are only known then.
+ */
+static bool is_compact(const GVJ_t *job) {
+  return job->render.id == FORMAT_SVG_COMPACT ||
+         job->render.id == FORMAT_SVGZ_COMPACT ||
+         job->render.id == FORMAT_SVG_ZST_COMPACT;
+}
+
+/// a string interned for compact output
+typedef struct {
+    Dtlink_t link;
+    char *key;
+    int id;
+    bool used;    ///< has the arrowhead definition been written?
+} interned_t;
+
+static void interned_free(interned_t *obj, Dtdisc_t *disc) {
+    (void)disc;
+    free(obj->key);
+    free(obj);
+}
+
+static Dtdisc_t interned_disc = {
+    offsetof(interned_t, key),
+    -1,
+    offsetof(interned_t, link),
+    (Dtmake_f) NULL,
+    (Dtfree_f) interned_free,
+    (Dtcompar_f) NULL,
+};
+
+static struct {
+    Dt_t *styles;  ///< CSS declarations to class
+    int n_styles;
+    interned_t *last_style; ///< the style of the last element with a class
+    Dt_t *arrows;  ///< arrowhead path data, relative to its start, to definition
+    int n_arrows;
+    agxbuf css;    ///< rules of the classes
+    agxbuf defs;   ///< definitions of the arrowheads referenced
+    agxbuf decl;   ///< CSS declarations of the current element
+    agxbuf path;   ///< relative path data of the current element
+} compact;
+
+static void compact_begin(void)
+{
+    compact.styles = dtopen(&interned_disc, Dtoset);
+    compact.arrows = dtopen(&interned_disc, Dtoset);
+    compact.n_styles = 0;
+    compact.last_style = NULL;
+    compact.n_arrows = 0;
+}
+
+static void compact_end(GVJ_t *job)
+{
+    if (agxblen(&compact.css) > 0 || agxblen(&compact.defs) > 0) {
+	gvputs(job, "<defs>\n");
+	if (agxblen(&compact.css) > 0) {
+	    gvputs(job, "<style type=\"text/css\">\n");
+	    // only the characters XML requires are escaped, CSS needs the rest
+	    for (const char *c = agxbuse(&compact.css); *c != '\0'; ++c) {
+		if (*c == '&')
+		    gvputs(job, "&amp;");
+		else if (*c == '<')
+		    gvputs(job, "&lt;");
+		else
+		    gvputc(job, *c);
+	    }
+	    gvputs(job, "</style>\n");
+	}
+	gvputs(job, agxbuse(&compact.defs));
+	gvputs(job, "</defs>\n");
+    }
+    dtclose(compact.styles);
+    dtclose(compact.arrows);
+    agxbfree(&compact.css);
+    agxbfree(&compact.defs);
+    agxbfree(&compact.decl);
+    agxbfree(&compact.path);
+}
+
+/// find or add an interned string
+static interned_t *intern(Dt_t *dict, int *count, const char *key,
+                          bool *added)
+{
+    interned_t *it = dtmatch(dict, key);
+    *added = it == NULL;
+    if (it == NULL) {
+	it = gv_alloc(sizeof(interned_t));
+	it->key = gv_strdup(key);
+	it->id = (*count)++;
+	dtinsert(dict, it);
+    }
+    return it;
+}
+
+/// write the class of the declarations collected in `compact.decl`
+static void compact_class(GVJ_t *job)
+{
+    if (agxblen(&compact.decl) == 0)
+	return;
+    agxbpop(&compact.decl); // trailing ';'
+    const char *decl = agxbuse(&compact.decl);
+    // neighboring elements often look alike
+    interned_t *style = compact.last_style;
+    if (style == NULL || strcmp(style->key, decl) != 0) {
+	bool added;
+	style = intern(compact.styles, &compact.n_styles, decl, &added);
+	if (added)
+	    agxbprint(&compact.css, ".s%d{%s}\n", style->id, style->key);
+	compact.last_style = style;
+    }
+    gvprintf(job, " class=\"s%d\"", style->id);
+}
+
+/// a coordinate in tenths of a unit
+static long long tenths(double v)
+{
+    return llround(v * 10);
+}
+
+/// append a number given in tenths as briefly as SVG allows, preceded by a
+/// space if `sep` unless a minus sign separates it anyway
+static void put_tenths(agxbuf *xb, long long v, bool sep)
+{
+    if (v < 0) {
+	agxbputc(xb, '-');
+	v = -v;
+    } else if (sep) {
+	agxbputc(xb, ' ');
+    }
+    char buf[24];
+    char *p = buf + sizeof(buf);
+    if (v % 10 != 0) {
+	*--p = (char)('0' + v % 10);
+	*--p = '.';
+    }
+    // the integer part, omitted if it is a zero before a fraction
+    for (long long whole = v / 10; whole != 0 || p == buf + sizeof(buf);
+         whole /= 10)
+	*--p = (char)('0' + whole % 10);
+    agxbput_n(xb, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+static void write_tenths(GVJ_t *job, long long v)
+{
+    agxbuf xb = {0};
+    put_tenths(&xb, v, false);
+    gvputs(job, agxbuse(&xb));
+    agxbfree(&xb);
+}
+
+/// append the path data after the initial moveto of a shape
+///
+/// \param x, y Coordinates of the points in tenths, y pointing down
+/// \param curve Are the points those of a B-spline?
+/// \param closed Is the shape a polygon?
+static void compact_path(agxbuf *xb, const long long *x, const long long *y,
+                         size_t n, bool curve, bool closed)
+{
+    char last = 'M';
+    if (curve) {
+	for (size_t i = 1; i + 2 < n; i += 3) {
+	    bool sep = last == 'c';
+	    if (!sep)
+		agxbputc(xb, 'c');
+	    last = 'c';
+	    for (size_t j = i; j < i + 3; ++j) {
+		put_tenths(xb, x[j] - x[i - 1], sep);
+		put_tenths(xb, y[j] - y[i - 1], true);
+		sep = true;
+	    }
+	}
+    } else {
+	for (size_t i = 1; i < n; ++i) {
+	    const long long dx = x[i] - x[i - 1];
+	    const long long dy = y[i] - y[i - 1];
+	    const char cmd = dy == 0 ? 'h' : dx == 0 ? 'v' : 'l';
+	    const bool sep = cmd == last;
+	    if (!sep)
+		agxbputc(xb, cmd);
+	    last = cmd;
+	    if (cmd == 'v') {
+		put_tenths(xb, dy, sep);
+	    } else {
+		put_tenths(xb, dx, sep);
+		if (cmd == 'l')
+		    put_tenths(xb, dy, true);
+	    }
+	}
+    }
+    if (closed)
+	agxbputc(xb, 'z');
+}
+
+/// append a number as `gvprintdouble` would write it
+static void put_double(agxbuf *xb, double v)
+{
+    agxbuf num = {0};
+    agxbprint(&num, "%.02f", v);
+    agxbuf_trim_zeros(&num);
+    agxbput(xb, agxbuse(&num));
+    agxbfree(&num);
+}
+
+static void compact_paint(agxbuf *xb, gvcolor_t color)
+{
+    switch (color.type) {
+    case COLOR_STRING:
+	agxbput(xb, strcmp(color.u.string, transparent) ? color.u.string : none);
+	break;
+    case RGBA_BYTE:
+	if (color.u.rgba[3] == 0)	/* transparent */
+	    agxbput(xb, none);
+	else
+	    agxbprint(xb, "#%02x%02x%02x",
+		      color.u.rgba[0], color.u.rgba[1], color.u.rgba[2]);
+	break;
+    default:
+	UNREACHABLE(); // internal error
+    }
+}
+
+/// compact analogue of `svg_grstyle`
+static void compact_grstyle(GVJ_t *job, int filled, int gid)
+{
+    obj_state_t *obj = job->obj;
+    agxbuf *decl = &compact.decl;
+
+    agxbclear(decl);
+    if (filled == GRADIENT || filled == RGRADIENT) {
+	gvputs(job, " fill=\"url(#");
+	if (obj->id != NULL) {
+	    gvputs_xml(job, obj->id);
+	    gvputc(job, '_');
+	}
+	gvprintf(job, "%c_%d)\"", filled == GRADIENT ? 'l' : 'r', gid);
+    } else if (filled) {
+	agxbput(decl, "fill:");
+	compact_paint(decl, obj->fillcolor);
+	agxbputc(decl, ';');
+	if (obj->fillcolor.type == RGBA_BYTE
+	    && obj->fillcolor.u.rgba[3] > 0
+	    && obj->fillcolor.u.rgba[3] < 255)
+	    agxbprint(decl, "fill-opacity:%f;",
+		      (float)obj->fillcolor.u.rgba[3] / 255.0);
+    } else {
+	agxbput(decl, "fill:none;");
+    }
+    agxbput(decl, "stroke:");
+    compact_paint(decl, obj->pencolor);
+    agxbputc(decl, ';');
+    const double GVPRINT_DOUBLE_THRESHOLD = 0.005;
+    if (!(fabs(obj->penwidth - PENWIDTH_NORMAL) < GVPRINT_DOUBLE_THRESHOLD)) {
+	agxbput(decl, "stroke-width:");
+	put_double(decl, obj->penwidth);
+	agxbput(decl, "px;");
+    }
+    if (obj->pen == PEN_DASHED) {
+	agxbprint(decl, "stroke-dasharray:%s;", sdasharray);
+    } else if (obj->pen == PEN_DOTTED) {
+	agxbprint(decl, "stroke-dasharray:%s;", sdotarray);
+    }
+    if (obj->pencolor.type == RGBA_BYTE && obj->pencolor.u.rgba[3] > 0
+	&& obj->pencolor.u.rgba[3] < 255)
+	agxbprint(decl, "stroke-opacity:%f;",
+		  (float)obj->pencolor.u.rgba[3] / 255.0);
+    compact_class(job);
+}
+
+/** find the shared definition of an arrowhead
+ *
+ * Arrowheads are matched by their shape relative to their first point, so
+ * the same arrowhead at another place shares the definition.
+ *
+ * \return The definition, or NULL if this is the first such arrowhead
+ */
+static interned_t *compact_arrow(const pointf *A, size_t n, bool curve,
+                                 bool closed)
+{
+    long long *x = gv_calloc(n, sizeof(long long));
+    long long *y = gv_calloc(n, sizeof(long long));
+    for (size_t i = 0; i < n; ++i) {
+	x[i] = tenths(A[i].x - A[0].x);
+	y[i] = tenths(A[0].y - A[i].y);
+    }
+    agxbuf key = {0};
+    agxbput(&key, "M0 0");
+    compact_path(&key, x, y, n, curve, closed);
+    free(x);
+    free(y);
+
+    bool added;
+    interned_t *arrow = intern(compact.arrows, &compact.n_arrows,
+                               agxbuse(&key), &added);
+    agxbfree(&key);
+    // the first such arrowhead is drawn in place
+    return added ? NULL : arrow;
+}
+
+/** draw an arrowhead by reference to a shared definition, if that is shorter
+ *
+ * \param x, y The first point, in tenths
+ * \param length Length of the path data of the arrowhead
+ * \return True if the arrowhead was drawn
+ */
+static bool compact_use(GVJ_t *job, const pointf *A, size_t n, int filled,
+                        bool curve, bool closed, long long x, long long y,
+                        size_t length)
+{
+    interned_t *arrow = compact_arrow(A, n, curve, closed);
+    if (arrow == NULL)
+	return false;
+
+    agxbuf use = {0};
+    agxbprint(&use, "<use xlink:href=\"#a%d\"", arrow->id);
+    const size_t class_at = agxblen(&use);
+    agxbput(&use, " x=\"");
+    put_tenths(&use, x, false);
+    agxbput(&use, "\" y=\"");
+    put_tenths(&use, y, false);
+    agxbput(&use, "\"/>\n");
+    const bool shorter = agxblen(&use) < strlen("<path d=\"\"/>\n") + length;
+    if (shorter) {
+	if (!arrow->used) {
+	    agxbprint(&compact.defs, "<path id=\"a%d\" d=\"%s\"/>\n",
+	              arrow->id, arrow->key);
+	    arrow->used = true;
+	}
+	const char *s = agxbuse(&use);
+	gvwrite(job, s, class_at);
+	compact_grstyle(job, filled, 0);
+	gvputs(job, s + class_at);
+    }
+    agxbfree(&use);
+    return shorter;
+}
+
+/// write a polygon, B-spline or polyline as a path of compact output
+static void compact_shape(GVJ_t *job, pointf *A, size_t n, int filled,
+                          int gid, bool curve, bool closed)
+{
+    obj_state_t *obj = job->obj;
+
+    if (n == 0)
+	return;
+    long long *x = gv_calloc(n, sizeof(long long));
+    long long *y = gv_calloc(n, sizeof(long long));
+    for (size_t i = 0; i < n; ++i) {
+	x[i] = tenths(A[i].x);
+	y[i] = tenths(-A[i].y);
+    }
+    agxbuf start = {0}; // the first point
+    put_tenths(&start, x[0], false);
+    put_tenths(&start, y[0], true);
+    const char *first = agxbuse(&start);
+    agxbclear(&compact.path);
+    compact_path(&compact.path, x, y, n, curve, closed);
+    const char *data = agxbuse(&compact.path);
+
+    const bool arrowhead = obj->emit_state == EMIT_HDRAW
+                           || obj->emit_state == EMIT_TDRAW;
+    if (!arrowhead || n < 2 || filled == GRADIENT || filled == RGRADIENT
+	|| obj->labeledgealigned
+	|| !compact_use(job, A, n, filled, curve, closed, x[0], y[0],
+	                strlen("M") + strlen(first) + strlen(data))) {
+	gvputs(job, "<path");
+	if (obj->labeledgealigned) {
+	    gvputs(job, " id=\"");
+	    gvputs_xml(job, obj->id);
+	    gvputs(job, "_p\"");
+	}
+	compact_grstyle(job, filled, gid);
+	gvputs(job, " d=\"M");
+	gvputs(job, first);
+	gvputs(job, data);
+	gvputs(job, "\"/>\n");
+    }
+    free(x);
+    free(y);
+    agxbfree(&start);
+}
+
+/// write the text of a title
+static void svg_put_title(GVJ_t *job, const char *s)
+{
+    if (is_compact(job)) {
+	// '-' needs escaping only in comments
+	const xml_flags_t flags = {.nbsp = 1};
+	xml_escape(s, flags, (int(*)(void*, const char*))gvputs, job);
+    } else {
+	gvputs_xml(job, s);
+    }
+}
+
 static void svg_comment(GVJ_t * job, char *str)
 {
+    if (is_compact(job))
+	return;
     gvputs(job, "<!-- ");
     gvputs_xml(job, str);
     gvputs(job, " -->\n");
@@ -272,10 +677,14 @@ static void svg_begin_graph(GVJ_t * job)
 	    " xmlns:xlink=\"http://www.w3.org/1999/xlink\"");
     }
     gvputs(job, ">\n");
+    if (is_compact(job))
+	compact_begin();
 }
 
 static void svg_end_graph(GVJ_t * job)
 {
+    if (is_compact(job))
+	compact_end(job);
     gvputs(job, "</svg>\n");
 }
 
@@ -335,7 +744,7 @@ static void svg_begin_cluster(GVJ_t * job)
     svg_print_id_class(job, obj->id, NULL, "cluster", obj->u.sg);
     gvputs(job, ">\n"
                 "<title>");
-    gvputs_xml(job, agnameof(obj->u.g));
+    svg_put_title(job, agnameof(obj->u.g));
     gvputs(job, "</title>\n");
 }
 
@@ -356,7 +765,7 @@ static void svg_begin_node(GVJ_t * job)
     svg_print_id_class(job, obj->id, idx, "node", obj->u.n);
     gvputs(job, ">\n"
                 "<title>");
-    gvputs_xml(job, agnameof(obj->u.n));
+    svg_put_title(job, agnameof(obj->u.n));
     gvputs(job, "</title>\n");
 }
 
@@ -375,7 +784,7 @@ static void svg_begin_edge(GVJ_t * job)
 
                 "<title>");
     ename = strdup_and_subst_obj("\\E", obj->u.e);
-    gvputs_xml(job, ename);
+    svg_put_title(job, ename);
     free(ename);
     gvputs(job, "</title>\n");
 }
@@ -424,6 +833,135 @@ static void svg_end_anchor(GVJ_t * job)
                 "</g>\n");
 }
 
+/// the names of a font as the graph's `fontnames` attribute asks
+static void svg_font_names(GVJ_t *job, PostscriptAlias *pA, char **family,
+                           char **weight, char **style)
+{
+    switch (GD_fontnames(job->gvc->g)) {
+    case PSFONTS:
+	*family = pA->name;
+	*weight = pA->weight;
+	*style = pA->style;
+	break;
+    case SVGFONTS:
+	*family = pA->svg_font_family;
+	*weight = pA->svg_font_weight;
+	*style = pA->svg_font_style;
+	break;
+    default:
+    case NATIVEFONTS:
+	*family = pA->family;
+	*weight = pA->weight;
+	*style = pA->style;
+	break;
+    }
+}
+
+/// compact analogue of `svg_textspan`
+static void compact_textspan(GVJ_t *job, pointf p, textspan_t *span)
+{
+    obj_state_t *obj = job->obj;
+    agxbuf *decl = &compact.decl;
+    char *weight = NULL, *style = NULL;
+
+    agxbclear(decl);
+    switch (span->just) {
+    case 'l':
+	agxbput(decl, "text-anchor:start;");
+	break;
+    case 'r':
+	agxbput(decl, "text-anchor:end;");
+	break;
+    default:
+    case 'n':
+	agxbput(decl, "text-anchor:middle;");
+	break;
+    }
+    PostscriptAlias *pA = span->font->postscript_alias;
+    if (pA) {
+	char *family = NULL;
+	svg_font_names(job, pA, &family, &weight, &style);
+	agxbprint(decl, "font-family:%s", family);
+	if (pA->svg_font_family)
+	    agxbprint(decl, ",%s", pA->svg_font_family);
+	agxbputc(decl, ';');
+	if (weight)
+	    agxbprint(decl, "font-weight:%s;", weight);
+	if (pA->stretch)
+	    agxbprint(decl, "font-stretch:%s;", pA->stretch);
+	if (style)
+	    agxbprint(decl, "font-style:%s;", style);
+    } else
+	agxbprint(decl, "font-family:%s;", span->font->name);
+    const unsigned flags = span->font->flags;
+    if ((flags & HTML_BF) && !weight)
+	agxbput(decl, "font-weight:bold;");
+    if ((flags & HTML_IF) && !style)
+	agxbput(decl, "font-style:italic;");
+    if (flags & (HTML_UL|HTML_S|HTML_OL)) {
+	const char *sep = "";
+	agxbput(decl, "text-decoration:");
+	if (flags & HTML_UL) {
+	    agxbput(decl, "underline");
+	    sep = ",";
+	}
+	if (flags & HTML_OL) {
+	    agxbprint(decl, "%soverline", sep);
+	    sep = ",";
+	}
+	if (flags & HTML_S)
+	    agxbprint(decl, "%sline-through", sep);
+	agxbputc(decl, ';');
+    }
+    if (flags & HTML_SUP)
+	agxbput(decl, "baseline-shift:super;");
+    if (flags & HTML_SUB)
+	agxbput(decl, "baseline-shift:sub;");
+    agxbput(decl, "font-size:");
+    put_double(decl, span->font->size);
+    agxbput(decl, "px;");
+    switch (obj->pencolor.type) {
+    case COLOR_STRING:
+	if (strcasecmp(obj->pencolor.u.string, "black"))
+	    agxbprint(decl, "fill:%s;", obj->pencolor.u.string);
+	break;
+    case RGBA_BYTE:
+	agxbprint(decl, "fill:#%02x%02x%02x;",
+		  obj->pencolor.u.rgba[0], obj->pencolor.u.rgba[1],
+		  obj->pencolor.u.rgba[2]);
+	if (obj->pencolor.u.rgba[3] < 255)
+	    agxbprint(decl, "fill-opacity:%f;",
+		      (float)obj->pencolor.u.rgba[3] / 255.0);
+	break;
+    default:
+	UNREACHABLE(); // internal error
+    }
+
+    gvputs(job, "<text");
+    compact_class(job);
+    p.y += span->yoffset_centerline;
+    if (!obj->labeledgealigned) {
+	gvputs(job, " x=\"");
+	write_tenths(job, tenths(p.x));
+	gvputs(job, "\" y=\"");
+	write_tenths(job, tenths(-p.y));
+	gvputc(job, '"');
+    }
+    gvputc(job, '>');
+    if (obj->labeledgealigned) {
+	gvputs(job, "<textPath xlink:href=\"#");
+	gvputs_xml(job, obj->id);
+	gvputs(job, "_p\" startOffset=\"50%\"><tspan x=\"0\" dy=\"");
+	write_tenths(job, tenths(-p.y));
+	gvputs(job, "\">");
+    }
+    const xml_flags_t xml_flags = {.raw = 1, .dash = 1, .nbsp = 1};
+    xml_escape(span->str, xml_flags, (int(*)(void*, const char*))gvputs, job);
+    if (obj->labeledgealigned)
+	gvputs(job, "</tspan></textPath>");
+    gvputs(job, "</text>\n");
+}
+
 static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
 {
     obj_state_t *obj = job->obj;
@@ -431,6 +969,10 @@ static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
     char *family = NULL, *weight = NULL, *stretch = NULL, *style = NULL;
     unsigned int flags;
 
+    if (is_compact(job)) {
+	compact_textspan(job, p, span);
+	return;
+    }
     gvputs(job, "<text");
     switch (span->just) {
     case 'l':
@@ -454,24 +996,7 @@ static void svg_textspan(GVJ_t * job, pointf p, textspan_t * span)
     }
     pA = span->font->postscript_alias;
     if (pA) {
-	switch (GD_fontnames(job->gvc->g)) {
-	case PSFONTS:
-	    family = pA->name;
-	    weight = pA->weight;
-	    style = pA->style;
-	    break;
-	case SVGFONTS:
-	    family = pA->svg_font_family;
-	    weight = pA->svg_font_weight;
-	    style = pA->svg_font_style;
-	    break;
-	default:
-	case NATIVEFONTS:
-	    family = pA->family;
-	    weight = pA->weight;
-	    style = pA->style;
-	    break;
-	}
+	svg_font_names(job, pA, &family, &weight, &style);
 	stretch = pA->stretch;
 
 	gvprintf(job, " font-family=\"%s", family);
@@ -642,6 +1167,24 @@ static void svg_ellipse(GVJ_t * job, pointf * A, int filled)
     } else if (filled == RGRADIENT) {
 	gid = svg_rgradstyle(job);
     }
+    if (is_compact(job)) {
+	const long long rx = tenths(A[1].x - A[0].x);
+	const long long ry = tenths(A[1].y - A[0].y);
+	gvputs(job, rx == ry ? "<circle" : "<ellipse");
+	compact_grstyle(job, filled, gid);
+	gvputs(job, " cx=\"");
+	write_tenths(job, tenths(A[0].x));
+	gvputs(job, "\" cy=\"");
+	write_tenths(job, tenths(-A[0].y));
+	gvputs(job, rx == ry ? "\" r=\"" : "\" rx=\"");
+	write_tenths(job, rx);
+	if (rx != ry) {
+	    gvputs(job, "\" ry=\"");
+	    write_tenths(job, ry);
+	}
+	gvputs(job, "\"/>\n");
+	return;
+    }
     gvputs(job, "<ellipse");
     svg_grstyle(job, filled, gid);
     gvputs(job, " cx=\"");
@@ -664,6 +1207,10 @@ static void svg_bezier(GVJ_t *job, pointf *A, size_t n, int filled) {
     } else if (filled == RGRADIENT) {
 	gid = svg_rgradstyle(job);
     }
+    if (is_compact(job)) {
+	compact_shape(job, A, n, filled, gid, true, false);
+	return;
+    }
     gvputs(job, "<path");
     if (obj->labeledgealigned) {
 	gvputs(job, " id=\"");
@@ -683,6 +1230,10 @@ static void svg_polygon(GVJ_t *job, pointf *A, size_t n, int filled) {
     } else if (filled == RGRADIENT) {
 	gid = svg_rgradstyle(job);
     }
+    if (is_compact(job)) {
+	compact_shape(job, A, n, filled, gid, false, true);
+	return;
+    }
     gvputs(job, "<polygon");
     svg_grstyle(job, filled, gid);
     gvputs(job, " points=\"");
@@ -700,6 +1251,10 @@ static void svg_polygon(GVJ_t *job, pointf *A, size_t n, int filled) {
 }
 
 static void svg_polyline(GVJ_t *job, pointf *A, size_t n) {
+    if (is_compact(job)) {
+	compact_shape(job, A, n, 0, 0, false, false);
+	return;
+    }
     gvputs(job, "<polyline");
     svg_grstyle(job, 0, 0);
     gvputs(job, " points=\"");
@@ -814,9 +1369,17 @@ gvdevice_features_t device_features_svgz = {
     {72., 72.},			/* default dpi */
 };
 
+gvdevice_features_t device_features_svg_zst = {
+    GVDEVICE_DOES_TRUECOLOR|GVDEVICE_DOES_LAYERS|GVDEVICE_BINARY_FORMAT|GVDEVICE_ZSTD_FORMAT, /* flags */
+    {0., 0.},			/* default margin - points */
+    {0., 0.},			/* default page width, height - points */
+    {72., 72.},			/* default dpi */
+};
+
 gvplugin_installed_t gvrender_svg_types[] = {
     {FORMAT_SVG, "svg", 1, &svg_engine, &render_features_svg},
     {FORMAT_SVG_INLINE, "svg_inline", 1, &svg_engine, &render_features_svg},
+    {FORMAT_SVG_COMPACT, "compact", 1, &svg_engine, &render_features_svg},
     {0, NULL, 0, NULL, NULL}
 };
 
@@ -824,7 +1387,17 @@ gvplugin_installed_t gvdevice_svg_types[] = {
     {FORMAT_SVG, "svg:svg", 1, NULL, &device_features_svg},
 #ifdef HAVE_LIBZ
     {FORMAT_SVGZ, "svgz:svg", 1, NULL, &device_features_svgz},
+#endif
+#ifdef HAVE_ZSTD
+    {FORMAT_SVG_ZST, "svg.zst:svg", 1, NULL, &device_features_svg_zst},
 #endif
     {FORMAT_SVG_INLINE, "svg_inline:svg", 1, NULL, &device_features_svg},
+    {FORMAT_SVG_COMPACT, "svg:compact", 0, NULL, &device_features_svg},
+#ifdef HAVE_LIBZ
+    {FORMAT_SVGZ_COMPACT, "svgz:compact", 0, NULL, &device_features_svgz},
+#endif
+#ifdef HAVE_ZSTD
+    {FORMAT_SVG_ZST_COMPACT, "svg.zst:compact", 0, NULL, &device_features_svg_zst},
+#endif
     {0, NULL, 0, NULL, NULL}
 };
@@ -1 +1,9 @@
+#pragma once
+
+#include <common/textspan.h>
+#include <stdbool.h>
+
 #define FONT_DPI 96.
+
+/// measure a span and attach a `PangoLayout` for it
+bool pango_textlayout(textspan_t *span, char **fontpath);
@@ -314,12 +314,26 @@ static void cairogen_textspan(GVJ_t * job, pointf p, textspan_t * span)
     }
     p.y += span->yoffset_centerline + span->yoffset_layout;
 
+    /* spans measured from the text cache carry no layout, so make one */
+    PangoLayout *layout = span->layout;
+    textspan_t tmp = {0};
+    if (!layout) {
+	tmp.str = span->str;
+	tmp.font = span->font;
+	if (pango_textlayout(&tmp, NULL))
+	    layout = tmp.layout;
+    }
+
     cairo_move_to (cr, p.x, -p.y);
     cairo_save(cr);
     cairo_scale(cr, POINTS_PER_INCH / FONT_DPI, POINTS_PER_INCH / FONT_DPI);
-    pango_cairo_show_layout(cr, (PangoLayout*)span->layout);
+    if (layout)
+	pango_cairo_show_layout(cr, layout);
     cairo_restore(cr);
 
+    if (tmp.layout)
+	tmp.free_layout(tmp.layout);
+
     if (span->font && (span->font->flags & HTML_OL)) {
 	A[0].x = p.x;
 	A[1].x = p.x + span->size.x;
@@ -23,6 +23,7 @@
 
 #include <pango/pangocairo.h>
 #include "gvgetfontlist.h"
+#include "gvplugin_pango.h"
 #ifdef HAVE_PANGO_FC_FONT_LOCK_FACE
 #include <pango/pangofc-font.h>
 #endif
@@ -52,8 +53,6 @@ static char* pango_psfontResolve (PostscriptAlias* pa)
     return buf;
 }
 
-#define FONT_DPI 96.
-
 #define ENABLE_PANGO_MARKUP
 
 // wrapper to handle difference in calling conventions between `agxbput` and
@@ -64,7 +63,7 @@ static int agxbput_int(void *buffer, const char *s) {
   return (int)len;
 }
 
-static bool pango_textlayout(textspan_t * span, char **fontpath)
+bool pango_textlayout(textspan_t * span, char **fontpath)
 {
     static char buf[1024];  /* returned in fontpath, only good until next call */
     static PangoFontMap *fontmap;
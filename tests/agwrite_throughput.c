@@ -0,0 +1,49 @@
+/// \file
+/// \brief benchmark driver for `agwrite`
+///
+/// Reads a DOT graph from stdin, writes it out repeatedly and reports the
+/// throughput. The first argument gives the number of repetitions.
+///
+/// See test_misc.py:test_agwrite_throughput
+
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int main(int argc, char **argv) {
+  const int count = argc > 1 ? atoi(argv[1]) : 10;
+
+  Agraph_t *g = agread(stdin, NULL);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read input graph\n");
+    return EXIT_FAILURE;
+  }
+
+  FILE *out = tmpfile();
+  if (out == NULL) {
+    fprintf(stderr, "failed to create temporary file\n");
+    return EXIT_FAILURE;
+  }
+
+  long size = 0;
+  const clock_t start = clock();
+  for (int i = 0; i < count; ++i) {
+    rewind(out);
+    if (agwrite(g, out) != 0) {
+      fprintf(stderr, "agwrite failed\n");
+      return EXIT_FAILURE;
+    }
+    size = ftell(out);
+  }
+  const double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  printf("%d writes of %ld bytes in %.3fs", count, size, elapsed);
+  if (elapsed > 0)
+    printf(", %.1f MB/s", (double)size * count / elapsed / 1e6);
+  printf("\n");
+
+  fclose(out);
+  agclose(g);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/// \file
+/// \brief benchmark driver for circo on large biconnected graphs
+///
+/// Builds a ring with random chords, which is a single biconnected block, and
+/// lays it out with circo repeatedly. Most of the time goes into the crossing
+/// reduction of that block. Every layout is checked to place the nodes the same
+/// as the first, and the best time is reported. The arguments give the number
+/// of nodes, the number of chords and the number of repetitions.
+///
+/// See test_misc.py:test_circo_block_throughput
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <graphviz/gvc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/// a deterministic pseudo-random number generator
+static uint64_t next(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// a ring of `n` nodes with `chords` random chords across it
+static Agraph_t *make_graph(int n, int chords) {
+  Agraph_t *g = agopen("G", Agundirected, NULL);
+  Agnode_t **nodes = calloc((size_t)n, sizeof(nodes[0]));
+  if (nodes == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < n; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "%d", i);
+    nodes[i] = agnode(g, name, 1);
+  }
+  for (int i = 0; i < n; ++i) {
+    agedge(g, nodes[i], nodes[(i + 1) % n], NULL, 1);
+  }
+  uint64_t state = 42;
+  for (int i = 0; i < chords; ++i) {
+    const int a = (int)(next(&state) % (uint64_t)n);
+    const int b = (int)(next(&state) % (uint64_t)n);
+    if (a != b) {
+      agedge(g, nodes[a], nodes[b], NULL, 1);
+    }
+  }
+  free(nodes);
+  return g;
+}
+
+int main(int argc, char **argv) {
+  const int n = argc > 1 ? atoi(argv[1]) : 500;
+  const int chords = argc > 2 ? atoi(argv[2]) : 1000;
+  const int count = argc > 3 ? atoi(argv[3]) : 3;
+
+  GVC_t *gvc = gvContext();
+  Agraph_t *g = make_graph(n, chords);
+
+  double *first = calloc((size_t)n * 2, sizeof(first[0]));
+  if (first == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+  double best = 0;
+  for (int j = 0; j < count; ++j) {
+    const double start = now();
+    if (gvLayout(gvc, g, "circo") != 0) {
+      fprintf(stderr, "layout failed\n");
+      return EXIT_FAILURE;
+    }
+    const double elapsed = now() - start;
+    if (j == 0 || elapsed < best) {
+      best = elapsed;
+    }
+
+    int i = 0;
+    for (Agnode_t *v = agfstnode(g); v != NULL; v = agnxtnode(g, v), ++i) {
+      const pointf p = ND_coord(v);
+      if (j == 0) {
+        first[2 * i] = p.x;
+        first[2 * i + 1] = p.y;
+      } else if (first[2 * i] != p.x || first[2 * i + 1] != p.y) {
+        fprintf(stderr, "layout is not repeatable\n");
+        return EXIT_FAILURE;
+      }
+    }
+    gvFreeLayout(gvc, g);
+  }
+
+  printf("circo, %d nodes, %d edges: %.3fs\n", agnnodes(g), agnedges(g), best);
+
+  free(first);
+  agclose(g);
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
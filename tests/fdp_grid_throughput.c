@@ -0,0 +1,97 @@
+/// \file
+/// \brief benchmark driver for fdp's spring embedder
+///
+/// Builds a random sparse graph and lays it out with fdp repeatedly, with
+/// overlap removal and edge routing turned off so most of the time goes into
+/// the grid based force iterations. Every layout is checked to place all the
+/// nodes, and the best time is reported. The arguments give the number of nodes
+/// and the number of repetitions.
+///
+/// See test_misc.py:test_fdp_grid_throughput
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <graphviz/gvc.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/// a deterministic pseudo-random number generator
+static uint64_t next(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// a random tree of `n` nodes with `n / 2` further random edges
+static Agraph_t *make_graph(int n) {
+  Agraph_t *g = agopen("G", Agundirected, NULL);
+  agattr(g, AGRAPH, "overlap", "true");
+  agattr(g, AGRAPH, "splines", "false");
+  Agnode_t **nodes = calloc((size_t)n, sizeof(nodes[0]));
+  if (nodes == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  uint64_t state = 42;
+  for (int i = 0; i < n; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "%d", i);
+    nodes[i] = agnode(g, name, 1);
+    if (i > 0) {
+      agedge(g, nodes[next(&state) % (uint64_t)i], nodes[i], NULL, 1);
+    }
+  }
+  for (int i = 0; i < n / 2; ++i) {
+    const int a = (int)(next(&state) % (uint64_t)n);
+    const int b = (int)(next(&state) % (uint64_t)n);
+    if (a != b) {
+      agedge(g, nodes[a], nodes[b], NULL, 1);
+    }
+  }
+  free(nodes);
+  return g;
+}
+
+int main(int argc, char **argv) {
+  const int n = argc > 1 ? atoi(argv[1]) : 1000;
+  const int count = argc > 2 ? atoi(argv[2]) : 3;
+
+  GVC_t *gvc = gvContext();
+  Agraph_t *g = make_graph(n);
+
+  double best = 0;
+  for (int j = 0; j < count; ++j) {
+    const double start = now();
+    if (gvLayout(gvc, g, "fdp") != 0) {
+      fprintf(stderr, "layout failed\n");
+      return EXIT_FAILURE;
+    }
+    const double elapsed = now() - start;
+    if (j == 0 || elapsed < best) {
+      best = elapsed;
+    }
+
+    for (Agnode_t *v = agfstnode(g); v != NULL; v = agnxtnode(g, v)) {
+      const pointf p = ND_coord(v);
+      if (!isfinite(p.x) || !isfinite(p.y)) {
+        fprintf(stderr, "node %s was not placed\n", agnameof(v));
+        return EXIT_FAILURE;
+      }
+    }
+    gvFreeLayout(gvc, g);
+  }
+
+  printf("fdp, %d nodes, %d edges: %.3fs\n", agnnodes(g), agnedges(g), best);
+
+  agclose(g);
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/// \file
+/// \brief test case driver for the binary graph format
+///
+/// Reads a DOT graph from stdin, round trips it through the binary format and
+/// checks `agwrite` prints both identically. With `-b <count>`, instead times
+/// loading the graph from DOT and from the binary format `count` times.
+///
+/// See test_misc.py:test_gvb_roundtrip and test_gvb_load_benchmark
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+} buffer_t;
+
+static size_t put(void *chan, const char *buf, size_t size) {
+  buffer_t *b = chan;
+  if (b->size + size > b->capacity) {
+    b->capacity = (b->size + size) * 2;
+    b->data = realloc(b->data, b->capacity);
+    assert(b->data != NULL);
+  }
+  memcpy(b->data + b->size, buf, size);
+  b->size += size;
+  return size;
+}
+
+/// `agwrite` a graph into memory
+static buffer_t text(Agraph_t *g) {
+  FILE *tmp = tmpfile();
+  assert(tmp != NULL);
+  int rc = agwrite(g, tmp);
+  assert(rc == 0);
+  (void)rc;
+
+  buffer_t b = {0};
+  rewind(tmp);
+  char buf[BUFSIZ];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), tmp)) > 0)
+    put(&b, buf, n);
+  fclose(tmp);
+  put(&b, "", 1);
+  return b;
+}
+
+static double now(void) { return (double)clock() / CLOCKS_PER_SEC; }
+
+int main(int argc, char **argv) {
+  int count = 0;
+  if (argc == 3 && strcmp(argv[1], "-b") == 0)
+    count = atoi(argv[2]);
+
+  Agraph_t *g = agread(stdin, NULL);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read input graph\n");
+    return EXIT_FAILURE;
+  }
+
+  buffer_t bin = {0};
+  if (agwritebin(g, &bin, put) != 0) {
+    fprintf(stderr, "agwritebin failed\n");
+    return EXIT_FAILURE;
+  }
+  buffer_t dot = text(g);
+  agclose(g);
+
+  if (count > 0) {
+    double start = now();
+    for (int i = 0; i < count; ++i)
+      agclose(agmemread(dot.data));
+    const double dot_time = now() - start;
+
+    start = now();
+    for (int i = 0; i < count; ++i)
+      agclose(agmemreadbin(bin.data, bin.size, NULL));
+    const double bin_time = now() - start;
+
+    printf("DOT: %zu bytes, %.3fs\n", dot.size - 1, dot_time);
+    printf("binary: %zu bytes, %.3fs\n", bin.size, bin_time);
+  } else {
+    Agraph_t *h = agmemreadbin(bin.data, bin.size, NULL);
+    if (h == NULL) {
+      fprintf(stderr, "agmemreadbin failed\n");
+      return EXIT_FAILURE;
+    }
+    buffer_t round = text(h);
+    agclose(h);
+    if (strcmp(dot.data, round.data) != 0) {
+      fprintf(stderr, "round trip differs:\n%s\nvs\n%s\n", dot.data,
+              round.data);
+      return EXIT_FAILURE;
+    }
+    free(round.data);
+  }
+
+  free(dot.data);
+  free(bin.data);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/// \file
+/// \brief benchmark driver for the numeric output functions of `gvio.h`
+///
+/// Prints a large set of coordinates through `gvprintpointflist`,
+/// `gvprintpointf` and `gvprintdouble`, checks the output byte for byte
+/// against a reference built with `snprintf` and reports the throughput. The
+/// first argument gives the number of repetitions.
+///
+/// See test_misc.py:test_gvprintnum_throughput
+
+#include <gvc.h>
+#include <gvcint.h>
+#include <gvio.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// an in-memory output
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+} output_t;
+
+static output_t output;
+
+static size_t write_fn(GVJ_t *job, const char *s, size_t len) {
+  (void)job;
+  if (output.size + len > output.capacity) {
+    size_t c = output.capacity == 0 ? BUFSIZ : output.capacity * 2;
+    while (output.size + len > c) {
+      c *= 2;
+    }
+    output.data = realloc(output.data, c);
+    if (output.data == NULL) {
+      fprintf(stderr, "out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+    output.capacity = c;
+  }
+  memcpy(output.data + output.size, s, len);
+  output.size += len;
+  return len;
+}
+
+/// `snprintf` with trailing zeros removed
+static void reference_print(char *buf, size_t size, const char *format,
+                            double number) {
+  snprintf(buf, size, format, number);
+  char *period = strchr(buf, '.');
+  if (period == NULL) {
+    return;
+  }
+  char *end = buf + strlen(buf);
+  while (end[-1] == '0') {
+    --end;
+  }
+  if (end[-1] == '.') {
+    --end;
+  }
+  *end = '\0';
+  if (strcmp(buf, "-0") == 0) {
+    strcpy(buf, "0");
+  }
+}
+
+/// reference version of how `gvprintpointf` prints a coordinate
+static void reference_num(char *buf, size_t size, double number) {
+  static const double limit = 999999999999999.99;
+  if (number < -limit) {
+    snprintf(buf, size, "-999999999999999.99");
+    return;
+  }
+  if (number > limit) {
+    snprintf(buf, size, "999999999999999.99");
+    return;
+  }
+  reference_print(buf, size, "%.03f", number);
+  if (strncmp(buf, "0.", 2) == 0) {
+    memmove(buf, buf + 1, strlen(buf));
+  } else if (strncmp(buf, "-0.", 3) == 0) {
+    memmove(buf + 1, buf + 2, strlen(buf + 1));
+  }
+}
+
+/// append a string to a reference output
+static void append(char **dst, size_t *len, size_t *cap, const char *s) {
+  const size_t n = strlen(s);
+  if (*len + n + 1 > *cap) {
+    *cap = (*len + n + 1) * 2;
+    *dst = realloc(*dst, *cap);
+    if (*dst == NULL) {
+      fprintf(stderr, "out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  memcpy(*dst + *len, s, n + 1);
+  *len += n;
+}
+
+/// a deterministic pseudo-random number generator
+static uint64_t next(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+/// a value of the kind and range seen in layouts, plus a few awkward ones
+static double sample(uint64_t *state) {
+  static const double special[] = {0,      -0.0,   0.0005,  -0.0005, 0.0625,
+                                   0.125,  -2.5,   1e-9,    -1e-9,   0.9995,
+                                   -0.999, 1e8,    -1e8,    1e15,    -1e16,
+                                   1e300,  -1e300, 99999.9996};
+  const uint64_t r = next(state);
+  switch (r % 8) {
+  case 0:
+    return special[next(state) % (sizeof(special) / sizeof(special[0]))];
+  case 1: // values with few fractional digits
+    return (double)(int64_t)(next(state) % 2000000 - 1000000) / 64;
+  case 2: // small magnitudes
+    return ((double)next(state) / (double)(1ull << 53) - 0.5) / 100;
+  case 3: // large magnitudes
+    return ((double)next(state) / (double)(1ull << 53) - 0.5) * 1e10;
+  default: // typical coordinates
+    return ((double)next(state) / (double)(1ull << 53) - 0.5) * 20000;
+  }
+}
+
+int main(int argc, char **argv) {
+  const int count = argc > 1 ? atoi(argv[1]) : 10;
+  enum { N = 200000 };
+
+  pointf *points = malloc(sizeof(pointf) * N);
+  if (points == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+  uint64_t state = 42;
+  for (size_t i = 0; i < N; ++i) {
+    points[i].x = sample(&state);
+    points[i].y = sample(&state);
+  }
+
+  // construct the expected output
+  char *expected = NULL;
+  size_t expected_len = 0;
+  size_t expected_cap = 0;
+  char buf[512];
+  for (size_t i = 0; i < N; ++i) { // gvprintpointflist
+    if (i > 0) {
+      append(&expected, &expected_len, &expected_cap, " ");
+    }
+    reference_num(buf, sizeof(buf), points[i].x);
+    append(&expected, &expected_len, &expected_cap, buf);
+    append(&expected, &expected_len, &expected_cap, " ");
+    reference_num(buf, sizeof(buf), points[i].y);
+    append(&expected, &expected_len, &expected_cap, buf);
+  }
+  append(&expected, &expected_len, &expected_cap, "\n");
+  for (size_t i = 0; i < N; ++i) { // gvprintpointf
+    reference_num(buf, sizeof(buf), points[i].x);
+    append(&expected, &expected_len, &expected_cap, buf);
+    append(&expected, &expected_len, &expected_cap, " ");
+    reference_num(buf, sizeof(buf), points[i].y);
+    append(&expected, &expected_len, &expected_cap, buf);
+    append(&expected, &expected_len, &expected_cap, ",");
+  }
+  append(&expected, &expected_len, &expected_cap, "\n");
+  for (size_t i = 0; i < N; ++i) { // gvprintdouble
+    reference_print(buf, sizeof(buf), "%.02f", points[i].x);
+    append(&expected, &expected_len, &expected_cap, buf);
+    append(&expected, &expected_len, &expected_cap, ",");
+  }
+
+  GVC_t *gvc = gvContext();
+  gvc->write_fn = write_fn;
+  GVJ_t job = {.gvc = gvc, .common = &gvc->common};
+
+  const clock_t start = clock();
+  for (int i = 0; i < count; ++i) {
+    output.size = 0;
+    gvprintpointflist(&job, points, N);
+    gvputs(&job, "\n");
+    for (size_t j = 0; j < N; ++j) {
+      gvprintpointf(&job, points[j]);
+      gvputs(&job, ",");
+    }
+    gvputs(&job, "\n");
+    for (size_t j = 0; j < N; ++j) {
+      gvprintdouble(&job, points[j].x);
+      gvputs(&job, ",");
+    }
+  }
+  const double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  if (output.size != expected_len ||
+      memcmp(output.data, expected, expected_len) != 0) {
+    for (size_t i = 0; i < output.size && i < expected_len; ++i) {
+      if (output.data[i] != expected[i]) {
+        const size_t from = i < 40 ? 0 : i - 40;
+        fprintf(stderr, "output differs at byte %zu:\n  got:      %.80s\n"
+                "  expected: %.80s\n", i, output.data + from,
+                expected + from);
+        break;
+      }
+    }
+    fprintf(stderr, "output is %zu bytes, expected %zu\n", output.size,
+            expected_len);
+    return EXIT_FAILURE;
+  }
+
+  printf("%d runs of %zu bytes in %.3fs", count, output.size, elapsed);
+  if (elapsed > 0)
+    printf(", %.1f MB/s", (double)output.size * count / elapsed / 1e6);
+  printf("\n");
+
+  gvFreeContext(gvc);
+  free(expected);
+  free(output.data);
+  free(points);
+  return EXIT_SUCCESS;
+}
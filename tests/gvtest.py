@@ -98,6 +98,7 @@ def dot(
         "json",
         "pic",
         "svg",
+        "svg:compact",
         "svg_inline",
         "xdot",
     )
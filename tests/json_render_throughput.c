@@ -0,0 +1,139 @@
+/// \file
+/// \brief benchmark driver for the JSON renderer
+///
+/// Builds a large synthetic graph with fixed node positions, lays it out with
+/// nop and renders it repeatedly in the JSON formats and, for comparison, as
+/// SVG and xdot. Every rendering of a format is checked to be the same as the
+/// first, and the throughput of each is reported. The first argument gives
+/// the number of nodes and the second the number of repetitions.
+///
+/// See test_misc.py:test_json_render_throughput
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <graphviz/gvc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// a deterministic pseudo-random number generator
+static uint64_t next(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/// a graph of `n` nodes on a grid, each with edges to some of its neighbours
+static Agraph_t *make_graph(int n) {
+  Agraph_t *g = agopen("G", Agdirected, NULL);
+  agattr(g, AGNODE, "pos", "");
+  agattr(g, AGNODE, "label", "\\N");
+  agattr(g, AGNODE, "shape", "ellipse");
+  agattr(g, AGEDGE, "label", "");
+  agattr(g, AGEDGE, "color", "black");
+
+  int side = 1;
+  while (side * side < n) {
+    ++side;
+  }
+
+  Agnode_t **nodes = calloc((size_t)n, sizeof(nodes[0]));
+  if (nodes == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  uint64_t state = 42;
+  for (int i = 0; i < n; ++i) {
+    char name[64];
+    // names with characters JSON needs escaped
+    snprintf(name, sizeof(name), i % 7 == 0 ? "n\"%d\"/x" : "node%d", i);
+    nodes[i] = agnode(g, name, 1);
+    char pos[64];
+    snprintf(pos, sizeof(pos), "%d,%d!", i % side * 150, i / side * 100);
+    agsafeset(nodes[i], "pos", pos, "");
+    if (i % 5 == 0) {
+      agsafeset(nodes[i], "shape", "box", "");
+      agsafeset(nodes[i], "label", "a longer\\nlabel/\"quoted\"", "");
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    const int degree = 1 + (int)(next(&state) % 3);
+    for (int j = 0; j < degree; ++j) {
+      const int k = i + 1 + (int)(next(&state) % (uint64_t)side);
+      if (k >= n) {
+        continue;
+      }
+      Agedge_t *e = agedge(g, nodes[i], nodes[k], NULL, 1);
+      if (next(&state) % 4 == 0) {
+        agsafeset(e, "color", "red:blue", "");
+      }
+    }
+  }
+  free(nodes);
+  return g;
+}
+
+int main(int argc, char **argv) {
+  const int n = argc > 1 ? atoi(argv[1]) : 1000;
+  const int count = argc > 2 ? atoi(argv[2]) : 5;
+
+  GVC_t *gvc = gvContext();
+  Agraph_t *g = make_graph(n);
+  if (gvLayout(gvc, g, "nop") != 0) {
+    fprintf(stderr, "layout failed\n");
+    return EXIT_FAILURE;
+  }
+
+  // json leaves xdot attributes on the graph, which xdot_json then includes
+  static const char *const formats[] = {"json0", "dot_json", "json",
+                                        "xdot_json", "xdot", "svg"};
+  for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+    char *first = NULL;
+    unsigned first_size = 0;
+    double best = 0;
+    for (int j = 0; j < count; ++j) {
+      char *data;
+      unsigned size;
+      const double start = now();
+      if (gvRenderData(gvc, g, formats[i], &data, &size) != 0) {
+        fprintf(stderr, "rendering %s failed\n", formats[i]);
+        return EXIT_FAILURE;
+      }
+      const double elapsed = now() - start;
+      if (j == 0 || elapsed < best) {
+        best = elapsed;
+      }
+      if (first == NULL) {
+        first = data;
+        first_size = size;
+        continue;
+      }
+      if (size != first_size || memcmp(data, first, size) != 0) {
+        fprintf(stderr, "rendering %s is not repeatable\n", formats[i]);
+        return EXIT_FAILURE;
+      }
+      gvFreeRenderData(data);
+    }
+    if (strstr(formats[i], "json") != NULL &&
+        (first_size < 2 || first[0] != '{' ||
+         memcmp(first + first_size - 2, "}\n", 2) != 0)) {
+      fprintf(stderr, "%s output is not a JSON object\n", formats[i]);
+      return EXIT_FAILURE;
+    }
+    printf("%-9s %10u bytes in %.3fs, %.1f MB/s\n", formats[i], first_size,
+           best, best > 0 ? first_size / best / 1e6 : 0);
+    gvFreeRenderData(first);
+  }
+
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/// \file
+/// \brief test driver for `gvRenderSink`
+///
+/// Reads a DOT graph from stdin, lays it out with dot and renders it in the
+/// format given as the first argument through both `gvRenderData` and
+/// `gvRenderSink`, checking the two agree and that the output arrives in
+/// bounded chunks.
+///
+/// See test_misc.py:test_render_sink
+
+#include <graphviz/gvc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// largest chunk `gvRenderSink` is documented to deliver
+enum { CHUNK_LIMIT = 64 * 1024 };
+
+/// output received by the callback
+typedef struct {
+  char *data;
+  size_t size;
+  size_t chunks;
+  size_t largest; ///< size of the largest chunk
+  size_t refuse_after; ///< number of chunks to accept, or 0 for all
+} sink_t;
+
+static size_t collect(void *context, const char *data, size_t length) {
+  sink_t *sink = context;
+  if (sink->refuse_after != 0 && sink->chunks == sink->refuse_after) {
+    return 0;
+  }
+  sink->data = realloc(sink->data, sink->size + length);
+  if (sink->data == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(sink->data + sink->size, data, length);
+  sink->size += length;
+  ++sink->chunks;
+  if (length > sink->largest) {
+    sink->largest = length;
+  }
+  return length;
+}
+
+int main(int argc, char **argv) {
+  const char *format = argc > 1 ? argv[1] : "svg";
+
+  GVC_t *gvc = gvContext();
+  Agraph_t *g = agread(stdin, NULL);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read input graph\n");
+    return EXIT_FAILURE;
+  }
+  if (gvLayout(gvc, g, "dot") != 0) {
+    fprintf(stderr, "layout failed\n");
+    return EXIT_FAILURE;
+  }
+
+  char *expected;
+  unsigned length;
+  if (gvRenderData(gvc, g, format, &expected, &length) != 0) {
+    fprintf(stderr, "gvRenderData failed\n");
+    return EXIT_FAILURE;
+  }
+
+  sink_t sink = {0};
+  if (gvRenderSink(gvc, g, format, collect, &sink) != 0) {
+    fprintf(stderr, "gvRenderSink failed\n");
+    return EXIT_FAILURE;
+  }
+  if (sink.size != length || memcmp(sink.data, expected, length) != 0) {
+    fprintf(stderr, "gvRenderSink gave %zu bytes, gvRenderData %u bytes\n",
+            sink.size, length);
+    return EXIT_FAILURE;
+  }
+  if (sink.largest > CHUNK_LIMIT) {
+    fprintf(stderr, "chunk of %zu bytes exceeds %d\n", sink.largest,
+            CHUNK_LIMIT);
+    return EXIT_FAILURE;
+  }
+  printf("%zu bytes in %zu chunks of at most %zu bytes\n", sink.size,
+         sink.chunks, sink.largest);
+
+  // a callback refusing output should make rendering fail
+  sink_t refusing = {.refuse_after = 1};
+  if (gvRenderSink(gvc, g, format, collect, &refusing) == 0) {
+    fprintf(stderr, "gvRenderSink ignored a failing callback\n");
+    return EXIT_FAILURE;
+  }
+  if (refusing.chunks != 1) {
+    fprintf(stderr, "output continued after the callback failed\n");
+    return EXIT_FAILURE;
+  }
+
+  free(refusing.data);
+  free(sink.data);
+  gvFreeRenderData(expected);
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
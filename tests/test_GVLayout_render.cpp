@@ -1,4 +1,7 @@
 #include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #include <catch2/catch.hpp>
 
@@ -37,3 +40,37 @@ TEST_CASE("Rendering in an unknown format throws an exception") {
 
   REQUIRE_THROWS_AS(layout.render("UNKNOWN_FORMAT"), std::runtime_error);
 }
+
+TEST_CASE("Rendered output can be streamed to a sink") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  auto dot = "digraph {a -> b -> c}";
+  auto g = std::make_shared<CGraph::AGraph>(dot);
+
+  const auto layout = GVC::GVLayout(gvc, g, "dot");
+
+  std::string streamed;
+  layout.render("svg",
+                [&](std::string_view chunk) { streamed.append(chunk); });
+
+  const auto result = layout.render("svg");
+  REQUIRE(streamed == result.string_view());
+}
+
+TEST_CASE("An exception thrown by a sink is passed on to the caller") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  auto dot = "digraph {a}";
+  auto g = std::make_shared<CGraph::AGraph>(dot);
+
+  const auto layout = GVC::GVLayout(gvc, g, "dot");
+
+  REQUIRE_THROWS_AS(
+      layout.render("svg",
+                    [](std::string_view) { throw std::length_error("full"); }),
+      std::length_error);
+}
@@ -2,19 +2,30 @@
 Graphviz miscellaneous test cases
 """
 
+import gzip
 import itertools
 import json
 import os
 import platform
+import re
+import shutil
 import subprocess
 import sys
 import tempfile
+import time
+import xml.etree.ElementTree as ET
 from pathlib import Path
+from typing import List
 
 import pytest
 
 sys.path.append(os.path.dirname(__file__))
-from gvtest import ROOT, compile_c, dot  # pylint: disable=wrong-import-position
+from gvtest import (  # pylint: disable=wrong-import-position
+    ROOT,
+    compile_c,
+    dot,
+    run_c,
+)
 
 
 def test_json_node_order():
@@ -228,3 +239,672 @@ def test_xml_escape():
                     assert escaped == f"character |{expected}|", "bad UTF-8 escaping"
                 else:
                     assert escaped == unescaped, "bad UTF-8 passthrough"
+
+
+@pytest.mark.skipif(
+    platform.system() == "Windows", reason="-j is not supported on Windows"
+)
+@pytest.mark.parametrize("format", ("dot", "svg"))
+def test_pipelined_rendering(format: str):
+    """
+    `-j` should produce the same output as processing graphs one at a time
+    """
+
+    # a stream of graphs with braces hidden in strings and comments
+    src = "\n".join(
+        f'digraph g{i} {{ /* }} */ a{i} -> b{i} [label="{{{i}}}"]; '
+        f"c{i} [label=<<b>}}</b>>]; subgraph {{ d{i} }} }}"
+        for i in range(20)
+    )
+
+    sequential = dot(format, source=src)
+    pipelined = subprocess.check_output(
+        ["dot", f"-T{format}", "-j4"], input=src, universal_newlines=True
+    )
+
+    assert pipelined == sequential, "-j changed the output"
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+@pytest.mark.parametrize(
+    "src",
+    (
+        "graphs/directed/clust4.gv",
+        "graphs/directed/crazy.gv",
+        "graphs/directed/switch.gv",
+        "graphs/directed/world.gv",
+        "graphs/undirected/ngk10_4.gv",
+        "tests/graphs/html.gv",
+    ),
+)
+def test_gvb_roundtrip(src: str):
+    """
+    a graph read back from the binary format should be written as the original
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "gvb.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a laid out graph exercises many more attributes than its source
+    laid_out = dot("dot", ROOT / src)
+
+    run_c(c_src, input=laid_out, link=["cgraph"])
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_gvb_load_benchmark():
+    """
+    time loading a large graph from DOT and from the binary format
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "gvb.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    laid_out = dot("dot", ROOT / "graphs/directed/world.gv")
+
+    stdout, _ = run_c(c_src, ["-b", "20"], input=laid_out, link=["cgraph"])
+    print(stdout)
+
+
+@pytest.mark.parametrize("jobs", ((), ("-j2",)))
+def test_gvb_input(jobs):
+    """
+    `-Tgvb` output should be recognized as input and hold the laid out graph
+    """
+
+    if jobs and platform.system() == "Windows":
+        pytest.skip("-j is not supported on Windows")
+
+    src = "digraph { a -> b; subgraph cluster_x { label=<<i>x</i>>; c } }\n"
+    src += "graph { d -- e [color=red] }\n"
+
+    # the laid out graphs, via DOT
+    text = dot("dot", source=src)
+    expected = subprocess.check_output(
+        ["dot", "-Tcanon"], input=text, universal_newlines=True
+    )
+
+    # the laid out graphs, via the binary format
+    binary = subprocess.check_output(["dot", "-Tgvb"], input=src.encode("utf-8"))
+    assert binary.startswith(b"\x89GVB\r\n\x1a\n"), "missing magic"
+    canon = subprocess.check_output(["dot", "-Tcanon", *jobs], input=binary)
+
+    assert canon.decode("utf-8") == expected, "binary format lost information"
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_agwrite_throughput():
+    """
+    time writing out a large graph
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "agwrite_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a large graph with a mix of plain and quoted names and attributes
+    src = ["digraph {", "  node [shape=box];"]
+    for i in range(20000):
+        src += [f'  n{i} -> n{(i * 7) % 20000} [weight={i % 5}, label="e {i}"];']
+        src += [f'  "node {i}" -> n{i} [color=red];']
+    src += ["}"]
+
+    stdout, _ = run_c(c_src, ["10"], input="\n".join(src), link=["cgraph"])
+    print(stdout)
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+@pytest.mark.parametrize("format", ("svg", "svgz", "xdot"))
+def test_render_sink(format: str):
+    """
+    rendering through a callback should give the same output as
+    `gvRenderData`, delivered in bounded chunks
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "render_sink.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # a graph whose output spans many chunks
+    src = ["digraph {"]
+    for i in range(1, 2000):
+        src += [f'  n{(i - 1) // 4} -> n{i} [label="edge {i}"];']
+    src += ["}"]
+
+    stdout, _ = run_c(c_src, [format], input="\n".join(src), link=["cgraph", "gvc"])
+    print(stdout)
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_xdot_parse_throughput():
+    """
+    time parsing xdot, checking the arena and parallel parsers agree with
+    `parseXDot`
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "xdot_parse_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, ["100000", "0"], link=["xdot"])
+    print(stdout)
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_json_render_throughput():
+    """
+    time rendering a large graph as JSON, compared to SVG and xdot
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "json_render_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, ["2000", "3"], link=["cgraph", "gvc"])
+    print(stdout)
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_circo_block_throughput():
+    """
+    time circo on a large biconnected graph, dominated by crossing reduction
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "circo_block_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, ["500", "1500", "2"], link=["cgraph", "gvc"])
+    print(stdout)
+
+
+def test_twopi_long_chain():
+    """
+    twopi should lay out a long path without recursing along it
+    """
+
+    n = 100000
+    src = "graph { " + " ".join(f"{i} -- {i + 1};" for i in range(n - 1)) + " }"
+
+    # have twopi report the center it picks
+    out = subprocess.check_output(
+        ["twopi", "-Groot=", "-Tdot"], input=src, universal_newlines=True
+    )
+
+    # the center of a path is its middle node
+    assert re.search(rf"\broot={n // 2 - 1}\b", out), "wrong center chosen"
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_fdp_grid_throughput():
+    """
+    time fdp's force iterations on a large sparse graph
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "fdp_grid_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    stdout, _ = run_c(c_src, ["1000", "2"], link=["cgraph", "gvc"])
+    print(stdout)
+
+
+def test_fdp_threads():
+    """
+    fdp layouts should not depend on how many threads compute them
+    """
+
+    # a graph big enough to be split among threads
+    n = 2500
+    edges = [f"{(i * 7919 + 13) % i} -- {i};" for i in range(1, n)]
+    edges += [f"{(i * 104729) % n} -- {(i * 1299709) % n};" for i in range(n // 2)]
+    src = "graph { overlap=true; splines=false; " + " ".join(edges) + " }"
+
+    outputs = []
+    for threads in ("1", "3"):
+        env = os.environ.copy()
+        env["GV_FDP_THREADS"] = threads
+        outputs.append(
+            subprocess.check_output(
+                ["fdp", "-Tplain"], input=src, env=env, universal_newlines=True
+            )
+        )
+
+    assert outputs[0] == outputs[1], "fdp layout changed with the thread count"
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+@pytest.mark.parametrize(
+    "src",
+    (
+        "graphs/directed/clust4.gv",
+        "graphs/directed/records.gv",
+        "graphs/directed/world.gv",
+        "tests/graphs/html.gv",
+        "gradients",
+    ),
+)
+def test_xdot_bin(src: str):
+    """
+    binary xdot should hold the same ops as xdot, and be quicker to read
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "xdot_bin.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    if src == "gradients":
+        source = """digraph {
+          subgraph cluster_a {
+            style=filled; fillcolor="red:blue"; gradientangle=90; label="A";
+            a [style=filled, fillcolor="yellow:green", gradientangle=30];
+          }
+          b [label=<<B>bold</B> and <I>italic</I>>];
+          c [style=radial, fillcolor="white:black"];
+          a -> b [label="x", headlabel="h", taillabel="t", dir=both];
+          b -> c [style=dashed, penwidth=3];
+          label="graph";
+        }"""
+    else:
+        source = (ROOT / src).read_text(encoding="utf-8")
+
+    stdout, _ = run_c(c_src, ["20"], input=source, link=["cgraph", "gvc", "xdot"])
+    print(stdout)
+
+
+def _svg_numbers(text: str) -> List[float]:
+    """
+    the numbers of an SVG attribute
+    """
+    return [float(x) for x in re.findall(r"-?(?:\d+\.?\d*|\.\d+)", text)]
+
+
+def _svg_path_points(d: str) -> List[List[float]]:
+    """
+    absolute points of SVG path data, as -Tsvg and -Tsvg:compact write it
+    """
+    points = []
+    x = y = 0.0
+    for cmd, args in re.findall(r"([MmCcLlHhVvZz])([^MmCcLlHhVvZz]*)", d):
+        nums = _svg_numbers(args)
+        if cmd == "M":
+            x, y = nums[0], nums[1]
+            points.append([x, y])
+            # any further pairs are lineto, or the points of -Tsvg's "C"
+            nums = nums[2:]
+            cmd = "L"
+        if cmd in "CL":
+            for i in range(0, len(nums), 2):
+                points.append([nums[i], nums[i + 1]])
+            if nums:
+                x, y = points[-1]
+        elif cmd in "cl":
+            step = 6 if cmd == "c" else 2
+            for i in range(0, len(nums), step):
+                for j in range(i, i + step, 2):
+                    points.append([x + nums[j], y + nums[j + 1]])
+                x, y = points[-1]
+        elif cmd in "hv":
+            for n in nums:
+                if cmd == "h":
+                    x += n
+                else:
+                    y += n
+                points.append([x, y])
+    return points
+
+
+def _svg_drawing(svg: str) -> List:
+    """
+    what an SVG document from Graphviz draws, independent of how it is written
+    """
+    ns = {"svg": "http://www.w3.org/2000/svg", "xlink": "http://www.w3.org/1999/xlink"}
+    root = ET.fromstring(svg)
+
+    # styles of the classes of compact output
+    classes = {}
+    for style in root.iterfind(".//svg:style", ns):
+        for name, body in re.findall(r"\.(\w+)\{([^}]*)\}", style.text):
+            classes[name] = dict(d.split(":", 1) for d in body.split(";"))
+    defs = {
+        e.get("id"): e for e in root.iterfind(".//svg:defs/svg:path", ns) if e.get("id")
+    }
+
+    style_names = (
+        "fill",
+        "fill-opacity",
+        "stroke",
+        "stroke-width",
+        "stroke-dasharray",
+        "stroke-opacity",
+        "text-anchor",
+        "font-family",
+        "font-weight",
+        "font-stretch",
+        "font-style",
+        "font-size",
+        "text-decoration",
+        "baseline-shift",
+    )
+
+    drawing = []
+    for e in root.iter():
+        tag = e.tag.split("}")[-1]
+        if tag in ("svg", "style", "defs") or e in defs.values():
+            continue
+        style = {k: v for k, v in e.attrib.items() if k in style_names}
+        for name in (e.get("class") or "").split():
+            style.update(classes.get(name, {}))
+        for k, v in list(style.items()):
+            if k in ("font-size", "stroke-width"):
+                style[k] = round(float(v.replace("px", "")), 2)
+        attrs = {
+            k: v for k, v in e.attrib.items() if k not in style_names and k != "class"
+        }
+        if e.get("class") is not None and not e.get("class").startswith("s"):
+            attrs["class"] = e.get("class")
+
+        points = []
+        if tag in ("polygon", "polyline"):
+            points = _svg_numbers(attrs.pop("points"))
+            points = [points[i : i + 2] for i in range(0, len(points), 2)]
+            if tag == "polygon":
+                points = points[:-1]  # the repeated first point
+        elif tag == "path":
+            d = attrs.pop("d")
+            if d.endswith("z"):
+                tag = "polygon"
+            elif "c" not in d and "C" not in d:
+                tag = "polyline"
+            points = _svg_path_points(d)
+        elif tag == "use":
+            href = attrs.pop("{http://www.w3.org/1999/xlink}href")[1:]
+            dx, dy = float(attrs.pop("x")), float(attrs.pop("y"))
+            d = defs[href].get("d")
+            tag = "polygon" if d.endswith("z") else "path" if "c" in d else "polyline"
+            points = [[x + dx, y + dy] for x, y in _svg_path_points(d)]
+        elif tag in ("ellipse", "circle"):
+            if tag == "circle":
+                attrs["rx"] = attrs["ry"] = attrs.pop("r")
+            tag = "ellipse"
+            points = [[float(attrs.pop(k)) for k in ("cx", "cy", "rx", "ry")]]
+        elif tag in ("text", "tspan") and "x" in attrs:
+            points = [[float(attrs.pop("x")), float(attrs.pop("y"))]]
+        if tag == "tspan":
+            attrs.pop("dy", None)
+        text = (e.text or "").strip()
+        drawing.append((tag, attrs, style, points, text))
+    return drawing
+
+
+@pytest.mark.parametrize(
+    "src",
+    (
+        "graphs/directed/clust4.gv",
+        "graphs/directed/world.gv",
+        "tests/graphs/arrows.gv",
+        "tests/graphs/grdshapes.gv",
+        "tests/graphs/html.gv",
+        "tests/graphs/style.gv",
+        "arrowheads",
+    ),
+)
+def test_svg_compact(src: str):
+    """
+    -Tsvg:compact should draw the same as -Tsvg, in less space
+    """
+    if src == "arrowheads":
+        # recurring arrowheads, which can be shared
+        source = ["digraph { node [shape=point]; edge [arrowhead=crow];"]
+        for i in range(20):
+            source += [f"a{i} -> b{i}; a{i} -> c{i} [dir=both, arrowtail=diamond];"]
+        source = "\n".join(source + ["}"])
+    else:
+        source = (ROOT / src).read_text(encoding="utf-8")
+    normal = dot("svg", source=source)
+    compact = dot("svg:compact", source=source)
+    if src == "arrowheads":
+        assert "<use " in compact, "arrowheads not shared"
+    print(f"svg: {len(normal)} bytes, svg:compact: {len(compact)} bytes")
+    assert len(compact) < len(normal), "compact output is not smaller"
+
+    expected = _svg_drawing(normal)
+    actual = _svg_drawing(compact)
+    assert len(actual) == len(expected), "different number of elements"
+    for want, got in zip(expected, actual):
+        assert got[0] == want[0], f"{got} drawn instead of {want}"
+        assert got[1] == want[1], f"attributes of {want} differ"
+        assert got[2] == want[2], f"style of {want} differs"
+        assert got[4] == want[4], f"text of {want} differs"
+        assert len(got[3]) == len(want[3]), f"points of {want} differ"
+        for p, q in zip(got[3], want[3]):
+            assert p == pytest.approx(q, abs=0.11), f"points of {want} differ"
+
+
+@pytest.mark.parametrize("format", ("svgz", "svg.zst"))
+def test_compressed_output(format: str):
+    """
+    compressed output should decompress to the uncompressed output, whatever
+    the compression settings, and compress in reasonable time
+    """
+
+    # a graph with a few MB of SVG, spanning several compression blocks
+    src = ["digraph {"]
+    for i in range(3000):
+        src += [f'  n{i} [label="node {i}", tooltip="{i * 7919}"];']
+    src += ["}"]
+    src = "\n".join(src)
+
+    start = time.monotonic()
+    expected = dot("svg", source=src).encode("utf-8")
+    print(f"svg: {len(expected)} bytes in {time.monotonic() - start:.2f}s")
+
+    if format == "svgz":
+        decompress = gzip.decompress
+    else:
+        zstd = shutil.which("zstd")
+        if zstd is None:
+            pytest.skip("zstd not available")
+
+        def decompress(data: bytes) -> bytes:
+            return subprocess.run(
+                [zstd, "-dc"], input=data, stdout=subprocess.PIPE, check=True
+            ).stdout
+
+    for level, threads in (("", "1"), ("", "3"), ("1", "1"), ("9", "2")):
+        env = os.environ.copy()
+        env["GV_COMPRESSION_LEVEL"] = level
+        env["GV_COMPRESSION_THREADS"] = threads
+        start = time.monotonic()
+        p = subprocess.run(
+            ["dot", f"-T{format}"],
+            input=src.encode("utf-8"),
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            env=env,
+            check=False,
+        )
+        elapsed = time.monotonic() - start
+        if p.returncode != 0 and b"Format: " in p.stderr:
+            pytest.skip(f"{format} output not available")
+        assert p.returncode == 0, f"-T{format} failed"
+        print(
+            f"{format} level={level or 'default'} threads={threads}: "
+            f"{len(p.stdout)} bytes in {elapsed:.2f}s"
+        )
+        assert decompress(p.stdout) == expected, "compression lost information"
+
+
+@pytest.mark.skipif(
+    os.getenv("build_system") == "msbuild",
+    reason="Windows MSBuild release does not contain any header files (#1777)",
+)
+def test_gvprintnum_throughput(tmp_path: Path):
+    """
+    time printing coordinates, checking the output is unchanged
+    """
+
+    # find our co-located driver
+    c_src = (Path(__file__).parent / "gvprintnum_throughput.c").resolve()
+    assert c_src.exists(), "missing test case"
+
+    # `gvio.h` is not installed, so compile against the source tree
+    (tmp_path / "config.h").write_text("", encoding="utf-8")
+    cflags = ["-I", tmp_path]
+    for lib in ("gvc", "common", "pathplan", "cgraph", "cdt"):
+        cflags += ["-I", ROOT / "lib" / lib]
+
+    stdout, _ = run_c(c_src, ["10"], cflags=cflags, link=["cgraph", "gvc"])
+    print(stdout)
+
+
+def test_color_cache():
+    """
+    resolving the same color name under different color schemes should give
+    different colors
+    """
+
+    # the “1” and “2” below are a single string shared by all nodes
+    src = """digraph {
+      node [style=filled, fillcolor=1, color=2];
+      a [colorscheme=accent3];
+      b [colorscheme=blues3];
+      c [colorscheme=accent3];
+    }"""
+    svg = dot("svg", source=src)
+    fills = re.findall(r'<ellipse fill="([^"]*)" stroke="([^"]*)"', svg)
+    assert fills == [
+        ("#7fc97f", "#beaed4"),
+        ("#deebf7", "#9ecae1"),
+        ("#7fc97f", "#beaed4"),
+    ], "color scheme not applied to cached color"
+
+
+@pytest.mark.parametrize("format", ("svg", "json"))
+def test_text_cache(tmp_path: Path, format: str):
+    """
+    a persistent text measurement cache should not change output
+    """
+
+    input = Path(__file__).parent / "graphs/html.gv"
+    assert input.exists(), "unexpectedly missing test input"
+    cache = tmp_path / "text.cache"
+    env = os.environ.copy()
+    env["GV_TEXT_CACHE"] = str(cache)
+
+    expected = subprocess.check_output(
+        ["dot", f"-T{format}", input], universal_newlines=True
+    )
+
+    # the first run fills the cache, the second one answers from it
+    for _ in range(2):
+        output = subprocess.check_output(
+            ["dot", f"-T{format}", input], env=env, universal_newlines=True
+        )
+        assert cache.exists(), "text cache was not written"
+        assert output == expected, "text cache changed the output"
+
+    # a damaged cache should be ignored
+    cache.write_bytes(cache.read_bytes()[:50])
+    output = subprocess.check_output(
+        ["dot", f"-T{format}", input], env=env, universal_newlines=True
+    )
+    assert output == expected, "damaged text cache changed the output"
+
+
+@pytest.mark.parametrize(
+    "input",
+    ("graphs/b100.gv", "graphs/html.gv", "graphs/url.gv", "graphs/polypoly.gv"),
+)
+def test_multiple_formats(tmp_path: Path, input: str):
+    """
+    requesting several output formats at once should produce the same output
+    as requesting each of them separately
+    """
+
+    input = Path(__file__).parent / input
+    assert input.exists(), "unexpectedly missing test input"
+
+    formats = ("svg", "xdot", "json", "ps", "fig")
+
+    args = ["dot"]
+    for format in formats:
+        args += [f"-T{format}", f"-o{tmp_path / f'out.{format}'}"]
+    subprocess.check_call(args + [input])
+
+    for format in formats:
+        expected = subprocess.check_output(
+            ["dot", f"-T{format}", input], universal_newlines=True
+        )
+        output = (tmp_path / f"out.{format}").read_text()
+        assert output == expected, f"-T{format} output differs when combined"
+
+
+@pytest.mark.parametrize("input", ("graphs/clust.gv", "graphs/unix.gv"))
+def test_paged_output_order(input: str):
+    """
+    each page of paginated output should draw its objects in the same order as
+    unpaginated output does
+    """
+
+    input = Path(__file__).parent / input
+    assert input.exists(), "unexpectedly missing test input"
+
+    def objects(ps: str) -> List[List[str]]:
+        """the object comments on each page of PostScript output"""
+        pages: List[List[str]] = []
+        for line in ps.splitlines():
+            if line.startswith("%%Page:"):
+                pages.append([])
+            elif pages and line.startswith("% "):
+                pages[-1].append(line)
+        return pages
+
+    whole = objects(
+        subprocess.check_output(["dot", "-Tps", input], universal_newlines=True)
+    )
+    assert len(whole) == 1, "unexpected pagination"
+    order = {obj: i for i, obj in enumerate(whole[0])}
+
+    paged = objects(
+        subprocess.check_output(
+            ["dot", "-Tps", "-Gpage=3,3", input], universal_newlines=True
+        )
+    )
+    assert len(paged) > 1, "graph was not paginated"
+
+    seen = set()
+    for page in paged:
+        positions = [order[obj] for obj in page]
+        assert positions == sorted(positions), "objects out of order on a page"
+        seen.update(page)
+    assert seen == set(whole[0]), "some objects were drawn on no page"
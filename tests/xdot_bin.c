@@ -0,0 +1,351 @@
+/// \file
+/// \brief test driver for binary xdot output and its reader
+///
+/// Reads a DOT graph from stdin, lays it out with dot and renders it both as
+/// xdot, which leaves the xdot attributes on the graph, and as binary xdot.
+/// Every object in the binary xdot is then checked against `parseXDot` of the
+/// corresponding attribute, and the time to get at the ops of each is
+/// reported. The first argument gives the number of repetitions to time.
+///
+/// See test_misc.py:test_xdot_bin
+
+#include <graphviz/gvc.h>
+#include <graphviz/xdot.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// the difference allowed between a float and its xdot text, printed with 2
+/// decimals
+static const double TOLERANCE = 0.006;
+
+static const char *const stream_attrs[] = {"_draw_",   "_ldraw_",
+                                           "_hdraw_",  "_tdraw_",
+                                           "_hldraw_", "_tldraw_"};
+
+static Agraph_t *find_subgraph(Agraph_t *g, unsigned long id) {
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    if (AGSEQ(sg) == id) {
+      return sg;
+    }
+    Agraph_t *found = find_subgraph(sg, id);
+    if (found != NULL) {
+      return found;
+    }
+  }
+  return NULL;
+}
+
+/// the graph object a binary xdot object was drawn for
+static void *find_object(Agraph_t *g, const xdot_bin_object *o) {
+  switch (o->kind) {
+  case xd_bin_graph:
+    return g;
+  case xd_bin_cluster:
+    return find_subgraph(g, o->id);
+  case xd_bin_node:
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      if (AGSEQ(n) == o->id) {
+        return n;
+      }
+    }
+    return NULL;
+  default:
+    for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+      for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+        if (AGSEQ(e) == o->id) {
+          return e;
+        }
+      }
+    }
+    return NULL;
+  }
+}
+
+static bool near(double a, double b) { return fabs(a - b) <= TOLERANCE; }
+
+/// the numbers of a binary op
+static const float *values(const xdot_bin *xb, const xdot_bin_op *op) {
+  return &xb->points[2 * op->first_point];
+}
+
+static bool points_equal(const xdot_bin *xb, const xdot_bin_op *op,
+                         const xdot_polyline *pl) {
+  if (op->n_points != pl->cnt) {
+    return false;
+  }
+  for (size_t i = 0; i < pl->cnt; ++i) {
+    const float *p = &values(xb, op)[2 * i];
+    if (!near(p[0], pl->pts[i].x) || !near(p[1], pl->pts[i].y)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool rect_equal(const xdot_bin *xb, const xdot_bin_op *op,
+                       const xdot_rect *r) {
+  const float *v = values(xb, op);
+  return op->n_points == 2 && near(v[0], r->x) && near(v[1], r->y) &&
+         near(v[2], r->w) && near(v[3], r->h);
+}
+
+/// does a binary op match one parsed from xdot?
+static bool op_equal(const xdot_bin *xb, const xdot_bin_op *op,
+                     const xdot_op *x) {
+  if (op->kind != x->kind) {
+    return false;
+  }
+  // the flags of xd_fontchar are not a string
+  const char *str = x->kind == xd_fontchar ? NULL : xdotBinString(xb, op->str);
+  switch (x->kind) {
+  case xd_filled_ellipse:
+  case xd_unfilled_ellipse:
+    return rect_equal(xb, op, &x->u.ellipse);
+  case xd_filled_polygon:
+  case xd_unfilled_polygon:
+  case xd_filled_bezier:
+  case xd_unfilled_bezier:
+  case xd_polyline:
+    return points_equal(xb, op, &x->u.polyline);
+  case xd_text:
+    return op->n_points == 2 && near(values(xb, op)[0], x->u.text.x) &&
+           near(values(xb, op)[1], x->u.text.y) &&
+           near(values(xb, op)[2], x->u.text.width) &&
+           op->align == x->u.text.align && strcmp(str, x->u.text.text) == 0;
+  case xd_fill_color:
+  case xd_pen_color:
+    return strcmp(str, x->u.color) == 0;
+  case xd_grad_fill_color:
+  case xd_grad_pen_color: {
+    xdot_color color;
+    if (parseXDotColor((char *)str, &color) == NULL) {
+      return false;
+    }
+    const bool equal = color.type == x->u.grad_color.type;
+    freeXDotColor(&color);
+    return equal;
+  }
+  case xd_font:
+    return op->n_points == 1 && near(values(xb, op)[0], x->u.font.size) &&
+           strcmp(str, x->u.font.name) == 0;
+  case xd_style:
+    return strcmp(str, x->u.style) == 0;
+  case xd_image:
+    return rect_equal(xb, op, &x->u.image.pos) &&
+           strcmp(str, x->u.image.name) == 0;
+  case xd_fontchar:
+    return op->str == x->u.fontchar;
+  default:
+    return false;
+  }
+}
+
+/// number of xdot ops in the attributes of an object
+static size_t count_ops(void *obj) {
+  size_t count = 0;
+  for (size_t i = 0; i < sizeof(stream_attrs) / sizeof(stream_attrs[0]); ++i) {
+    char *value = agget(obj, (char *)stream_attrs[i]);
+    if (value == NULL || *value == '\0') {
+      continue;
+    }
+    xdot *x = parseXDot(value);
+    if (x != NULL) {
+      count += x->cnt;
+      freeXDot(x);
+    }
+  }
+  return count;
+}
+
+static size_t count_subgraph_ops(Agraph_t *g) {
+  size_t count = 0;
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    count += count_ops(sg) + count_subgraph_ops(sg);
+  }
+  return count;
+}
+
+/// check binary xdot against the xdot attributes of a graph
+static bool check(Agraph_t *g, const xdot_bin *xb) {
+  const xdot_bin_header *h = xb->header;
+  for (uint32_t i = 0; i < h->n_objects; ++i) {
+    const xdot_bin_object *o = &xb->objects[i];
+    void *obj = find_object(g, o);
+    if (obj == NULL) {
+      fprintf(stderr, "object %u of kind %d not found\n", o->id, o->kind);
+      return false;
+    }
+    const char *name = xdotBinString(xb, o->name);
+    if (name != NULL && strcmp(name, agnameof(obj)) != 0) {
+      fprintf(stderr, "object %u is named %s, not %s\n", o->id, name,
+              agnameof(obj));
+      return false;
+    }
+    char *value = agget(obj, (char *)stream_attrs[o->stream]);
+    xdot *x = value == NULL ? NULL : parseXDot(value);
+    if (x == NULL || x->cnt != o->n_ops) {
+      fprintf(stderr, "%s of %s: %u ops, expected %zu\n",
+              stream_attrs[o->stream], agnameof(obj), o->n_ops,
+              x == NULL ? 0 : x->cnt);
+      return false;
+    }
+    for (uint32_t j = 0; j < o->n_ops; ++j) {
+      if (!op_equal(xb, &xb->ops[o->first_op + j], &x->ops[j])) {
+        fprintf(stderr, "%s of %s: op %u differs\n", stream_attrs[o->stream],
+                agnameof(obj), j);
+        freeXDot(x);
+        return false;
+      }
+    }
+    freeXDot(x);
+  }
+
+  // nothing drawn should be missing
+  size_t expected = count_ops(g) + count_subgraph_ops(g);
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    expected += count_ops(n);
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      expected += count_ops(e);
+    }
+  }
+  if (expected != h->n_ops) {
+    fprintf(stderr, "%u ops, expected %zu\n", h->n_ops, expected);
+    return false;
+  }
+  return true;
+}
+
+/// parse every xdot attribute of an object, as a client of xdot would
+static double parse_object(void *obj) {
+  double sum = 0;
+  for (size_t i = 0; i < sizeof(stream_attrs) / sizeof(stream_attrs[0]); ++i) {
+    char *value = agget(obj, (char *)stream_attrs[i]);
+    if (value == NULL || *value == '\0') {
+      continue;
+    }
+    xdot *x = parseXDot(value);
+    if (x != NULL) {
+      sum += (double)x->cnt;
+      freeXDot(x);
+    }
+  }
+  return sum;
+}
+
+static double parse_subgraphs(Agraph_t *g) {
+  double sum = 0;
+  for (Agraph_t *sg = agfstsubg(g); sg != NULL; sg = agnxtsubg(sg)) {
+    sum += parse_object(sg) + parse_subgraphs(sg);
+  }
+  return sum;
+}
+
+static double parse_graph(Agraph_t *g) {
+  double sum = parse_object(g) + parse_subgraphs(g);
+  for (Agnode_t *n = agfstnode(g); n != NULL; n = agnxtnode(g, n)) {
+    sum += parse_object(n);
+    for (Agedge_t *e = agfstout(g, n); e != NULL; e = agnxtout(g, e)) {
+      sum += parse_object(e);
+    }
+  }
+  return sum;
+}
+
+/// visit every op of binary xdot, as a client would
+static double read_binary(const char *data, size_t size) {
+  xdot_bin xb;
+  if (xdotBinOpen(&xb, data, size) != 0) {
+    return -1;
+  }
+  double sum = 0;
+  for (uint32_t i = 0; i < xb.header->n_objects; ++i) {
+    const xdot_bin_object *o = &xb.objects[i];
+    for (uint32_t j = 0; j < o->n_ops; ++j) {
+      const xdot_bin_op *op = &xb.ops[o->first_op + j];
+      sum += 1;
+      if (op->kind != xd_fontchar) {
+        (void)xdotBinString(&xb, op->str);
+      }
+    }
+  }
+  return sum;
+}
+
+int main(int argc, char **argv) {
+  const int count = argc > 1 ? atoi(argv[1]) : 10;
+
+  GVC_t *gvc = gvContext();
+  Agraph_t *g = agread(stdin, NULL);
+  if (g == NULL) {
+    fprintf(stderr, "failed to read graph\n");
+    return EXIT_FAILURE;
+  }
+  if (gvLayout(gvc, g, "dot") != 0) {
+    fprintf(stderr, "layout failed\n");
+    return EXIT_FAILURE;
+  }
+
+  char *text;
+  unsigned text_size;
+  char *binary;
+  unsigned binary_size;
+  if (gvRenderData(gvc, g, "xdot", &text, &text_size) != 0 ||
+      gvRenderData(gvc, g, "xdot_bin", &binary, &binary_size) != 0) {
+    fprintf(stderr, "rendering failed\n");
+    return EXIT_FAILURE;
+  }
+
+  xdot_bin xb;
+  if (xdotBinOpen(&xb, binary, binary_size) != 0) {
+    fprintf(stderr, "invalid binary xdot\n");
+    return EXIT_FAILURE;
+  }
+  if (!check(g, &xb)) {
+    return EXIT_FAILURE;
+  }
+
+  // truncated data must be rejected
+  for (unsigned size = 0; size < binary_size; size += 1 + size / 8) {
+    xdot_bin truncated;
+    if (xdotBinOpen(&truncated, binary, size) == 0) {
+      fprintf(stderr, "truncation to %u bytes was not detected\n", size);
+      return EXIT_FAILURE;
+    }
+  }
+
+  clock_t start = clock();
+  double sum = 0;
+  for (int i = 0; i < count; ++i) {
+    sum += parse_graph(g);
+  }
+  const double parse_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  double binary_sum = 0;
+  for (int i = 0; i < count; ++i) {
+    binary_sum += read_binary(binary, binary_size);
+  }
+  const double read_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  if (sum != binary_sum) {
+    fprintf(stderr, "visited %.0f ops in xdot but %.0f in binary xdot\n", sum,
+            binary_sum);
+    return EXIT_FAILURE;
+  }
+
+  printf("%u ops: xdot %u bytes, parsed %d times in %.3fs; "
+         "xdot_bin %u bytes, read %d times in %.3fs\n",
+         xb.header->n_ops, text_size, count, parse_time, binary_size, count,
+         read_time);
+
+  gvFreeRenderData(text);
+  gvFreeRenderData(binary);
+  gvFreeLayout(gvc, g);
+  agclose(g);
+  gvFreeContext(gvc);
+  return EXIT_SUCCESS;
+}
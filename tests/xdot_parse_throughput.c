@@ -0,0 +1,369 @@
+/// \file
+/// \brief benchmark driver for the xdot parsers
+///
+/// Builds the `_draw_` strings of a large synthetic layout, parses them with
+/// `parseXDot`, `parseXDotArena` and `parseXDotArenaMany`, checks all three
+/// agree and that numbers are read exactly as `strtod` reads them, and
+/// reports the throughput of each. The first argument gives the number of
+/// objects and the second the number of threads, 0 for one per processor.
+///
+/// See test_misc.py:test_xdot_parse_throughput
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include <graphviz/xdot.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// a deterministic pseudo-random number generator
+static uint64_t next(uint64_t *state) {
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+/// a growable string
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+} str_t;
+
+static void append(str_t *s, const char *fmt, ...) {
+  for (;;) {
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = vsnprintf(s->data == NULL ? NULL : s->data + s->size,
+                            s->capacity - s->size, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+      fprintf(stderr, "vsnprintf failed\n");
+      exit(EXIT_FAILURE);
+    }
+    if (s->size + (size_t)n < s->capacity) {
+      s->size += (size_t)n;
+      return;
+    }
+    s->capacity = (s->size + (size_t)n + 1) * 2;
+    s->data = realloc(s->data, s->capacity);
+    if (s->data == NULL) {
+      fprintf(stderr, "out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+/// append a length-prefixed xdot string
+static void append_string(str_t *s, const char *text) {
+  append(s, " %zu -%s", strlen(text), text);
+}
+
+/// a number as a layout would print it, or occasionally an awkward one
+static void append_number(str_t *s, uint64_t *state) {
+  static const char *const special[] = {
+      "1e3",   "-2.5E-2",         "0.1",  "-0",   ".5",
+      "5.",    "12345678901234567890.5", "0.000000000000000000000001",
+      "9007199254740993", "1.7976931348623157e308"};
+  const uint64_t r = next(state);
+  if (r % 50 == 0) {
+    append(s, " %s", special[next(state) % (sizeof(special) / sizeof(special[0]))]);
+    return;
+  }
+  const double v = ((double)next(state) / (double)(1ull << 53) - 0.5) * 20000;
+  append(s, " %.*f", (int)(r % 4), v);
+}
+
+/// the `_draw_` string of a node or an edge
+static char *make_draw(uint64_t *state, size_t i) {
+  str_t s = {0};
+  if (i % 2 == 0) { // a node
+    append(&s, "c");
+    append_string(&s, "black");
+    append(&s, " C");
+    append_string(&s, i % 10 == 0 ? "[0 0 100 0 2 0 3 -red 1 4 -blue]"
+                                   : "#ffe4c4");
+    append(&s, " P 4");
+    for (int j = 0; j < 8; ++j) {
+      append_number(&s, state);
+    }
+    append(&s, " e");
+    for (int j = 0; j < 4; ++j) {
+      append_number(&s, state);
+    }
+    append(&s, " F 14");
+    append_string(&s, "Times-Roman");
+    append(&s, " T");
+    append_number(&s, state);
+    append_number(&s, state);
+    append(&s, " 0");
+    append_number(&s, state);
+    char label[32];
+    snprintf(label, sizeof(label), "node \\\\%zu", i);
+    append_string(&s, label);
+  } else { // an edge
+    append(&s, "S");
+    append_string(&s, "dashed");
+    append(&s, " c");
+    append_string(&s, "black");
+    const int n = 4 + 3 * (int)(next(state) % 4);
+    append(&s, " B %d", n);
+    for (int j = 0; j < 2 * n; ++j) {
+      append_number(&s, state);
+    }
+  }
+  return s.data;
+}
+
+static bool same_string(const char *a, const char *b) {
+  return strcmp(a, b) == 0;
+}
+
+static bool same_polyline(const xdot_polyline *a, const xdot_polyline *b) {
+  if (a->cnt != b->cnt) {
+    return false;
+  }
+  for (size_t i = 0; i < a->cnt; ++i) {
+    if (a->pts[i].x != b->pts[i].x || a->pts[i].y != b->pts[i].y ||
+        a->pts[i].z != b->pts[i].z) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool same_stops(int n, const xdot_color_stop *a,
+                       const xdot_color_stop *b) {
+  for (int i = 0; i < n; ++i) {
+    if (a[i].frac != b[i].frac || !same_string(a[i].color, b[i].color)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool same_color(const xdot_color *a, const xdot_color *b) {
+  if (a->type != b->type) {
+    return false;
+  }
+  switch (a->type) {
+  case xd_linear: {
+    const xdot_linear_grad *p = &a->u.ling, *q = &b->u.ling;
+    return p->x0 == q->x0 && p->y0 == q->y0 && p->x1 == q->x1 &&
+           p->y1 == q->y1 && p->n_stops == q->n_stops &&
+           same_stops(p->n_stops, p->stops, q->stops);
+  }
+  case xd_radial: {
+    const xdot_radial_grad *p = &a->u.ring, *q = &b->u.ring;
+    return p->x0 == q->x0 && p->y0 == q->y0 && p->r0 == q->r0 &&
+           p->x1 == q->x1 && p->y1 == q->y1 && p->r1 == q->r1 &&
+           p->n_stops == q->n_stops &&
+           same_stops(p->n_stops, p->stops, q->stops);
+  }
+  default:
+    return same_string(a->u.clr, b->u.clr);
+  }
+}
+
+static bool same_rect(const xdot_rect *a, const xdot_rect *b) {
+  return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h;
+}
+
+/// do two parses give the same ops?
+static bool same_xdot(const xdot *a, const xdot *b) {
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  if (a->cnt != b->cnt || a->flags != b->flags) {
+    return false;
+  }
+  for (size_t i = 0; i < a->cnt; ++i) {
+    const xdot_op *p = &a->ops[i], *q = &b->ops[i];
+    if (p->kind != q->kind) {
+      return false;
+    }
+    bool same = true;
+    switch (p->kind) {
+    case xd_filled_ellipse:
+    case xd_unfilled_ellipse:
+      same = same_rect(&p->u.ellipse, &q->u.ellipse);
+      break;
+    case xd_filled_polygon:
+    case xd_unfilled_polygon:
+    case xd_filled_bezier:
+    case xd_unfilled_bezier:
+    case xd_polyline:
+      same = same_polyline(&p->u.polyline, &q->u.polyline);
+      break;
+    case xd_text:
+      same = p->u.text.x == q->u.text.x && p->u.text.y == q->u.text.y &&
+             p->u.text.align == q->u.text.align &&
+             p->u.text.width == q->u.text.width &&
+             same_string(p->u.text.text, q->u.text.text);
+      break;
+    case xd_fill_color:
+    case xd_pen_color:
+      same = same_string(p->u.color, q->u.color);
+      break;
+    case xd_grad_fill_color:
+    case xd_grad_pen_color:
+      same = same_color(&p->u.grad_color, &q->u.grad_color);
+      break;
+    case xd_font:
+      same = p->u.font.size == q->u.font.size &&
+             same_string(p->u.font.name, q->u.font.name);
+      break;
+    case xd_style:
+      same = same_string(p->u.style, q->u.style);
+      break;
+    default:
+      break;
+    }
+    if (!same) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// are the numbers of a bezier or polygon op what `strtod` makes of them?
+static bool exact_numbers(const char *draw, const xdot *x) {
+  const char *p = strstr(draw, " B ");
+  if (p == NULL) {
+    p = strstr(draw, " P ");
+  }
+  if (p == NULL) {
+    return true;
+  }
+  char *end;
+  const size_t n = strtoul(p + 3, &end, 10);
+  for (size_t i = 0; i < x->cnt; ++i) {
+    const xdot_op *op = &x->ops[i];
+    if (op->kind != xd_unfilled_bezier && op->kind != xd_filled_polygon) {
+      continue;
+    }
+    if (op->u.polyline.cnt != n) {
+      return false;
+    }
+    for (size_t j = 0; j < n; ++j) {
+      if (op->u.polyline.pts[j].x != strtod(end, &end) ||
+          op->u.polyline.pts[j].y != strtod(end, &end)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+/// wall clock time
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, size_t bytes, double elapsed) {
+  printf("%-20s %.3fs", name, elapsed);
+  if (elapsed > 0) {
+    printf(", %.1f MB/s", (double)bytes / elapsed / 1e6);
+  }
+  printf("\n");
+}
+
+/// how to parse all the inputs
+typedef enum { PLAIN, ARENA, MANY } method_t;
+
+/// parse and free all inputs a few times, reporting the best times
+static void time_parse(method_t method, char **draw, size_t n, size_t bytes,
+                       xdot **results, int threads) {
+  static const char *const names[] = {"parseXDot", "parseXDotArena",
+                                      "parseXDotArenaMany"};
+  enum { REPETITIONS = 5 };
+  double parse = 1e300;
+  double release = 1e300;
+  for (int r = 0; r < REPETITIONS; ++r) {
+    double start = now();
+    if (method == MANY) {
+      parseXDotArenaMany(draw, n, NULL, 0, results, threads);
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        results[i] = method == ARENA ? parseXDotArena(draw[i], NULL, 0, NULL)
+                                     : parseXDot(draw[i]);
+      }
+    }
+    const double elapsed = now() - start;
+    parse = elapsed < parse ? elapsed : parse;
+    if (r + 1 == REPETITIONS) { // keep the last results
+      break;
+    }
+    start = now();
+    for (size_t i = 0; i < n; ++i) {
+      freeXDot(results[i]);
+    }
+    release = now() - start < release ? now() - start : release;
+  }
+  report(names[method], bytes, parse);
+  printf("%-20s %.3fs\n", "  freeXDot", release);
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  const int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+  char **draw = calloc(n, sizeof(draw[0]));
+  xdot **expected = calloc(n, sizeof(expected[0]));
+  xdot **results = calloc(n, sizeof(results[0]));
+  if (draw == NULL || expected == NULL || results == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return EXIT_FAILURE;
+  }
+  uint64_t state = 42;
+  size_t bytes = 0;
+  for (size_t i = 0; i < n; ++i) {
+    draw[i] = make_draw(&state, i);
+    bytes += strlen(draw[i]);
+  }
+
+  time_parse(PLAIN, draw, n, bytes, expected, threads);
+  for (method_t m = ARENA; m <= MANY; ++m) {
+    time_parse(m, draw, n, bytes, results, threads);
+    for (size_t i = 0; i < n; ++i) {
+      if (expected[i] == NULL || !same_xdot(expected[i], results[i])) {
+        fprintf(stderr, "parse differs on %s\n", draw[i]);
+        return EXIT_FAILURE;
+      }
+      if (!exact_numbers(draw[i], results[i])) {
+        fprintf(stderr, "inexact numbers in %s\n", draw[i]);
+        return EXIT_FAILURE;
+      }
+      freeXDot(results[i]);
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    freeXDot(expected[i]);
+    free(draw[i]);
+  }
+
+  // appending to an xdot keeps to how it was first parsed
+  char *parts[] = {"c 5 -black e 1 2 3 4", "T 1 2 0 3 5 -hello"};
+  xdot *a = parseXDotArena(parts[0], NULL, 0, NULL);
+  a = parseXDotFOn(parts[1], NULL, 0, a);
+  xdot *b = parseXDot(parts[0]);
+  b = parseXDotArena(parts[1], NULL, 0, b);
+  if (a == NULL || b == NULL || a->arena == NULL || b->arena != NULL ||
+      !same_xdot(a, b) || a->cnt != 3) {
+    fprintf(stderr, "appending parses differ\n");
+    return EXIT_FAILURE;
+  }
+  freeXDot(a);
+  freeXDot(b);
+
+  free(results);
+  free(expected);
+  free(draw);
+  return EXIT_SUCCESS;
+}